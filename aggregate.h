@@ -0,0 +1,466 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "fingerprint.h"
+#include "query.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+namespace porter::attr::aggregate {
+namespace traits {
+
+
+/// Template that defines the type a grouping or distinct value of an attribute is kept as.
+/// String values are kept as views into the aggregated collections, other values are copied.
+template<typename Tag, typename V = typename Tag::type>
+struct key
+{
+    using type = std::conditional_t<
+        std::is_convertible_v<const V &, std::string_view> && !attr::traits::is_interned_v<V>,
+        std::string_view,
+        V>;
+};
+
+/// Helper alias for the type a grouping or distinct value of an attribute is kept as.
+template<typename Tag> using key_t = typename key<Tag>::type;
+
+/// Template that defines the type a numeric attribute is summed as.
+template<typename V>
+struct sum
+{
+    static_assert(std::is_arithmetic_v<V>, "Only numeric attributes can be summed");
+
+    using type = std::conditional_t<
+        std::is_floating_point_v<V>,
+        double,
+        std::conditional_t<std::is_signed_v<V>, int64_t, uint64_t>>;
+};
+
+/// Helper alias for the type a numeric attribute is summed as.
+template<typename V> using sum_t = typename sum<V>::type;
+
+
+} // namespace traits
+
+
+/// Defines parallel execution options.
+struct Options
+{
+    /// Maximum number of threads, zero for the number of hardware threads.
+    size_t threads = 0;
+
+    /// Number of rows a thread claims at once.
+    size_t grain = 4096;
+};
+
+
+/// Defines hash of grouping keys: tuples of optional attribute values.
+struct KeyHash
+{
+    /// Compute hash of a grouping key.
+    /// @tparam Vs attribute value types.
+    /// @param key grouping key.
+    /// @return key hash.
+    template<typename... Vs>
+    size_t operator()(const std::tuple<std::optional<Vs>...> &key) const;
+
+    /// Compute hash of a single value.
+    /// @tparam V attribute value type.
+    /// @param value attribute value.
+    /// @return value hash.
+    template<typename V>
+    size_t operator()(const V &value) const;
+};
+
+
+/// Defines aggregate that counts rows.
+struct Count
+{
+    /// Stores number of rows.
+    uint64_t value = 0;
+
+    /// Add a row.
+    template<typename Row>
+    void add(const Row &);
+
+    /// Add rows of another partial aggregate.
+    void merge(Count &&other);
+};
+
+/// Defines aggregate that sums values of a numeric attribute, skipping rows without the value.
+/// @tparam Tag attribute tag type.
+template<typename Tag>
+struct Sum
+{
+    /// Stores sum of values.
+    traits::sum_t<typename Tag::type> value {};
+
+    /// Add a row.
+    template<typename Row>
+    void add(const Row &row);
+
+    /// Add rows of another partial aggregate.
+    void merge(Sum<Tag> &&other);
+};
+
+/// Defines aggregate that collects distinct values of an attribute, skipping rows without the value.
+/// String values refer to the aggregated collections.
+/// @tparam Tag attribute tag type.
+template<typename Tag>
+struct Distinct
+{
+    /// Stores distinct values.
+    std::unordered_set<traits::key_t<Tag>, KeyHash> values;
+
+    /// Add a row.
+    template<typename Row>
+    void add(const Row &row);
+
+    /// Add rows of another partial aggregate.
+    void merge(Distinct<Tag> &&other);
+
+    /// Get number of distinct values.
+    size_t size() const;
+};
+
+
+/// Defines groups of rows: grouping keys to aggregates.
+/// @tparam Agg aggregate type.
+/// @tparam Tags attribute tag types of the grouping key.
+template<typename Agg, typename... Tags>
+using groups_t = std::unordered_map<std::tuple<std::optional<traits::key_t<Tags>>...>, Agg, KeyHash>;
+
+/// Defines the most frequent names of an associative attribute with their number of rows, most frequent first.
+using top_t = std::vector<std::pair<std::string_view, uint64_t>>;
+
+
+/// Get a grouping value of a row.
+/// @tparam Tag attribute tag type.
+/// @tparam Row row type: a collection or a view of a collection batch row.
+/// @param row row.
+/// @return attribute value or std::nullopt if not set.
+template<typename Tag, typename Row>
+std::optional<traits::key_t<Tag>> value_of(const Row &row, Tag);
+
+/// Reduce rows of a range in parallel.
+/// Each thread accumulates rows of the chunks it claims into its own partial result,
+/// so accumulation doesn't synchronize; partial results are merged when all rows are accumulated.
+/// @tparam Range range type with size() and operator[], e.g. vector of collections or a collection batch.
+/// @tparam Partial partial result type.
+/// @tparam Accumulate accumulation function type, called with a partial result and a row; must not throw.
+/// @tparam Merge merge function type, called with a partial result and another one to merge into it.
+/// @param range rows to reduce.
+/// @param init initial partial result of every thread.
+/// @param accumulate accumulation function.
+/// @param merge merge function.
+/// @param options execution options.
+/// @return reduced result.
+template<typename Range, typename Partial, typename Accumulate, typename Merge>
+Partial reduce(
+    const Range &range,
+    const Partial &init,
+    const Accumulate &accumulate,
+    const Merge &merge,
+    const Options &options = {});
+
+/// Aggregate all rows of a range in parallel.
+/// @tparam Range range type with size() and operator[].
+/// @tparam Agg aggregate type, with add(row) and merge(Agg &&).
+/// @param range rows to aggregate.
+/// @param agg initial aggregate.
+/// @param options execution options.
+/// @return aggregate of all rows.
+template<typename Range, typename Agg>
+Agg total(const Range &range, const Agg &agg, const Options &options = {});
+
+/// Group rows of a range by values of single attributes and aggregate each group in parallel.
+/// Rows without a value are grouped under std::nullopt; string values of keys refer to the range.
+/// @tparam Range range type with size() and operator[].
+/// @tparam Agg aggregate type, with add(row) and merge(Agg &&).
+/// @tparam Tags attribute tag types of the grouping key.
+/// @param range rows to group.
+/// @param agg initial aggregate of every group.
+/// @param options execution options.
+/// @return groups.
+template<typename Range, typename Agg, typename... Tags>
+groups_t<Agg, Tags...> group_by(const Range &range, const Agg &agg, const Options &options, Tags...);
+
+/// Group rows of a range by values of single attributes and aggregate each group in parallel.
+/// @tparam Range range type with size() and operator[].
+/// @tparam Agg aggregate type, with add(row) and merge(Agg &&).
+/// @tparam Tags attribute tag types of the grouping key.
+/// @param range rows to group.
+/// @param agg initial aggregate of every group.
+/// @return groups.
+template<
+    typename Range,
+    typename Agg,
+    typename... Tags,
+    typename = std::enable_if_t<(sizeof...(Tags) > 0 && (attr::traits::is_tag_valid_v<Tags> && ...))>>
+groups_t<Agg, Tags...> group_by(const Range &range, const Agg &agg, Tags...);
+
+/// Find the most frequent names of an associative attribute (i.e. Multiple holder) in parallel.
+/// Names refer to the range; ties are ordered by name.
+/// @tparam Range range type with size() and operator[].
+/// @tparam Tag attribute tag type.
+/// @param range rows to scan.
+/// @param k maximum number of names.
+/// @param options execution options.
+/// @return names with their number of rows, most frequent first.
+template<typename Range, typename Tag>
+top_t top_keys(const Range &range, Tag, size_t k, const Options &options = {});
+
+
+
+template<typename... Vs>
+size_t KeyHash::operator()(const std::tuple<std::optional<Vs>...> &key) const
+{
+    uint64_t hash = 0;
+    std::apply([&](const auto &...values) {
+        ((hash = mix(hash + (values ? hash_value(*values) : 0x9e3779b97f4a7c15ull))), ...);
+    }, key);
+
+    return size_t(hash);
+}
+
+template<typename V>
+size_t KeyHash::operator()(const V &value) const
+{
+    return size_t(mix(hash_value(value)));
+}
+
+
+template<typename Row>
+void Count::add(const Row &)
+{
+    ++value;
+}
+
+inline void Count::merge(Count &&other)
+{
+    value += other.value;
+}
+
+template<typename Tag>
+template<typename Row>
+void Sum<Tag>::add(const Row &row)
+{
+    if (const auto item = value_of(row, Tag {}))
+    {
+        value += *item;
+    }
+}
+
+template<typename Tag>
+void Sum<Tag>::merge(Sum<Tag> &&other)
+{
+    value += other.value;
+}
+
+template<typename Tag>
+template<typename Row>
+void Distinct<Tag>::add(const Row &row)
+{
+    if (auto item = value_of(row, Tag {}))
+    {
+        values.insert(std::move(*item));
+    }
+}
+
+template<typename Tag>
+void Distinct<Tag>::merge(Distinct<Tag> &&other)
+{
+    if (values.size() < other.values.size())
+    {
+        std::swap(values, other.values);
+    }
+
+    values.merge(other.values);
+}
+
+template<typename Tag>
+size_t Distinct<Tag>::size() const
+{
+    return values.size();
+}
+
+
+template<typename Tag, typename Row>
+std::optional<traits::key_t<Tag>> value_of(const Row &row, Tag)
+{
+    const auto *value = query::get(row(Tag {}));
+    return value ? std::make_optional(traits::key_t<Tag>(*value)) : std::nullopt;
+}
+
+template<typename Range, typename Partial, typename Accumulate, typename Merge>
+Partial reduce(
+    const Range &range,
+    const Partial &init,
+    const Accumulate &accumulate,
+    const Merge &merge,
+    const Options &options)
+{
+    /// Keeps partial results of threads on separate cache lines.
+    struct alignas(64) Slot
+    {
+        Partial value;
+    };
+
+    const size_t size = range.size();
+    const size_t grain = std::max<size_t>(options.grain, 1);
+    const size_t chunks = (size + grain - 1) / grain;
+
+    size_t threads = options.threads ? options.threads : std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    threads = std::min(threads, chunks);
+
+    if (threads <= 1)
+    {
+        Partial result = init;
+        for (size_t row = 0; row < size; ++row)
+        {
+            accumulate(result, range[row]);
+        }
+
+        return result;
+    }
+
+    std::vector<Slot> partials(threads, Slot {init});
+    std::atomic<size_t> next {0};
+
+    auto work = [&](Partial &partial) {
+        for (size_t chunk = next.fetch_add(1, std::memory_order_relaxed);
+             chunk < chunks;
+             chunk = next.fetch_add(1, std::memory_order_relaxed))
+        {
+            const size_t end = std::min(size, (chunk + 1) * grain);
+            for (size_t row = chunk * grain; row < end; ++row)
+            {
+                accumulate(partial, range[row]);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t idx = 1; idx < threads; ++idx)
+    {
+        workers.emplace_back(work, std::ref(partials[idx].value));
+    }
+
+    work(partials[0].value);
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    for (size_t idx = 1; idx < threads; ++idx)
+    {
+        merge(partials[0].value, std::move(partials[idx].value));
+    }
+
+    return std::move(partials[0].value);
+}
+
+template<typename Range, typename Agg>
+Agg total(const Range &range, const Agg &agg, const Options &options)
+{
+    return reduce(
+        range,
+        agg,
+        [](Agg &partial, const auto &row) { partial.add(row); },
+        [](Agg &partial, Agg &&other) { partial.merge(std::move(other)); },
+        options);
+}
+
+template<typename Range, typename Agg, typename... Tags>
+groups_t<Agg, Tags...> group_by(const Range &range, const Agg &agg, const Options &options, Tags...)
+{
+    using Groups = groups_t<Agg, Tags...>;
+
+    return reduce(
+        range,
+        Groups {},
+        [&agg](Groups &partial, const auto &row) {
+            partial.try_emplace(std::make_tuple(value_of(row, Tags {})...), agg).first->second.add(row);
+        },
+        [](Groups &partial, Groups &&other) {
+            if (partial.size() < other.size())
+            {
+                std::swap(partial, other);
+            }
+
+            for (auto &[key, group] : other)
+            {
+                auto [it, inserted] = partial.try_emplace(key, std::move(group));
+                if (!inserted)
+                {
+                    it->second.merge(std::move(group));
+                }
+            }
+        },
+        options);
+}
+
+template<typename Range, typename Agg, typename... Tags, typename>
+groups_t<Agg, Tags...> group_by(const Range &range, const Agg &agg, Tags... tags)
+{
+    return group_by(range, agg, Options {}, tags...);
+}
+
+template<typename Range, typename Tag>
+top_t top_keys(const Range &range, Tag, size_t k, const Options &options)
+{
+    using Counts = std::unordered_map<std::string_view, uint64_t>;
+
+    Counts counts = reduce(
+        range,
+        Counts {},
+        [](Counts &partial, const auto &row) {
+            for (const auto &entry : row(Tag {}))
+            {
+                ++partial[std::string_view(entry.first)];
+            }
+        },
+        [](Counts &partial, Counts &&other) {
+            if (partial.size() < other.size())
+            {
+                std::swap(partial, other);
+            }
+
+            for (const auto &[key, count] : other)
+            {
+                partial[key] += count;
+            }
+        },
+        options);
+
+    top_t top(counts.begin(), counts.end());
+    auto more = [](const auto &lhs, const auto &rhs) {
+        return lhs.second != rhs.second ? lhs.second > rhs.second : lhs.first < rhs.first;
+    };
+
+    k = std::min(k, top.size());
+    std::partial_sort(top.begin(), top.begin() + k, top.end(), more);
+    top.resize(k);
+
+    return top;
+}
+
+
+} // namespace porter::attr::aggregate
@@ -0,0 +1,636 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "key.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+
+namespace porter::attr {
+
+
+/// Defines a type-erased attribute value: integers are widened, enumerations are read as their underlying type,
+/// strings are read as views into the collection.
+using AnyValue = std::variant<bool, int64_t, uint64_t, double, std::string_view>;
+
+/// Defines a type-erased attribute value visited by AnyCollection::for_each.
+struct AnyAttribute
+{
+    /// Attribute tag name.
+    std::string_view name;
+
+    /// Attribute value name of associative attributes (i.e. Multiple holder), empty otherwise.
+    std::string_view key;
+
+    /// Attribute value.
+    AnyValue value;
+};
+
+
+namespace traits {
+
+
+/// Template that checks whether an attribute value type can be converted into AnyValue.
+template<typename V, typename = void> struct is_erasable : std::false_type {};
+
+/// Defines the check for arithmetic, enumeration and string values.
+template<typename V>
+struct is_erasable<V, std::enable_if_t<
+    std::is_arithmetic_v<V> || std::is_enum_v<V> || std::is_convertible_v<const V &, std::string_view>>>
+    : std::true_type
+{
+};
+
+/// Helper variable for checking whether an attribute value type can be converted into AnyValue.
+template<typename V> inline constexpr bool is_erasable_v = is_erasable<V>::value;
+
+
+/// Template that checks whether all attribute values and names of a holder can be converted into AnyValue.
+template<typename H, typename = void> struct is_holder_erasable : is_erasable<typename H::value_type> {};
+
+/// Defines the check for associative holders, which also requires names to be convertible into std::string_view.
+template<typename H>
+struct is_holder_erasable<H, std::void_t<typename H::key_type>>
+    : std::bool_constant<
+        is_erasable_v<typename H::value_type> && std::is_convertible_v<const typename H::key_type &, std::string_view>>
+{
+};
+
+
+/// Template that defines a tuple of tag types of a type parameterized by a pack of holders.
+template<typename T> struct tags_of;
+
+/// Defines the tuple for variadic templates.
+template<template<typename...> typename T, typename... Hs> struct tags_of<T<Hs...>>
+{
+    using type = std::tuple<tag_of_t<Hs>...>;
+};
+
+
+/// Defines identity of a type without RTTI: its compiler-generated name and the name hash.
+/// Names are compared by contents, so identities match across shared objects, unlike addresses of per-type variables.
+struct TypeKey
+{
+    /// Type name, as spelled by the compiler.
+    std::string_view name;
+
+    /// Type name hash (see hash_name), compared first.
+    size_t hash;
+
+    /// Compare type identities.
+    friend constexpr bool operator==(const TypeKey &lhs, const TypeKey &rhs)
+    {
+        return lhs.hash == rhs.hash && lhs.name == rhs.name;
+    }
+
+    /// Compare type identities.
+    friend constexpr bool operator!=(const TypeKey &lhs, const TypeKey &rhs) { return !(lhs == rhs); }
+};
+
+/// Template that identifies a type without RTTI by its compiler-generated name.
+template<typename T> struct type_key
+{
+    /// Get the name of this function, which spells out T.
+    static constexpr std::string_view name() { return __PRETTY_FUNCTION__; }
+
+    /// Defines type identity.
+    static constexpr TypeKey value {name(), hash_name(name())};
+};
+
+
+} // namespace traits
+
+
+/// Convert an attribute value into type-erased one.
+/// @tparam V attribute value type.
+/// @param value attribute value.
+/// @return type-erased attribute value.
+template<typename V>
+AnyValue to_any(const V &value);
+
+
+/// Defines a type-erased collection, that wraps any Collection without exposing its holder types.
+/// Attribute values are looked up by tag name and read as AnyValue.
+/// Collections up to Capacity bytes are stored inline, larger ones are allocated on the heap.
+/// @tparam Capacity inline storage size.
+template<size_t Capacity = 192>
+class BasicAnyCollection
+{
+    /// Defines inline storage, or the pointer to heap allocated collection.
+    struct Storage
+    {
+        alignas(std::max_align_t) unsigned char bytes[Capacity];
+    };
+
+    /// Defines operations on the wrapped collection.
+    struct VTable
+    {
+        /// Type key of the wrapped collection.
+        traits::TypeKey type;
+
+        /// Type key of the canonical form of the wrapped collection (see traits::canonical_t).
+        traits::TypeKey canonical;
+
+        /// Copy-construct a collection into empty storage.
+        void (*copy)(const Storage &from, Storage &to);
+
+        /// Move-construct a collection into empty storage, leaving source storage empty.
+        void (*move)(Storage &from, Storage &to) noexcept;
+
+        /// Destroy the collection.
+        void (*destroy)(Storage &storage) noexcept;
+
+        /// Get the collection address.
+        void *(*get)(const Storage &storage) noexcept;
+
+        /// Copy or move the collection into its canonical form, constructed at the provided address.
+        void (*canonical_into)(void *collection, bool move, void *out);
+
+        /// Check whether all required attribute values are set.
+        bool (*ready)(const void *collection);
+
+        /// Look up an attribute value by tag name.
+        std::optional<AnyValue> (*find)(const void *collection, std::string_view name);
+
+        /// Look up a named attribute value of an associative attribute by tag name.
+        std::optional<AnyValue> (*find_key)(const void *collection, std::string_view name, std::string_view key);
+
+        /// Visit all set attribute values.
+        void (*for_each)(const void *collection, void *context, void (*visit)(void *, const AnyAttribute &));
+    };
+
+    /// Template that defines operations on a collection type.
+    template<typename C, bool Inline = sizeof(C) <= Capacity && alignof(C) <= alignof(Storage)
+        && std::is_nothrow_move_constructible_v<C>>
+    struct Model
+    {
+        /// Whether the collection is stored inline.
+        static constexpr bool is_inline = Inline;
+
+        /// Operations on the collection.
+        static const VTable vtable;
+    };
+
+    /// Stores the collection or the pointer to it.
+    Storage d_storage;
+
+    /// Stores operations on the collection, nullptr if empty.
+    const VTable *d_vtable = nullptr;
+
+private:
+    /// Get the wrapped collection.
+    /// @tparam C collection type.
+    template<typename C>
+    C *get() const;
+
+    /// Copy or move the wrapped collection into a concrete one, if they have the same holders.
+    /// @tparam C collection type.
+    /// @param move whether to move the wrapped collection.
+    template<typename C>
+    std::optional<C> convert(bool move) const;
+
+public:
+    /// Construct an empty collection.
+    BasicAnyCollection() = default;
+
+    /// Wrap (copy or move) a collection.
+    /// @tparam Holders attribute holder types.
+    /// @param collection collection to wrap.
+    template<typename... Holders>
+    BasicAnyCollection(const Collection<Holders...> &collection);
+
+    /// Wrap (move) a collection.
+    /// @tparam Holders attribute holder types.
+    /// @param collection collection to wrap.
+    template<typename... Holders>
+    BasicAnyCollection(Collection<Holders...> &&collection);
+
+    /// Copy ctor.
+    BasicAnyCollection(const BasicAnyCollection &other);
+
+    /// Move ctor.
+    BasicAnyCollection(BasicAnyCollection &&other) noexcept;
+
+    /// Copy assignment.
+    BasicAnyCollection &operator=(const BasicAnyCollection &other);
+
+    /// Move assignment.
+    BasicAnyCollection &operator=(BasicAnyCollection &&other) noexcept;
+
+    /// Dtor.
+    ~BasicAnyCollection();
+
+    /// Check whether a collection is wrapped.
+    bool has_value() const;
+
+    /// Checks whether all required attribute values of the wrapped collection are set.
+    /// @return false if empty or some required attribute value is not set.
+    operator bool() const;
+
+    /// Get attribute value by tag name.
+    /// @param name attribute tag name.
+    /// @return attribute value or std::nullopt, if not set or not found.
+    std::optional<AnyValue> operator()(std::string_view name) const;
+
+    /// Get named attribute value of associative attributes (i.e. Multiple holder) by tag name.
+    /// @param name attribute tag name.
+    /// @param key attribute value name.
+    /// @return attribute value or std::nullopt, if not set or not found.
+    std::optional<AnyValue> operator()(std::string_view name, std::string_view key) const;
+
+    /// Call a function with every set attribute value, in holder declaration order.
+    /// @tparam F function type, callable with const AnyAttribute &.
+    /// @param function function to call.
+    template<typename F>
+    void for_each(F &&function) const;
+
+    /// Get the wrapped collection, if it has the provided type.
+    /// @tparam C collection type.
+    /// @return pointer to the collection or nullptr.
+    template<typename C>
+    const C *get_if() const;
+
+    /// Copy the wrapped collection into a concrete one, if they have the same holders (in any order).
+    /// @tparam C collection type.
+    /// @return collection or std::nullopt.
+    template<typename C>
+    std::optional<C> collection() const &;
+
+    /// Move the wrapped collection into a concrete one, if they have the same holders (in any order).
+    /// @tparam C collection type.
+    /// @return collection or std::nullopt.
+    template<typename C>
+    std::optional<C> collection() &&;
+};
+
+/// Defines a type-erased collection with default inline storage size.
+using AnyCollection = BasicAnyCollection<>;
+
+
+
+template<typename V>
+AnyValue to_any(const V &value)
+{
+    static_assert(traits::is_erasable_v<V>, "Attribute value type is not convertible into AnyValue");
+
+    if constexpr (std::is_same_v<V, bool>)
+    {
+        return value;
+    }
+    else if constexpr (std::is_enum_v<V>)
+    {
+        return to_any(static_cast<std::underlying_type_t<V>>(value));
+    }
+    else if constexpr (std::is_integral_v<V> && std::is_signed_v<V>)
+    {
+        return int64_t(value);
+    }
+    else if constexpr (std::is_integral_v<V>)
+    {
+        return uint64_t(value);
+    }
+    else if constexpr (std::is_floating_point_v<V>)
+    {
+        return double(value);
+    }
+    else
+    {
+        return std::string_view(value);
+    }
+}
+
+
+template<size_t Capacity>
+template<typename C, bool Inline>
+const typename BasicAnyCollection<Capacity>::VTable BasicAnyCollection<Capacity>::Model<C, Inline>::vtable = {
+    traits::type_key<C>::value,
+    traits::type_key<traits::canonical_t<C>>::value,
+
+    [](const Storage &from, Storage &to) {
+        if constexpr (Inline)
+        {
+            ::new (&to) C(*std::launder(reinterpret_cast<const C *>(&from)));
+        }
+        else
+        {
+            ::new (&to) C *(new C(**std::launder(reinterpret_cast<C *const *>(&from))));
+        }
+    },
+
+    [](Storage &from, Storage &to) noexcept {
+        if constexpr (Inline)
+        {
+            C &source = *std::launder(reinterpret_cast<C *>(&from));
+            ::new (&to) C(std::move(source));
+            source.~C();
+        }
+        else
+        {
+            ::new (&to) C *(*std::launder(reinterpret_cast<C **>(&from)));
+        }
+    },
+
+    [](Storage &storage) noexcept {
+        if constexpr (Inline)
+        {
+            std::launder(reinterpret_cast<C *>(&storage))->~C();
+        }
+        else
+        {
+            delete *std::launder(reinterpret_cast<C **>(&storage));
+        }
+    },
+
+    [](const Storage &storage) noexcept -> void * {
+        if constexpr (Inline)
+        {
+            return const_cast<C *>(std::launder(reinterpret_cast<const C *>(&storage)));
+        }
+        else
+        {
+            return *std::launder(reinterpret_cast<C *const *>(&storage));
+        }
+    },
+
+    [](void *collection, bool move, void *out) {
+        C &source = *static_cast<C *>(collection);
+        if (move)
+        {
+            ::new (out) traits::canonical_t<C>(std::move(source));
+        }
+        else
+        {
+            ::new (out) traits::canonical_t<C>(source);
+        }
+    },
+
+    [](const void *collection) -> bool {
+        return bool(*static_cast<const C *>(collection));
+    },
+
+    [](const void *collection, std::string_view name) -> std::optional<AnyValue> {
+        std::optional<AnyValue> found;
+
+        auto find = [&](auto tag) {
+            using Tag = decltype(tag);
+
+            if constexpr (!traits::is_multiple_v<traits::find_tag_t<Tag, C>>)
+            {
+                if (!found && Tag::value == name)
+                {
+                    if (const auto &value = (*static_cast<const C *>(collection))(tag))
+                    {
+                        found = to_any(*value);
+                    }
+                }
+            }
+        };
+        std::apply([&](auto... tags) { (find(tags), ...); }, typename traits::tags_of<C>::type {});
+
+        return found;
+    },
+
+    [](const void *collection, std::string_view name, std::string_view key) -> std::optional<AnyValue> {
+        std::optional<AnyValue> found;
+
+        auto find = [&](auto tag) {
+            using Tag = decltype(tag);
+
+            if constexpr (traits::is_multiple_v<traits::find_tag_t<Tag, C>>)
+            {
+                if (!found && Tag::value == name)
+                {
+                    if (auto value = (*static_cast<const C *>(collection))(tag, key))
+                    {
+                        found = to_any(value->get());
+                    }
+                }
+            }
+        };
+        std::apply([&](auto... tags) { (find(tags), ...); }, typename traits::tags_of<C>::type {});
+
+        return found;
+    },
+
+    [](const void *collection, void *context, void (*visit)(void *, const AnyAttribute &)) {
+        const C &source = *static_cast<const C *>(collection);
+
+        auto each = [&](auto tag) {
+            using Tag = decltype(tag);
+            using H = traits::find_tag_t<Tag, C>;
+
+            if constexpr (traits::is_multiple_v<H>)
+            {
+                for (const auto &[key, value] : *source.template holder<H>())
+                {
+                    visit(context, AnyAttribute {Tag::value, key, to_any(value)});
+                }
+            }
+            else if (const auto &value = source(tag))
+            {
+                visit(context, AnyAttribute {Tag::value, {}, to_any(*value)});
+            }
+        };
+        std::apply([&](auto... tags) { (each(tags), ...); }, typename traits::tags_of<C>::type {});
+    },
+};
+
+
+template<size_t Capacity>
+template<typename C>
+C *BasicAnyCollection<Capacity>::get() const
+{
+    return static_cast<C *>(d_vtable->get(d_storage));
+}
+
+template<size_t Capacity>
+template<typename C>
+std::optional<C> BasicAnyCollection<Capacity>::convert(bool move) const
+{
+    using Canonical = traits::canonical_t<C>;
+
+    if (!d_vtable || d_vtable->canonical != traits::type_key<Canonical>::value)
+    {
+        return std::nullopt;
+    }
+
+    alignas(Canonical) unsigned char buffer[sizeof(Canonical)];
+    d_vtable->canonical_into(get<void>(), move, buffer);
+
+    Canonical &canonical = *std::launder(reinterpret_cast<Canonical *>(buffer));
+    std::optional<C> result {C {std::move(canonical)}};
+    canonical.~Canonical();
+
+    return result;
+}
+
+template<size_t Capacity>
+template<typename... Holders>
+BasicAnyCollection<Capacity>::BasicAnyCollection(const Collection<Holders...> &collection)
+    : BasicAnyCollection(Collection<Holders...> {collection})
+{
+}
+
+template<size_t Capacity>
+template<typename... Holders>
+BasicAnyCollection<Capacity>::BasicAnyCollection(Collection<Holders...> &&collection)
+{
+    using C = Collection<Holders...>;
+    using M = Model<C>;
+
+    static_assert(
+        (traits::is_holder_erasable<Holders>::value && ...),
+        "One or more attribute value types are not convertible into AnyValue");
+
+    if constexpr (M::is_inline)
+    {
+        ::new (&d_storage) C(std::move(collection));
+    }
+    else
+    {
+        ::new (&d_storage) C *(new C(std::move(collection)));
+    }
+
+    d_vtable = &M::vtable;
+}
+
+template<size_t Capacity>
+BasicAnyCollection<Capacity>::BasicAnyCollection(const BasicAnyCollection &other)
+    : d_vtable(other.d_vtable)
+{
+    if (d_vtable)
+    {
+        d_vtable->copy(other.d_storage, d_storage);
+    }
+}
+
+template<size_t Capacity>
+BasicAnyCollection<Capacity>::BasicAnyCollection(BasicAnyCollection &&other) noexcept
+    : d_vtable(other.d_vtable)
+{
+    if (d_vtable)
+    {
+        d_vtable->move(other.d_storage, d_storage);
+        other.d_vtable = nullptr;
+    }
+}
+
+template<size_t Capacity>
+BasicAnyCollection<Capacity> &BasicAnyCollection<Capacity>::operator=(const BasicAnyCollection &other)
+{
+    if (this != &other)
+    {
+        *this = BasicAnyCollection {other};
+    }
+
+    return *this;
+}
+
+template<size_t Capacity>
+BasicAnyCollection<Capacity> &BasicAnyCollection<Capacity>::operator=(BasicAnyCollection &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (d_vtable)
+        {
+            d_vtable->destroy(d_storage);
+        }
+
+        d_vtable = other.d_vtable;
+        if (d_vtable)
+        {
+            d_vtable->move(other.d_storage, d_storage);
+            other.d_vtable = nullptr;
+        }
+    }
+
+    return *this;
+}
+
+template<size_t Capacity>
+BasicAnyCollection<Capacity>::~BasicAnyCollection()
+{
+    if (d_vtable)
+    {
+        d_vtable->destroy(d_storage);
+    }
+}
+
+template<size_t Capacity>
+bool BasicAnyCollection<Capacity>::has_value() const
+{
+    return d_vtable != nullptr;
+}
+
+template<size_t Capacity>
+BasicAnyCollection<Capacity>::operator bool() const
+{
+    return d_vtable && d_vtable->ready(get<void>());
+}
+
+template<size_t Capacity>
+std::optional<AnyValue> BasicAnyCollection<Capacity>::operator()(std::string_view name) const
+{
+    return d_vtable ? d_vtable->find(get<void>(), name) : std::nullopt;
+}
+
+template<size_t Capacity>
+std::optional<AnyValue> BasicAnyCollection<Capacity>::operator()(std::string_view name, std::string_view key) const
+{
+    return d_vtable ? d_vtable->find_key(get<void>(), name, key) : std::nullopt;
+}
+
+template<size_t Capacity>
+template<typename F>
+void BasicAnyCollection<Capacity>::for_each(F &&function) const
+{
+    if (d_vtable)
+    {
+        d_vtable->for_each(get<void>(), &function, [](void *context, const AnyAttribute &attribute) {
+            (*static_cast<std::remove_reference_t<F> *>(context))(attribute);
+        });
+    }
+}
+
+template<size_t Capacity>
+template<typename C>
+const C *BasicAnyCollection<Capacity>::get_if() const
+{
+    return d_vtable && d_vtable->type == traits::type_key<C>::value ? get<C>() : nullptr;
+}
+
+template<size_t Capacity>
+template<typename C>
+std::optional<C> BasicAnyCollection<Capacity>::collection() const &
+{
+    if (const C *collection = get_if<C>())
+    {
+        return *collection;
+    }
+
+    return convert<C>(false);
+}
+
+template<size_t Capacity>
+template<typename C>
+std::optional<C> BasicAnyCollection<Capacity>::collection() &&
+{
+    if (get_if<C>())
+    {
+        return std::move(*get<C>());
+    }
+
+    return convert<C>(true);
+}
+
+} // namespace porter::attr
@@ -0,0 +1,577 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "layered.h"
+
+#include <type_traits>
+#include <utility>
+
+#if __cpp_impl_coroutine
+#include <coroutine>
+#endif
+
+
+namespace porter::attr {
+
+
+/// Defines a frame of a thread-local attribute context, that can be carried over to other threads.
+/// Unlike Scope, the context is a Layered collection: each frame is a shared immutable layer on top of the
+/// enclosing ones, so capturing the context shares layers by reference count instead of copying attribute values.
+/// Frames are scope guards: constructing one makes it the current context of calling thread, destroying it
+/// restores the previous context. Frames must be destroyed in reverse order of construction.
+/// @tparam Holders pack of attribute holder types (context schema).
+template<typename... Holders>
+class AsyncScope
+{
+public:
+    /// Defines captured context type.
+    using context_type = Layered<Holders...>;
+
+private:
+    /// Stores current context of calling thread, its overlay is always empty.
+    static inline thread_local context_type t_current;
+
+    /// Stores context to restore on destruction.
+    context_type d_previous;
+
+public:
+    /// Push a frame with attribute values.
+    /// @tparam Attrs pack of attribute value containers.
+    /// @param attributes pack of attribute value containers.
+    template<
+        typename... Attrs,
+        typename = std::enable_if_t<(sizeof...(Attrs) > 0 && (!std::is_same_v<std::decay_t<Attrs>, context_type> && ...))>>
+    explicit AsyncScope(Attrs &&...attributes);
+
+    /// Install a captured context, e.g. on a thread that continues work started on another one.
+    /// @param context captured context.
+    explicit AsyncScope(context_type context);
+
+    /// Not copyable: restores the previous context on destruction.
+    AsyncScope(const AsyncScope &) = delete;
+
+    /// Not copyable: restores the previous context on destruction.
+    AsyncScope &operator=(const AsyncScope &) = delete;
+
+    /// Restore the previous context.
+    ~AsyncScope();
+
+    /// Capture current context of calling thread. Takes a reference to the shared layers, values are not copied.
+    /// @return captured context.
+    static context_type capture();
+
+    /// Replace current context of calling thread.
+    /// @param context new context.
+    /// @return previous context.
+    static context_type exchange(context_type context);
+
+    /// Wrap a function, so it runs in current context of calling thread wherever it's called.
+    /// @tparam F function type.
+    /// @param func function to wrap.
+    /// @return wrapped function.
+    template<typename F>
+    static auto wrap(F &&func);
+
+    /// Get innermost set attribute value of calling thread's context.
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @return attribute value or std::nullopt, if not set.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    static const typename H::type &get(Tag);
+
+    /// Get innermost set named attribute value for associative attributes (i.e. Multiple holder).
+    /// @tparam Tag attribute tag type.
+    /// @tparam K attribute name type, anything the holder can look up by.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param key attribute value name.
+    /// @return attribute value reference or std::nullopt, if not set.
+    template<
+        typename Tag,
+        typename K,
+        typename H = traits::by_tag_t<Tag, Holders...>,
+        typename = std::void_t<typename H::key_type>>
+    static typename H::mapped_type get(Tag, const K &key);
+
+    /// Build a collection of effective attribute values of calling thread's context.
+    /// @return collection of innermost set attribute values.
+    static Collection<Holders...> collection();
+};
+
+
+/// Defines executor adaptor, that runs posted functions in the context they were posted from.
+/// @tparam Executor wrapped executor type, with post(F) and/or execute(F).
+/// @tparam Holders pack of attribute holder types (context schema).
+template<typename Executor, typename... Holders>
+class PropagatingExecutor
+{
+    /// Stores wrapped executor.
+    Executor d_executor;
+
+public:
+    /// Wrap an executor.
+    /// @param executor wrapped executor.
+    explicit PropagatingExecutor(Executor executor);
+
+    /// Post a function to the wrapped executor, capturing current context.
+    /// @tparam F function type.
+    /// @param func function to post.
+    template<typename F>
+    decltype(auto) post(F &&func);
+
+    /// Execute a function on the wrapped executor, capturing current context.
+    /// @tparam F function type.
+    /// @param func function to execute.
+    template<typename F>
+    decltype(auto) execute(F &&func);
+
+    /// Get wrapped executor.
+    Executor &executor();
+};
+
+
+#if __cpp_impl_coroutine
+
+namespace traits {
+
+
+/// Template that checks whether an awaited expression type has member operator co_await.
+template<typename A, typename = void> struct has_co_await : std::false_type {};
+
+/// Template that checks whether an awaited expression type has member operator co_await.
+template<typename A>
+struct has_co_await<A, std::void_t<decltype(std::declval<A>().operator co_await())>> : std::true_type {};
+
+/// Helper variable that checks whether an awaited expression type has member operator co_await.
+template<typename A> inline constexpr bool has_co_await_v = has_co_await<A>::value;
+
+/// Template that defines the awaiter type of an awaited expression type.
+/// Plain awaiters are referred to: the awaited expression outlives the suspension.
+template<typename A, typename = void> struct awaiter { using type = A &&; };
+
+/// Template that defines the awaiter type of an awaited expression type with member operator co_await.
+template<typename A>
+struct awaiter<A, std::enable_if_t<has_co_await_v<A>>> { using type = decltype(std::declval<A>().operator co_await()); };
+
+/// Helper alias for the awaiter type of an awaited expression type.
+template<typename A> using awaiter_t = typename awaiter<A>::type;
+
+
+} // namespace traits
+
+
+/// Defines coroutine promise mixin, that carries attribute context of a coroutine over its suspension points.
+/// A coroutine runs in the context it's created in: on co_await the coroutine's context is captured and
+/// the thread gets back the context it had before running the coroutine; on resumption the captured context
+/// is installed on the resuming thread. Promise types derive from the mixin, must not define their own
+/// await_transform() and wrap their initial and final awaiters with start() and finish(), e.g.
+/// `auto initial_suspend() { return start(std::suspend_always {}); }`, so that lazily started coroutines get
+/// their creation context on first resumption and threads get their own context back once coroutines complete.
+/// If unhandled_exception() rethrows, the final awaiter is not reached and the thread keeps the coroutine's context.
+/// @tparam Holders pack of attribute holder types (context schema).
+template<typename... Holders>
+class PropagatingPromise
+{
+    /// Defines captured context type.
+    using context_type = typename AsyncScope<Holders...>::context_type;
+
+    /// Defines awaiter adaptor of suspension points within the coroutine body.
+    /// @tparam Inner wrapped awaiter type, a value or a reference.
+    template<typename Inner>
+    class Awaiter
+    {
+        /// Stores promise of the awaiting coroutine.
+        PropagatingPromise *d_promise;
+
+        /// Stores wrapped awaiter.
+        Inner d_inner;
+
+        /// Stores whether the coroutine was suspended.
+        bool d_suspended = false;
+
+    public:
+        /// Wrap an awaiter.
+        /// @param promise promise of the awaiting coroutine.
+        /// @param inner wrapped awaiter.
+        Awaiter(PropagatingPromise &promise, Inner &&inner);
+
+        /// Check whether the coroutine can continue without suspension.
+        bool await_ready();
+
+        /// Capture the coroutine's context and suspend it.
+        /// @tparam Promise promise type.
+        /// @param handle suspended coroutine.
+        template<typename Promise>
+        decltype(auto) await_suspend(std::coroutine_handle<Promise> handle);
+
+        /// Install the coroutine's context on the resuming thread.
+        decltype(auto) await_resume();
+    };
+
+    /// Defines awaiter adaptor of the initial suspension point.
+    /// @tparam Inner wrapped awaiter type.
+    template<typename Inner>
+    class Starter
+    {
+        /// Stores promise of the starting coroutine.
+        PropagatingPromise *d_promise;
+
+        /// Stores wrapped awaiter.
+        Inner d_inner;
+
+    public:
+        /// Wrap an awaiter.
+        /// @param promise promise of the starting coroutine.
+        /// @param inner wrapped awaiter.
+        Starter(PropagatingPromise &promise, Inner &&inner);
+
+        /// Check whether the coroutine starts without suspension.
+        bool await_ready();
+
+        /// Suspend the coroutine before it starts.
+        /// @tparam Promise promise type.
+        /// @param handle suspended coroutine.
+        template<typename Promise>
+        decltype(auto) await_suspend(std::coroutine_handle<Promise> handle);
+
+        /// Install the coroutine's creation context on the thread that starts it.
+        decltype(auto) await_resume();
+    };
+
+    /// Defines awaiter adaptor of the final suspension point.
+    /// @tparam Inner wrapped awaiter type.
+    template<typename Inner>
+    class Finisher
+    {
+        /// Stores promise of the completed coroutine.
+        PropagatingPromise *d_promise;
+
+        /// Stores wrapped awaiter.
+        Inner d_inner;
+
+    public:
+        /// Wrap an awaiter.
+        /// @param promise promise of the completed coroutine.
+        /// @param inner wrapped awaiter.
+        Finisher(PropagatingPromise &promise, Inner &&inner) noexcept;
+
+        /// Restore the context of the thread the coroutine completes on,
+        /// then check whether the coroutine completes without suspension.
+        bool await_ready() noexcept;
+
+        /// Suspend the completed coroutine.
+        /// @tparam Promise promise type.
+        /// @param handle suspended coroutine.
+        template<typename Promise>
+        decltype(auto) await_suspend(std::coroutine_handle<Promise> handle) noexcept;
+
+        /// Complete the final suspension.
+        decltype(auto) await_resume() noexcept;
+    };
+
+    /// Stores context of the coroutine while it does not run, initially the context it's created in.
+    context_type d_context;
+
+    /// Stores context of the thread while the coroutine runs, restored when the coroutine suspends or completes.
+    context_type d_outer;
+
+    /// Stores whether the coroutine runs, i.e. calling thread has the coroutine's context.
+    bool d_running = false;
+
+private:
+    /// Install the coroutine's context on calling thread, keeping the thread's own context.
+    void enter();
+
+    /// Restore the thread's own context, keeping the coroutine's context.
+    void leave();
+
+public:
+    /// Capture the context the coroutine is created in.
+    PropagatingPromise();
+
+    /// Wrap the awaiter of the initial suspension point, returned from initial_suspend().
+    /// @tparam Awaitable awaiter type, e.g. std::suspend_always for lazily started coroutines.
+    /// @param awaitable initial awaiter.
+    /// @return awaiter adaptor.
+    template<typename Awaitable>
+    Starter<std::decay_t<Awaitable>> start(Awaitable &&awaitable);
+
+    /// Wrap the awaiter of the final suspension point, returned from final_suspend().
+    /// @tparam Awaitable awaiter type.
+    /// @param awaitable final awaiter.
+    /// @return awaiter adaptor.
+    template<typename Awaitable>
+    Finisher<std::decay_t<Awaitable>> finish(Awaitable &&awaitable) noexcept;
+
+    /// Wrap an awaited expression.
+    /// @tparam Awaitable awaited expression type: an awaiter or a type with member operator co_await.
+    /// @param awaitable awaited expression.
+    /// @return awaiter adaptor.
+    template<typename Awaitable>
+    Awaiter<traits::awaiter_t<Awaitable>> await_transform(Awaitable &&awaitable);
+};
+
+#endif
+
+
+
+template<typename... Holders>
+template<typename... Attrs, typename>
+AsyncScope<Holders...>::AsyncScope(Attrs &&...attributes)
+    : d_previous(std::move(t_current))
+{
+    context_type frame = d_previous.derive();
+    (frame << ... << std::forward<Attrs>(attributes));
+    t_current = frame.derive();
+}
+
+template<typename... Holders>
+AsyncScope<Holders...>::AsyncScope(context_type context)
+    : d_previous(exchange(context.derive()))
+{
+}
+
+template<typename... Holders>
+AsyncScope<Holders...>::~AsyncScope()
+{
+    t_current = std::move(d_previous);
+}
+
+template<typename... Holders>
+typename AsyncScope<Holders...>::context_type AsyncScope<Holders...>::capture()
+{
+    return t_current.derive();
+}
+
+template<typename... Holders>
+typename AsyncScope<Holders...>::context_type AsyncScope<Holders...>::exchange(context_type context)
+{
+    return std::exchange(t_current, std::move(context));
+}
+
+template<typename... Holders>
+template<typename F>
+auto AsyncScope<Holders...>::wrap(F &&func)
+{
+    return [context = capture(), func = std::forward<F>(func)](auto &&...args) mutable -> decltype(auto) {
+        AsyncScope scope {context};
+        return func(std::forward<decltype(args)>(args)...);
+    };
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+const typename H::type &AsyncScope<Holders...>::get(Tag)
+{
+    return t_current(Tag {});
+}
+
+template<typename... Holders>
+template<typename Tag, typename K, typename H, typename>
+typename H::mapped_type AsyncScope<Holders...>::get(Tag, const K &key)
+{
+    return t_current(Tag {}, key);
+}
+
+template<typename... Holders>
+Collection<Holders...> AsyncScope<Holders...>::collection()
+{
+    return t_current.collection();
+}
+
+
+template<typename Executor, typename... Holders>
+PropagatingExecutor<Executor, Holders...>::PropagatingExecutor(Executor executor)
+    : d_executor(std::move(executor))
+{
+}
+
+template<typename Executor, typename... Holders>
+template<typename F>
+decltype(auto) PropagatingExecutor<Executor, Holders...>::post(F &&func)
+{
+    return d_executor.post(AsyncScope<Holders...>::wrap(std::forward<F>(func)));
+}
+
+template<typename Executor, typename... Holders>
+template<typename F>
+decltype(auto) PropagatingExecutor<Executor, Holders...>::execute(F &&func)
+{
+    return d_executor.execute(AsyncScope<Holders...>::wrap(std::forward<F>(func)));
+}
+
+template<typename Executor, typename... Holders>
+Executor &PropagatingExecutor<Executor, Holders...>::executor()
+{
+    return d_executor;
+}
+
+
+#if __cpp_impl_coroutine
+
+template<typename... Holders>
+template<typename Inner>
+PropagatingPromise<Holders...>::Awaiter<Inner>::Awaiter(PropagatingPromise &promise, Inner &&inner)
+    : d_promise(&promise)
+    , d_inner(std::forward<Inner>(inner))
+{
+}
+
+template<typename... Holders>
+template<typename Inner>
+bool PropagatingPromise<Holders...>::Awaiter<Inner>::await_ready()
+{
+    return d_inner.await_ready();
+}
+
+template<typename... Holders>
+template<typename Inner>
+template<typename Promise>
+decltype(auto) PropagatingPromise<Holders...>::Awaiter<Inner>::await_suspend(std::coroutine_handle<Promise> handle)
+{
+    // The coroutine may be resumed on another thread before the wrapped awaiter returns,
+    // so the context is handed over before suspending.
+    d_promise->leave();
+    d_suspended = true;
+
+    return d_inner.await_suspend(handle);
+}
+
+template<typename... Holders>
+template<typename Inner>
+decltype(auto) PropagatingPromise<Holders...>::Awaiter<Inner>::await_resume()
+{
+    if (d_suspended)
+    {
+        d_promise->enter();
+    }
+
+    return d_inner.await_resume();
+}
+
+template<typename... Holders>
+template<typename Inner>
+PropagatingPromise<Holders...>::Starter<Inner>::Starter(PropagatingPromise &promise, Inner &&inner)
+    : d_promise(&promise)
+    , d_inner(std::move(inner))
+{
+}
+
+template<typename... Holders>
+template<typename Inner>
+bool PropagatingPromise<Holders...>::Starter<Inner>::await_ready()
+{
+    return d_inner.await_ready();
+}
+
+template<typename... Holders>
+template<typename Inner>
+template<typename Promise>
+decltype(auto) PropagatingPromise<Holders...>::Starter<Inner>::await_suspend(std::coroutine_handle<Promise> handle)
+{
+    return d_inner.await_suspend(handle);
+}
+
+template<typename... Holders>
+template<typename Inner>
+decltype(auto) PropagatingPromise<Holders...>::Starter<Inner>::await_resume()
+{
+    // Called when the body starts, both for eager and lazy coroutines
+    d_promise->enter();
+    return d_inner.await_resume();
+}
+
+template<typename... Holders>
+template<typename Inner>
+PropagatingPromise<Holders...>::Finisher<Inner>::Finisher(PropagatingPromise &promise, Inner &&inner) noexcept
+    : d_promise(&promise)
+    , d_inner(std::move(inner))
+{
+}
+
+template<typename... Holders>
+template<typename Inner>
+bool PropagatingPromise<Holders...>::Finisher<Inner>::await_ready() noexcept
+{
+    // Called first at the final suspension point, whether the coroutine suspends there or not
+    d_promise->leave();
+    return d_inner.await_ready();
+}
+
+template<typename... Holders>
+template<typename Inner>
+template<typename Promise>
+decltype(auto) PropagatingPromise<Holders...>::Finisher<Inner>::await_suspend(std::coroutine_handle<Promise> handle) noexcept
+{
+    return d_inner.await_suspend(handle);
+}
+
+template<typename... Holders>
+template<typename Inner>
+decltype(auto) PropagatingPromise<Holders...>::Finisher<Inner>::await_resume() noexcept
+{
+    return d_inner.await_resume();
+}
+
+template<typename... Holders>
+PropagatingPromise<Holders...>::PropagatingPromise()
+    : d_context(AsyncScope<Holders...>::capture())
+{
+}
+
+template<typename... Holders>
+void PropagatingPromise<Holders...>::enter()
+{
+    if (!d_running)
+    {
+        d_outer = AsyncScope<Holders...>::exchange(std::move(d_context));
+        d_running = true;
+    }
+}
+
+template<typename... Holders>
+void PropagatingPromise<Holders...>::leave()
+{
+    if (d_running)
+    {
+        d_context = AsyncScope<Holders...>::exchange(std::move(d_outer));
+        d_running = false;
+    }
+}
+
+template<typename... Holders>
+template<typename Awaitable>
+typename PropagatingPromise<Holders...>::template Starter<std::decay_t<Awaitable>>
+PropagatingPromise<Holders...>::start(Awaitable &&awaitable)
+{
+    return {*this, std::decay_t<Awaitable>(std::forward<Awaitable>(awaitable))};
+}
+
+template<typename... Holders>
+template<typename Awaitable>
+typename PropagatingPromise<Holders...>::template Finisher<std::decay_t<Awaitable>>
+PropagatingPromise<Holders...>::finish(Awaitable &&awaitable) noexcept
+{
+    return {*this, std::decay_t<Awaitable>(std::forward<Awaitable>(awaitable))};
+}
+
+template<typename... Holders>
+template<typename Awaitable>
+typename PropagatingPromise<Holders...>::template Awaiter<traits::awaiter_t<Awaitable>>
+PropagatingPromise<Holders...>::await_transform(Awaitable &&awaitable)
+{
+    if constexpr (traits::has_co_await_v<Awaitable>)
+    {
+        return {*this, std::forward<Awaitable>(awaitable).operator co_await()};
+    }
+    else
+    {
+        return {*this, std::forward<Awaitable>(awaitable)};
+    }
+}
+
+#endif
+
+
+} // namespace porter::attr
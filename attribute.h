@@ -1,8 +1,11 @@
 #pragma once
 
+#include "storage.h"
+
 #include <type_traits>
 #include <optional>
 #include <utility>
+#include <memory>
 #include <string_view>
 
 
@@ -54,7 +57,15 @@ public:
     /// @tparam Vt type, convertible to attribute value type.
     /// @param value initial attribute value.
     template<typename Vt>
-    explicit Value(Vt &&value);
+    constexpr explicit Value(Vt &&value);
+
+    /// Construct instance from attribute value, using provided allocator for the value.
+    /// @tparam Alloc allocator type.
+    /// @tparam Vt type, convertible to attribute value type.
+    /// @param allocator allocator to construct attribute value with.
+    /// @param value initial attribute value.
+    template<typename Alloc, typename Vt>
+    Value(std::allocator_arg_t, const Alloc &allocator, Vt &&value);
 
     /// Default copy ctor.
     Value(const Value<Tag, V> &) = default;
@@ -73,15 +84,15 @@ public:
     /// @param value new attribute value (overwrites the old one, if any).
     /// @return reference to self.
     template<typename Vt>
-    Value<Tag, V> &operator=(Vt &&value);
+    constexpr Value<Tag, V> &operator=(Vt &&value);
 
     /// Get stored value.
     /// @return const reference to stored value.
-    const std::optional<V> &operator*() const &;
+    constexpr const std::optional<V> &operator*() const &;
 
     /// Get stored value.
     /// @return rvalue reference to stored value.
-    std::optional<V> &&operator*() &&;
+    constexpr std::optional<V> &&operator*() &&;
 };
 
 
@@ -98,7 +109,17 @@ public:
     /// @param key attribute name.
     /// @param value attribute value.
     template<typename Kt, typename Vt>
-    explicit KeyValue(Kt &&key, Vt &&value);
+    constexpr explicit KeyValue(Kt &&key, Vt &&value);
+
+    /// Construct instance from name and value, using provided allocator for the value.
+    /// @tparam Alloc allocator type.
+    /// @tparam Kt attribute name type.
+    /// @tparam Vt value type, convertible to the attribute value type.
+    /// @param allocator allocator to construct attribute value with.
+    /// @param key attribute name.
+    /// @param value attribute value.
+    template<typename Alloc, typename Kt, typename Vt>
+    KeyValue(std::allocator_arg_t, const Alloc &allocator, Kt &&key, Vt &&value);
 };
 
 
@@ -118,27 +139,34 @@ template<typename Tag, typename V> struct tag_of<KeyValue<Tag, V>> { using type
 
 template<typename Tag, typename V>
 template<typename Vt>
-Value<Tag, V>::Value(Vt &&value)
+constexpr Value<Tag, V>::Value(Vt &&value)
     : d_value(std::forward<Vt>(value))
 {
 }
 
+template<typename Tag, typename V>
+template<typename Alloc, typename Vt>
+Value<Tag, V>::Value(std::allocator_arg_t, const Alloc &allocator, Vt &&value)
+    : d_value(make_using_allocator<V>(allocator, std::forward<Vt>(value)))
+{
+}
+
 template<typename Tag, typename V>
 template<typename Vt>
-Value<Tag, V> &Value<Tag, V>::operator=(Vt &&value)
+constexpr Value<Tag, V> &Value<Tag, V>::operator=(Vt &&value)
 {
-    d_value.reset(std::forward<Vt>(value));
+    d_value.emplace(std::forward<Vt>(value));
     return *this;
 }
 
 template<typename Tag, typename V>
-const std::optional<V> &Value<Tag, V>::operator*() const &
+constexpr const std::optional<V> &Value<Tag, V>::operator*() const &
 {
     return d_value;
 }
 
 template<typename Tag, typename V>
-std::optional<V> &&Value<Tag, V>::operator*() &&
+constexpr std::optional<V> &&Value<Tag, V>::operator*() &&
 {
     return std::move(d_value);
 }
@@ -146,8 +174,17 @@ std::optional<V> &&Value<Tag, V>::operator*() &&
 
 template<typename Tag, typename V>
 template<typename Kt, typename Vt>
-KeyValue<Tag, V>::KeyValue(Kt &&key, Vt &&value)
-    : Value<Tag, V> {std::make_pair(std::forward<Kt>(key), std::forward<Vt>(value))}
+constexpr KeyValue<Tag, V>::KeyValue(Kt &&key, Vt &&value)
+    : Value<Tag, V> {V(std::forward<Kt>(key), std::forward<Vt>(value))}
+{
+}
+
+template<typename Tag, typename V>
+template<typename Alloc, typename Kt, typename Vt>
+KeyValue<Tag, V>::KeyValue(std::allocator_arg_t, const Alloc &allocator, Kt &&key, Vt &&value)
+    : Value<Tag, V> {V(
+        std::forward<Kt>(key),
+        make_using_allocator<typename V::second_type>(allocator, std::forward<Vt>(value)))}
 {
 }
 
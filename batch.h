@@ -0,0 +1,428 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "packed.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace porter::attr {
+
+
+/// Defines a read-only view of a batch column: a contiguous array of values and a presence bitmap.
+/// Values of rows without a set value are default-constructed.
+/// @tparam V column value type.
+template<typename V>
+class Column
+{
+    /// Stores column values.
+    const V *d_data = nullptr;
+
+    /// Stores presence bitmap words, bit i % 64 of word i / 64 is set if row i has a value.
+    const uint64_t *d_present = nullptr;
+
+    /// Stores number of rows.
+    size_t d_size = 0;
+
+public:
+    /// Construct a column view.
+    /// @param data column values.
+    /// @param present presence bitmap words.
+    /// @param size number of rows.
+    Column(const V *data, const uint64_t *present, size_t size);
+
+    /// Get column values.
+    const V *data() const;
+
+    /// Get presence bitmap words, each covering 64 rows.
+    const uint64_t *bitmap() const;
+
+    /// Get number of rows.
+    size_t size() const;
+
+    /// Get column value of a row.
+    /// @param row row index.
+    /// @return value, default-constructed if not set.
+    const V &operator[](size_t row) const;
+
+    /// Check whether a row has a value.
+    /// @param row row index.
+    bool present(size_t row) const;
+
+    /// Get iterator to the first value.
+    const V *begin() const;
+
+    /// Get end iterator.
+    const V *end() const;
+};
+
+
+/// Defines a batch of collections of the same type with columnar (structure of arrays) layout.
+/// Single holder values are stored in one contiguous column per holder, along with presence bitmaps,
+/// other holders are stored as is in their own columns.
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class CollectionBatch
+{
+    static_assert(traits::are_holders_valid_v<Holders...>, "One or more holder types are not valid");
+
+    static_assert(
+        (std::is_default_constructible_v<traits::packed_t<Holders>> && ...),
+        "Batched attribute values must be default constructible");
+
+    static_assert(
+        (!std::is_same_v<traits::packed_t<Holders>, bool> && ...),
+        "Batched attribute values can't be bool: std::vector<bool> columns have no contiguous storage, use uint8_t");
+
+public:
+    /// Defines attribute value access type for a holder.
+    /// Single holders return a reference to value or std::nullopt, other holders return value storage reference.
+    template<typename H>
+    using access_t = typename PackedCollection<Holders...>::template access_t<H>;
+
+    /// Defines a view of a batch row, that behaves like a collection.
+    class Row
+    {
+        /// Stores the batch.
+        const CollectionBatch *d_batch;
+
+        /// Stores row index.
+        size_t d_row;
+
+    public:
+        /// Construct a row view.
+        /// @param batch the batch.
+        /// @param row row index.
+        Row(const CollectionBatch &batch, size_t row);
+
+        /// Get attribute value or value storage.
+        /// @tparam Tag attribute tag type.
+        /// @tparam H attribute holder type, auto-deduced.
+        /// @return attribute value reference (std::nullopt if not set) or value storage reference.
+        template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+        access_t<H> operator()(Tag) const;
+
+        /// Get named attribute value for associative attributes (i.e. Multiple holder).
+        /// @tparam Tag attribute tag type.
+        /// @tparam K attribute name type, anything the holder can look up by.
+        /// @tparam H attribute holder type, auto-deduced.
+        /// @param key attribute value name.
+        /// @return attribute value reference or std::nullopt, if not found.
+        template<
+            typename Tag,
+            typename K,
+            typename H = traits::by_tag_t<Tag, Holders...>,
+            typename = std::void_t<typename H::key_type>>
+        typename H::mapped_type operator()(Tag, const K &key) const;
+
+        /// Checks whether all required attribute values are set.
+        operator bool() const;
+
+        /// Convert into a regular collection.
+        /// @return collection with copied attribute values.
+        Collection<Holders...> collection() const;
+    };
+
+private:
+    /// Stores value columns.
+    std::tuple<std::vector<traits::packed_t<Holders>>...> d_columns;
+
+    /// Stores presence bitmaps of columns.
+    std::array<std::vector<uint64_t>, sizeof...(Holders)> d_present;
+
+    /// Stores number of rows.
+    size_t d_size = 0;
+
+private:
+    /// Get value column of a holder.
+    /// @tparam H attribute holder type.
+    template<typename H>
+    const std::vector<traits::packed_t<H>> &values() const;
+
+    /// Get value column of a holder.
+    /// @tparam H attribute holder type.
+    template<typename H>
+    std::vector<traits::packed_t<H>> &values();
+
+    /// Get presence bit of a row.
+    /// @tparam H attribute holder type.
+    /// @param row row index.
+    template<typename H>
+    bool present(size_t row) const;
+
+    /// Append (copy or move) a holder value of a collection.
+    /// @tparam H attribute holder type.
+    /// @tparam Holder holder reference type.
+    /// @param holder source holder.
+    template<typename H, typename Holder>
+    void append(Holder &&holder);
+
+public:
+    /// Construct an empty batch.
+    CollectionBatch() = default;
+
+    /// Get number of rows.
+    size_t size() const;
+
+    /// Check whether there are no rows.
+    bool empty() const;
+
+    /// Reserve storage for rows.
+    /// @param rows number of rows.
+    void reserve(size_t rows);
+
+    /// Remove all rows.
+    void clear();
+
+    /// Append (copy) a collection.
+    /// @param collection collection to append.
+    void push_back(const Collection<Holders...> &collection);
+
+    /// Append (move) a collection.
+    /// @param collection collection to append.
+    void push_back(Collection<Holders...> &&collection);
+
+    /// Get a row view.
+    /// @param row row index.
+    Row operator[](size_t row) const;
+
+    /// Get a column view of single attribute values.
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @return column view.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    Column<traits::packed_t<H>> column(Tag) const;
+};
+
+
+
+template<typename V>
+Column<V>::Column(const V *data, const uint64_t *present, size_t size)
+    : d_data(data)
+    , d_present(present)
+    , d_size(size)
+{
+}
+
+template<typename V>
+const V *Column<V>::data() const
+{
+    return d_data;
+}
+
+template<typename V>
+const uint64_t *Column<V>::bitmap() const
+{
+    return d_present;
+}
+
+template<typename V>
+size_t Column<V>::size() const
+{
+    return d_size;
+}
+
+template<typename V>
+const V &Column<V>::operator[](size_t row) const
+{
+    return d_data[row];
+}
+
+template<typename V>
+bool Column<V>::present(size_t row) const
+{
+    return d_present[row / 64] >> (row % 64) & 1;
+}
+
+template<typename V>
+const V *Column<V>::begin() const
+{
+    return d_data;
+}
+
+template<typename V>
+const V *Column<V>::end() const
+{
+    return d_data + d_size;
+}
+
+
+template<typename... Holders>
+CollectionBatch<Holders...>::Row::Row(const CollectionBatch &batch, size_t row)
+    : d_batch(&batch)
+    , d_row(row)
+{
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+typename CollectionBatch<Holders...>::template access_t<H> CollectionBatch<Holders...>::Row::operator()(Tag) const
+{
+    const auto &value = d_batch->template values<H>()[d_row];
+
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        return *value;
+    }
+    else
+    {
+        return d_batch->template present<H>(d_row) ? std::make_optional(std::cref(value)) : std::nullopt;
+    }
+}
+
+template<typename... Holders>
+template<typename Tag, typename K, typename H, typename>
+typename H::mapped_type CollectionBatch<Holders...>::Row::operator()(Tag, const K &key) const
+{
+    return d_batch->template values<H>()[d_row](key);
+}
+
+template<typename... Holders>
+CollectionBatch<Holders...>::Row::operator bool() const
+{
+    return (true && ... && (!traits::is_required_v<Holders> || d_batch->template present<Holders>(d_row)));
+}
+
+template<typename... Holders>
+Collection<Holders...> CollectionBatch<Holders...>::Row::collection() const
+{
+    Collection<Holders...> collection;
+
+    auto take = [&](auto tag) {
+        using Tag = decltype(tag);
+        using H = traits::by_tag_t<Tag, Holders...>;
+
+        if constexpr (traits::is_multiple_v<H>)
+        {
+            collection.template holder<H>() = d_batch->template values<H>()[d_row];
+        }
+        else if (auto value = (*this)(tag))
+        {
+            collection << Value<Tag, typename H::value_type> {value->get()};
+        }
+    };
+    (take(traits::tag_of_t<Holders> {}), ...);
+
+    return collection;
+}
+
+
+template<typename... Holders>
+template<typename H>
+const std::vector<traits::packed_t<H>> &CollectionBatch<Holders...>::values() const
+{
+    return std::get<traits::index_of_v<H, Holders...>>(d_columns);
+}
+
+template<typename... Holders>
+template<typename H>
+std::vector<traits::packed_t<H>> &CollectionBatch<Holders...>::values()
+{
+    return std::get<traits::index_of_v<H, Holders...>>(d_columns);
+}
+
+template<typename... Holders>
+template<typename H>
+bool CollectionBatch<Holders...>::present(size_t row) const
+{
+    return d_present[traits::index_of_v<H, Holders...>][row / 64] >> (row % 64) & 1;
+}
+
+template<typename... Holders>
+template<typename H, typename Holder>
+void CollectionBatch<Holders...>::append(Holder &&holder)
+{
+    std::vector<uint64_t> &bitmap = d_present[traits::index_of_v<H, Holders...>];
+    if (d_size % 64 == 0)
+    {
+        bitmap.push_back(0);
+    }
+
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        values<H>().push_back(std::forward<Holder>(holder));
+        bitmap.back() |= uint64_t(1) << (d_size % 64);
+    }
+    else if (*holder)
+    {
+        values<H>().push_back(**std::forward<Holder>(holder));
+        bitmap.back() |= uint64_t(1) << (d_size % 64);
+    }
+    else
+    {
+        values<H>().emplace_back();
+    }
+}
+
+template<typename... Holders>
+size_t CollectionBatch<Holders...>::size() const
+{
+    return d_size;
+}
+
+template<typename... Holders>
+bool CollectionBatch<Holders...>::empty() const
+{
+    return d_size == 0;
+}
+
+template<typename... Holders>
+void CollectionBatch<Holders...>::reserve(size_t rows)
+{
+    (values<Holders>().reserve(rows), ...);
+    for (std::vector<uint64_t> &bitmap : d_present)
+    {
+        bitmap.reserve((rows + 63) / 64);
+    }
+}
+
+template<typename... Holders>
+void CollectionBatch<Holders...>::clear()
+{
+    (values<Holders>().clear(), ...);
+    for (std::vector<uint64_t> &bitmap : d_present)
+    {
+        bitmap.clear();
+    }
+
+    d_size = 0;
+}
+
+template<typename... Holders>
+void CollectionBatch<Holders...>::push_back(const Collection<Holders...> &collection)
+{
+    (append<Holders>(collection.template holder<Holders>()), ...);
+    ++d_size;
+}
+
+template<typename... Holders>
+void CollectionBatch<Holders...>::push_back(Collection<Holders...> &&collection)
+{
+    (append<Holders>(std::move(collection).template holder<Holders>()), ...);
+    ++d_size;
+}
+
+template<typename... Holders>
+typename CollectionBatch<Holders...>::Row CollectionBatch<Holders...>::operator[](size_t row) const
+{
+    return Row {*this, row};
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+Column<traits::packed_t<H>> CollectionBatch<Holders...>::column(Tag) const
+{
+    return {values<H>().data(), d_present[traits::index_of_v<H, Holders...>].data(), d_size};
+}
+
+
+} // namespace porter::attr
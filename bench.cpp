@@ -0,0 +1,416 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "format.h"
+#include "fingerprint.h"
+#include "async.h"
+#include "packed.h"
+#include "schema.h"
+#include "symbol.h"
+#include "tags.h"
+
+
+namespace {
+
+
+/// Counts global allocations made by benchmarked code.
+struct Allocations
+{
+    size_t count = 0;
+    size_t bytes = 0;
+};
+
+Allocations g_allocations;
+
+
+} // namespace
+
+
+// Replacement operators are paired by the language, not by the compiler's allocation tracking.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t size)
+{
+    ++g_allocations.count;
+    g_allocations.bytes += size;
+
+    if (void *ptr = std::malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+
+    throw std::bad_alloc {};
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+
+namespace porter {
+namespace {
+
+
+/// Prevent the compiler from optimizing away a benchmarked value.
+template<typename T>
+void keep(const T &value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+
+/// Run a benchmark and print ns/op, allocations/op and allocated bytes/op.
+/// @param name benchmark name.
+/// @param op benchmarked operation.
+/// @param object_size size of the object the operation produces, reported as bytes per collection.
+template<typename Op>
+void run(std::string_view name, Op &&op, size_t object_size)
+{
+    constexpr size_t warmup = 10'000;
+    constexpr size_t iterations = 1'000'000;
+
+    for (size_t idx = 0; idx < warmup; ++idx)
+    {
+        op();
+    }
+
+    const Allocations before = g_allocations;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (size_t idx = 0; idx < iterations; ++idx)
+    {
+        op();
+    }
+
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const Allocations after = g_allocations;
+
+    std::printf(
+        "%-44.*s %10.2f ns/op %8.2f allocs/op %10.2f B/op %6zu B/coll\n",
+        int(name.size()), name.data(),
+        double(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) / iterations,
+        double(after.count - before.count) / iterations,
+        double(after.bytes - before.bytes) / iterations,
+        object_size);
+}
+
+
+using Coll = attr::Collection<
+    attr::Single<tag::id_t, true>,
+    attr::Single<tag::service_t, true>,
+    attr::Single<tag::subsystem_t, false>,
+    attr::Single<tag::pwho_t, false>,
+    attr::Single<tag::label_t, false>,
+    attr::Multiple<tag::context_t>
+>;
+
+using Partial = attr::Collection<
+    attr::Single<tag::service_t, true>,
+    attr::Single<tag::subsystem_t, true>
+>;
+
+
+void bench_assignment()
+{
+    run("operator<<(Value)", [] {
+        Coll coll;
+        coll << Id("id") << Service("pisvc") << Subsystem("adc") << Pwho(1234) << Label(42);
+        keep(coll);
+    }, sizeof(Coll));
+
+    run("operator<<(KeyValue)", [] {
+        Coll coll;
+        coll << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+        keep(coll);
+    }, sizeof(Coll));
+}
+
+void bench_extension()
+{
+    run("extend()", [] {
+        Partial partial;
+        partial << Service("pisvc") << Subsystem("adc");
+        auto extended = std::move(partial).extend(Label(42), Pwho(1234));
+        keep(extended);
+    }, sizeof(attr::traits::extend_t<Partial, attr::Single<tag::label_t, true>, attr::Single<tag::pwho_t, true>>));
+
+    run("converting construction", [] {
+        Partial partial;
+        partial << Service("pisvc") << Subsystem("adc");
+        Coll coll {std::move(partial)};
+        keep(coll);
+    }, sizeof(Coll));
+}
+
+void bench_merge()
+{
+    run("merge(const &)", [] {
+        Coll session, request;
+        session << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU");
+        request << Label(42) << Context("DFPATH", "anton-test.1") << Context("HOST", "localhost");
+        session.merge(request);
+        keep(session);
+    }, sizeof(Coll));
+
+    run("merge(&&)", [] {
+        Coll session, request;
+        session << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU");
+        request << Label(42) << Context("DFPATH", "anton-test.1") << Context("HOST", "localhost");
+        session.merge(std::move(request));
+        keep(session);
+    }, sizeof(Coll));
+}
+
+void bench_addition()
+{
+    run("operator+ x2", [] {
+        auto coll = (Service("a") + Subsystem("b")).collection();
+        keep(coll);
+    }, sizeof(decltype(Service("a") + Subsystem("b"))::type));
+
+    run("operator+ x4", [] {
+        auto coll = (Service("a") + Subsystem("b") + Label(1) + Pwho(2)).collection();
+        keep(coll);
+    }, sizeof(decltype(Service("a") + Subsystem("b") + Label(1) + Pwho(2))::type));
+
+    run("operator+ x6", [] {
+        auto coll = (Id("id") + Service("a") + Subsystem("b") + Label(1) + Pwho(2)
+            + Context("LID", "FIINDEX:LUATTRUU")).collection();
+        keep(coll);
+    }, sizeof(decltype(Id("id") + Service("a") + Subsystem("b") + Label(1) + Pwho(2)
+        + Context("LID", "FIINDEX:LUATTRUU"))::type));
+
+    run("operator+ x4, read without materialization", [] {
+        auto concat = Service("a") + Subsystem("b") + Label(1) + Pwho(2);
+        keep(concat(tag::label));
+    }, sizeof(decltype(Service("a") + Subsystem("b") + Label(1) + Pwho(2))));
+}
+
+void bench_lookup()
+{
+    Coll coll;
+    coll << Id("id") << Service("pisvc") << Label(42)
+         << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+
+    run("operator()(Tag)", [&] {
+        keep(coll(tag::service));
+    }, sizeof(Coll));
+
+    run("operator()(Tag, key)", [&] {
+        keep(coll(tag::context, "LID"));
+    }, sizeof(Coll));
+
+    run("operator()(Tag, missing key)", [&] {
+        keep(coll(tag::context, "NONE"));
+    }, sizeof(Coll));
+
+    run("operator bool", [&] {
+        keep(bool(coll));
+    }, sizeof(Coll));
+
+    run("hash()", [&] {
+        keep(attr::hash(coll));
+    }, sizeof(Coll));
+
+    const attr::Fingerprinted<
+        attr::Single<tag::id_t, true>,
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::pwho_t, false>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    > fingerprinted {coll};
+
+    run("Fingerprinted::fingerprint()", [&] {
+        keep(fingerprinted.fingerprint());
+    }, sizeof(fingerprinted));
+
+    run("format()", [&] {
+        char buffer[256];
+        keep(attr::format(std::begin(buffer), std::end(buffer), coll));
+    }, sizeof(Coll));
+}
+
+
+/// Defines schema names of context attributes for Fixed storage.
+struct ContextKeys
+{
+    static constexpr std::string_view values[] = {"LID", "DFPATH", "HOST"};
+};
+
+
+/// Extend a collection with per-request attributes.
+/// @tparam Hs attribute holder types, auto-deduced.
+/// @param coll collection to extend.
+/// @return extended collection.
+template<typename... Hs>
+auto extend_request(attr::Collection<Hs...> &&coll)
+{
+    return std::move(coll).extend(Context("HOST", "localhost"), Label(42));
+}
+
+/// Extend a packed collection with per-request attributes, unpacking it first.
+/// @tparam Hs attribute holder types, auto-deduced.
+/// @param packed collection to extend.
+/// @return extended collection.
+template<typename... Hs>
+auto extend_request(attr::PackedCollection<Hs...> &&packed)
+{
+    return std::move(packed).unpack().extend(Context("HOST", "localhost"), Label(42));
+}
+
+
+/// Run associative attribute assignment, lookup and extension benchmarks for a collection type.
+/// @tparam C collection type with service and context attributes.
+/// @param name storage name, prefixed to benchmark names.
+template<typename C>
+void bench_storage(std::string_view name)
+{
+    const std::string prefix {name};
+
+    run(prefix + " operator<<(KeyValue)", [] {
+        C coll;
+        coll << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+        keep(coll);
+    }, sizeof(C));
+
+    C coll;
+    coll << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+
+    run(prefix + " operator()(Tag, key)", [&] {
+        keep(coll(tag::context, "LID"));
+    }, sizeof(C));
+
+    run(prefix + " extend()", [] {
+        C base;
+        base << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU");
+        auto extended = extend_request(std::move(base));
+        keep(extended);
+    }, sizeof(decltype(extend_request(std::declval<C>()))));
+}
+
+void bench_storages()
+{
+    bench_storage<attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Flat<4>>>>("Flat<4>");
+
+    bench_storage<attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Keyed>>>("Keyed");
+
+    bench_storage<attr::PackedCollection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t>>>("Packed");
+
+    bench_storage<attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Fixed<ContextKeys>>>>("Fixed");
+
+    bench_storage<attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Interned<>>>>("Interned");
+}
+
+void bench_arena()
+{
+    using PmrContext = attr::KeyValue<tag::context_t, std::pair<std::string_view, std::pmr::string>>;
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t, std::pmr::string, attr::storage::pmr::Hashed>
+    >;
+
+    // The arena is released by every operation, so steady state allocates nothing globally
+    static char buffer[16384];
+    std::pmr::monotonic_buffer_resource arena {buffer, sizeof buffer};
+    const std::pmr::polymorphic_allocator<std::byte> allocator {&arena};
+
+    run("pmr arena operator<<(KeyValue)", [&] {
+        arena.release();
+        Coll coll {std::allocator_arg, allocator};
+        coll << PmrContext(std::allocator_arg, allocator, "LID", "FIINDEX:LUATTRUU")
+             << PmrContext(std::allocator_arg, allocator, "DFPATH", "anton-test.1");
+        keep(coll);
+    }, sizeof(Coll));
+
+    {
+        const std::pmr::polymorphic_allocator<std::byte> global {std::pmr::new_delete_resource()};
+        Coll coll {std::allocator_arg, global};
+        coll << Service("pisvc")
+             << PmrContext(std::allocator_arg, global, "LID", "FIINDEX:LUATTRUU")
+             << PmrContext(std::allocator_arg, global, "DFPATH", "anton-test.1");
+
+        run("pmr arena operator()(Tag, key)", [&] {
+            keep(coll(tag::context, "LID"));
+        }, sizeof(Coll));
+    }
+
+    run("pmr arena extend()", [&] {
+        arena.release();
+        Coll base {std::allocator_arg, allocator};
+        base << Service("pisvc") << PmrContext(std::allocator_arg, allocator, "LID", "FIINDEX:LUATTRUU");
+        auto extended = std::move(base).extend(PmrContext(std::allocator_arg, allocator, "HOST", "localhost"), Label(42));
+        keep(extended);
+    }, sizeof(decltype(std::declval<Coll>().extend(std::declval<PmrContext>(), Label(42)))));
+}
+
+
+void bench_async()
+{
+    using Async = attr::AsyncScope<
+        attr::Single<tag::id_t, true>,
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::pwho_t, false>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    Async outer {Id("id"), Service("pisvc"), Context("LID", "FIINDEX:LUATTRUU"), Context("DFPATH", "anton-test.1")};
+    Async inner {Label(42)};
+
+    run("AsyncScope::capture()", [] {
+        auto context = Async::capture();
+        keep(context);
+    }, sizeof(Async::context_type));
+
+    const auto context = Async::capture();
+    run("AsyncScope(context) install + restore", [&] {
+        Async installed {context};
+        keep(Async::get(tag::label));
+    }, sizeof(Async));
+}
+
+
+} // namespace
+} // namespace porter
+
+
+int main()
+{
+    porter::bench_assignment();
+    porter::bench_extension();
+    porter::bench_merge();
+    porter::bench_addition();
+    porter::bench_lookup();
+    porter::bench_storages();
+    porter::bench_arena();
+    porter::bench_async();
+    return 0;
+}
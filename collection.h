@@ -2,58 +2,131 @@
 
 #include "attribute.h"
 #include "holder.h"
+#include "instrument.h"
 
+#include <algorithm>
+#include <array>
 #include <tuple>
+#include <memory>
+#include <optional>
 #include <utility>
+#include <string_view>
 
 
 namespace porter::attr {
 namespace traits {
 
 
-/// Template that checks whether a type is contained within provided variadic pack.
-template<typename T, typename... Hs> struct contains : std::false_type {};
+/// Defines an entry of an index-based type map: a type at a position of a pack.
+template<size_t I, typename T> struct indexed
+{
+    using type = T;
 
-/// Template that checks whether a type is contained within provided variadic pack.
-/// Defines the check for a unit variadic pack.
-template<typename T, typename H> struct contains<T, H> : std::is_same<T, H> {};
+    static constexpr size_t index = I;
+};
 
-/// Template that checks whether a type is contained within provided variadic pack.
-/// Defines the check for non-unit variadic packs.
-template<typename T, typename H1, typename... Hs> struct contains<T, H1, Hs...>
+/// Template that maps positions of a pack onto its types, deriving from one entry per position.
+/// Lookups are resolved by deducing a base class, so they take no recursive instantiations.
+template<typename Idx, typename... Ts> struct type_map;
+
+/// Template that maps positions of a pack onto its types.
+/// Defines the map for a sequence of positions.
+template<size_t... Idx, typename... Ts> struct type_map<std::index_sequence<Idx...>, Ts...> : indexed<Idx, Ts>... {};
+
+/// Helper alias for the index-based type map of a pack.
+template<typename... Ts> using type_map_t = type_map<std::index_sequence_for<Ts...>, Ts...>;
+
+/// Look up a type map entry by position. Used in unevaluated contexts only.
+template<size_t I, typename T> indexed<I, T> entry_at(const indexed<I, T> &);
+
+/// Look up a type map entry by type. Used in unevaluated contexts only.
+/// Deduction fails if the type occurs more than once.
+template<typename T, size_t I> indexed<I, T> entry_of(const indexed<I, T> &);
+
+/// Helper alias for a type at a position of a pack.
+template<size_t I, typename... Ts> using type_at_t = typename decltype(entry_at<I>(std::declval<const type_map_t<Ts...> &>()))::type;
+
+
+/// Template that checks whether a type occurs exactly once in a type map.
+template<typename T, typename Map, typename = void> struct is_unique_in : std::false_type {};
+
+/// Template that checks whether a type occurs exactly once in a type map.
+/// Defines the check for types found by deduction.
+template<typename T, typename Map>
+struct is_unique_in<T, Map, std::void_t<decltype(entry_of<T>(std::declval<const Map &>()))>> : std::true_type {};
+
+
+/// Find the first set flag.
+/// @param flags array of flags.
+/// @param size number of flags.
+/// @return position of the first set flag, or flags size if none is set.
+constexpr size_t first_of(const bool *flags, size_t size)
 {
-    static constexpr bool value = contains<T, H1>::value || contains<T, Hs...>::value;
+    size_t idx = 0;
+    while (idx < size && !flags[idx])
+    {
+        ++idx;
+    }
+
+    return idx;
+}
+
+
+/// Template that finds position of a type within a type map.
+/// Evaluates to map size if the type is not found.
+/// Missing and duplicated types are searched for linearly.
+template<typename T, typename Map, typename = void> struct index_in;
+
+/// Template that finds position of a type within a type map.
+/// Defines linear search for missing and duplicated types.
+template<typename T, typename... Ts, size_t... Idx> struct index_in<T, type_map<std::index_sequence<Idx...>, Ts...>, void>
+{
+    static constexpr bool matches[] = {std::is_same_v<T, Ts>..., false};
+
+    static constexpr size_t value = first_of(matches, sizeof...(Ts));
 };
 
+/// Template that finds position of a type within a type map.
+/// Defines lookup of types occurring once, by deduction.
+template<typename T, typename Map>
+struct index_in<T, Map, std::void_t<decltype(entry_of<T>(std::declval<const Map &>()))>>
+{
+    static constexpr size_t value = decltype(entry_of<T>(std::declval<const Map &>()))::index;
+};
+
+
+/// Template that finds position of a type within provided variadic pack.
+/// Evaluates to pack size if the type is not found.
+template<typename T, typename... Hs> struct index_of : index_in<T, type_map_t<Hs...>>
+{
+};
+
+/// Helper variable for finding position of a type within a variadic pack.
+template<typename T, typename... Hs> inline constexpr size_t index_of_v = index_of<T, Hs...>::value;
+
+
+/// Template that checks whether a type is contained within provided variadic pack.
+template<typename T, typename... Hs> struct contains : std::bool_constant<(index_of_v<T, Hs...> < sizeof...(Hs))> {};
+
 /// Helper variable for checking whether a type is contained within a variadic pack.
 template<typename T, typename... Hs> inline constexpr bool contains_v = contains<T, Hs...>::value;
 
 
-/// Template that checks whether all holder types in a pack are valid.
-template<typename... Hs> struct are_holders_valid : std::true_type {};
-
-/// Template that checks whether all holder types in a pack are valid.
-/// Defines the check for non-empty packs.
-template<typename H, typename... Hs> struct are_holders_valid<H, Hs...>
+/// Template that checks whether all holder types in a pack are valid and have distinct tags.
+template<typename... Hs> struct are_holders_valid
+    : std::bool_constant<(true && ... && (is_valid_v<Hs> && is_unique_in<tag_of_t<Hs>, type_map_t<tag_of_t<Hs>...>>::value))>
 {
-    static constexpr bool value = is_valid_v<H> && !contains_v<H, Hs...> && are_holders_valid<Hs...>::value;
 };
 
-/// Helper variable for checking whether all holder types in a pacj are valid.
+/// Helper variable for checking whether all holder types in a pack are valid and have distinct tags.
 template<typename... Hs> inline constexpr bool are_holders_valid_v = are_holders_valid<Hs...>::value;
 
 
 /// Helper template that looks for a holder in a pack by a tag.
-template<typename Tag, typename... Hs> struct by_tag_impl { using type = void; };
-
-/// Helper template that looks for a holder in a pack by a tag.
-/// Defines lookup for non-empty packs.
-template<typename Tag, typename H, typename... Hs> struct by_tag_impl<Tag, H, Hs...>
+/// Evaluates to the first holder of the tag, or void if the pack has none.
+template<typename Tag, typename... Hs> struct by_tag_impl
 {
-    using type = std::conditional_t<
-        std::is_same_v<Tag, traits::tag_of_t<H>>,
-        H,
-        typename by_tag_impl<Tag, Hs...>::type>;
+    using type = type_at_t<index_of_v<Tag, tag_of_t<Hs>...>, Hs..., void>;
 };
 
 /// Template that looks for a holder in a pack by a tag.
@@ -68,32 +141,502 @@ template<typename Tag, typename... Hs> struct by_tag
 /// Helper variable for looking for a holder in a pack by a tag.
 template<typename Tag, typename... Hs> using by_tag_t = typename by_tag<Tag, Hs...>::type;
 
+/// Template that looks for a holder of a type parameterized by a pack of holders, by a tag.
+/// Evaluates to void if the type has no holder for the tag.
+template<typename Tag, typename T> struct find_tag { using type = void; };
 
-/// Template that extends a type with a pack of holders, ignoring duplicates.
-template<typename T, typename... New> struct extend;
+/// Template that looks for a holder of a type parameterized by a pack of holders, by a tag.
+/// Defines lookup for variadic templates.
+template<typename Tag, template<typename...> typename T, typename... Hs> struct find_tag<Tag, T<Hs...>>
+    : by_tag_impl<Tag, Hs...>
+{
+};
+
+/// Helper alias for looking for a holder of a type parameterized by a pack of holders, by a tag.
+template<typename Tag, typename T> using find_tag_t = typename find_tag<Tag, T>::type;
+
+
+/// Defines holder ordering key of collection storage: holders are sorted by decreasing alignment and size,
+/// so that strictly aligned holders are packed first and padding between holders is minimized.
+/// Ties are broken by tag name, so that storage layout does not depend on holder declaration order.
+struct LayoutKey
+{
+    /// Holder alignment.
+    size_t align;
+
+    /// Holder size.
+    size_t size;
+
+    /// Holder tag name.
+    std::string_view name;
+
+    /// Compare keys by decreasing alignment, decreasing size and tag name.
+    constexpr bool operator<(const LayoutKey &other) const
+    {
+        if (align != other.align)
+        {
+            return align > other.align;
+        }
+
+        if (size != other.size)
+        {
+            return size > other.size;
+        }
 
-/// Template that extends a type with a pack of holders, ignoring duplicates.
-/// Defines the operation for empty pack of holders.
-template<template<typename... > typename T, typename... Hs> struct extend<T<Hs...>> { using type = T<Hs...>; };
+        return name < other.name;
+    }
+};
+
+
+/// Compute a stable sorting permutation of keys.
+/// Keys are merge sorted bottom-up, so no recursive instantiations are required.
+/// @tparam Key ordering key type.
+/// @tparam N number of keys.
+/// @param keys ordering keys.
+/// @return key positions in sorted order.
+template<typename Key, size_t N>
+constexpr std::array<size_t, N> sort_order(const std::array<Key, N> &keys)
+{
+    std::array<size_t, N> order {};
+    std::array<size_t, N> merged {};
+
+    for (size_t idx = 0; idx < N; ++idx)
+    {
+        order[idx] = idx;
+    }
+
+    for (size_t width = 1; width < N; width *= 2)
+    {
+        for (size_t lo = 0; lo < N; lo += 2 * width)
+        {
+            const size_t mid = std::min(lo + width, N);
+            const size_t hi = std::min(lo + 2 * width, N);
+
+            size_t left = lo;
+            size_t right = mid;
+            for (size_t out = lo; out < hi; ++out)
+            {
+                // Ties are taken from the left run, keeping equal keys in position order
+                if (left < mid && (right == hi || !(keys[order[right]] < keys[order[left]])))
+                {
+                    merged[out] = order[left++];
+                }
+                else
+                {
+                    merged[out] = order[right++];
+                }
+            }
+        }
+
+        order = merged;
+    }
+
+    return order;
+}
 
-/// Template that extends a type with a pack of holders, ignoring duplicates.
-/// Defines the operation for a unit pack of holders.
-template<template<typename...> typename T, typename... Hs, typename New> struct extend<T<Hs...>, New>
+
+/// Template that selects types of a pack by a sequence of positions and wraps them into a template.
+template<template<typename...> typename T, typename Pack, typename Idx> struct select;
+
+/// Template that selects types of a pack by a sequence of positions and wraps them into a template.
+/// Defines selection from a tuple of types.
+template<template<typename...> typename T, typename... Hs, size_t... Idx>
+struct select<T, std::tuple<Hs...>, std::index_sequence<Idx...>>
 {
-    using type = std::conditional_t<contains_v<New, Hs...>, T<Hs...>, T<New, Hs...>>;
+    using type = T<type_at_t<Idx, Hs...>...>;
 };
 
-/// Template that extends a type with a pack of holders, ignoring duplicates.
-/// Defines the operation for a non-unit pack of holders.
-template<template<typename...> typename T, typename... Hs, typename N, typename... R> struct extend<T<Hs...>, N, R...>
+
+/// Template that reorders a pack of types by a permutation, keeping only its first Order::size positions.
+/// @tparam T template to wrap reordered types into.
+/// @tparam Order type with static constexpr permutation array `value` and its used length `size`.
+/// @tparam Hs pack of types.
+template<template<typename...> typename T, typename Order, typename... Hs> struct reorder
 {
-    using type = typename extend<typename extend<T<Hs...>, N>::type, R...>::type;
+    template<size_t... Idx>
+    static auto apply(std::index_sequence<Idx...>)
+        -> typename select<T, std::tuple<Hs...>, std::index_sequence<Order::value[Idx]...>>::type;
+
+    using type = decltype(apply(std::make_index_sequence<Order::size> {}));
+};
+
+
+/// Template that defines canonical ordering of a pack of holders: holders are sorted by tag name,
+/// and only the first declared holder of each tag is kept.
+template<typename... Hs> struct canonical_order
+{
+    static constexpr std::pair<std::array<size_t, sizeof...(Hs)>, size_t> unique = [] {
+        // The sort is stable, so holders of the same tag stay in declaration order
+        const std::array<std::string_view, sizeof...(Hs)> names {tag_of_t<Hs>::value...};
+        const std::array<size_t, sizeof...(Hs)> sorted = sort_order(names);
+
+        std::array<size_t, sizeof...(Hs)> order {};
+        size_t size = 0;
+        for (size_t pos = 0; pos < sorted.size(); ++pos)
+        {
+            if (pos == 0 || names[sorted[pos]] != names[sorted[pos - 1]])
+            {
+                order[size++] = sorted[pos];
+            }
+        }
+
+        return std::make_pair(order, size);
+    }();
+
+    static constexpr std::array<size_t, sizeof...(Hs)> value = unique.first;
+
+    static constexpr size_t size = unique.second;
+};
+
+/// Template that defines storage ordering of a pack of holders.
+template<typename... Hs> struct layout_order
+{
+    static constexpr std::array<size_t, sizeof...(Hs)> value =
+        sort_order(std::array<LayoutKey, sizeof...(Hs)> {LayoutKey {alignof(Hs), sizeof(Hs), tag_of_t<Hs>::value}...});
+
+    static constexpr size_t size = sizeof...(Hs);
 };
 
-/// Helper variable for extending a type with a pack of holders, ignoring duplicates.
+
+/// Template that defines canonical form of a type parameterized by a pack of holders:
+/// holders are sorted by tag name and later holders of an already present tag are dropped.
+template<typename T> struct canonical;
+
+/// Template that defines canonical form of a type parameterized by a pack of holders.
+/// Defines the operation for variadic templates.
+template<template<typename...> typename T, typename... Hs> struct canonical<T<Hs...>>
+{
+    using type = typename reorder<T, canonical_order<Hs...>, Hs...>::type;
+};
+
+/// Helper alias for canonical form of a type parameterized by a pack of holders.
+template<typename T> using canonical_t = typename canonical<T>::type;
+
+
+/// Template that defines holder type of an attribute value container within a type parameterized by a pack of holders:
+/// the existing holder of the attribute tag, so that its storage and allocator are kept,
+/// or the default holder of the container (see from) if there is none.
+/// Not defined for types other than attribute value containers, so that it fails in SFINAE contexts.
+template<typename Attr, typename T, typename = void> struct holder_for {};
+
+/// Template that defines holder type of an attribute value container within a type parameterized by a pack of holders.
+/// Defines the holder for attribute value containers.
+template<typename Attr, typename T> struct holder_for<Attr, T, std::void_t<from_t<Attr>>>
+{
+    using type = std::conditional_t<
+        std::is_void_v<find_tag_t<tag_of_t<from_t<Attr>>, T>>,
+        from_t<Attr>,
+        find_tag_t<tag_of_t<from_t<Attr>>, T>>;
+};
+
+/// Helper alias for holder type of an attribute value container within a type parameterized by a pack of holders.
+template<typename Attr, typename T> using holder_for_t = typename holder_for<Attr, T>::type;
+
+
+/// Template that checks whether two types parameterized by packs of holders hold the same holders in any order.
+/// Such types are distinct, but have the same canonical form.
+template<typename T, typename U> struct is_permutation : std::false_type {};
+
+/// Template that checks whether two types parameterized by packs of holders hold the same holders in any order.
+/// Defines the check for variadic templates.
+template<template<typename...> typename T, typename... Hs, typename... Us>
+struct is_permutation<T<Hs...>, T<Us...>>
+    : std::bool_constant<sizeof...(Hs) == sizeof...(Us) && std::is_same_v<canonical_t<T<Hs...>>, canonical_t<T<Us...>>>>
+{};
+
+/// Helper variable for checking whether two types parameterized by packs of holders hold the same holders.
+template<typename T, typename U> constexpr bool is_permutation_v = is_permutation<T, U>::value;
+
+
+/// Template that extends a type with a pack of holders, ignoring holders of already present tags.
+/// The result is in canonical form, so it does not depend on extension order;
+/// collections declared with the same holders in another order are distinct types (see is_permutation).
+template<typename T, typename... New> struct extend;
+
+/// Template that extends a type with a pack of holders, ignoring holders of already present tags.
+/// Defines the operation for variadic templates.
+template<template<typename...> typename T, typename... Hs, typename... New> struct extend<T<Hs...>, New...>
+{
+    using type = canonical_t<T<Hs..., New...>>;
+};
+
+/// Helper variable for extending a type with a pack of holders, ignoring holders of already present tags.
 template<typename T, typename... New> using extend_t = typename extend<T, New...>::type;
 
 
+/// Construct a holder, passing an allocator to it if the holder uses one (as std::tuple does with allocators).
+/// @tparam H holder type.
+/// @tparam Alloc allocator type.
+/// @tparam Args constructor argument types.
+/// @param allocator allocator for the holder.
+/// @param args constructor arguments.
+/// @return constructed holder.
+template<typename H, typename Alloc, typename... Args>
+H make_holder(const Alloc &allocator, Args &&...args)
+{
+    if constexpr (!std::uses_allocator_v<H, Alloc>)
+    {
+        return H(std::forward<Args>(args)...);
+    }
+    else if constexpr (std::is_constructible_v<H, std::allocator_arg_t, const Alloc &, Args...>)
+    {
+        return H(std::allocator_arg, allocator, std::forward<Args>(args)...);
+    }
+    else
+    {
+        return H(std::forward<Args>(args)..., allocator);
+    }
+}
+
+
+/// Defines storage of a single holder within a collection.
+/// Holders of a collection are unique, so a slot is addressed by its holder type.
+/// Updates take the matching slot of another storage, or nullptr if that storage has none (see find_slot),
+/// so their instantiations depend on the holder type only, not on both collections.
+template<typename H> struct slot
+{
+    H holder {};
+
+    /// Copy the holder from a slot of another storage.
+    /// @param source slot to copy from.
+    constexpr void copy(const slot *source)
+    {
+        instrument::copied<tag_of_t<H>>(source->holder);
+        holder = source->holder;
+    }
+
+    /// Move the holder from a slot of another storage.
+    /// @param source slot to move from.
+    constexpr void move(slot *source)
+    {
+        instrument::record<tag_of_t<H>>(instrument::Event::move);
+        holder = std::move(source->holder);
+    }
+
+    /// Merge the holder with a slot of another storage, copying its values.
+    /// @tparam Policy merge policy type.
+    /// @param source slot to merge with.
+    /// @param policy conflict resolution policy.
+    template<typename Policy>
+    void merge(const slot *source, const Policy &policy)
+    {
+        holder.merge(source->holder, policy);
+    }
+
+    /// Merge the holder with a slot of another storage, moving its values.
+    /// @tparam Policy merge policy type.
+    /// @param source slot to merge with.
+    /// @param policy conflict resolution policy.
+    template<typename Policy>
+    void merge(slot *source, const Policy &policy)
+    {
+        holder.merge(std::move(source->holder), policy);
+    }
+
+    /// Construct a holder as a copy of a slot of another storage.
+    /// @param source slot to copy from.
+    /// @return copied holder.
+    static constexpr H take(const slot *source)
+    {
+        instrument::copied<tag_of_t<H>>(source->holder);
+        return source->holder;
+    }
+
+    /// Construct a holder by moving from a slot of another storage, so that it keeps the source allocator.
+    /// @param source slot to move from.
+    /// @return moved holder.
+    static constexpr H take(slot *source)
+    {
+        instrument::record<tag_of_t<H>>(instrument::Event::move);
+        return std::move(source->holder);
+    }
+
+    /// Construct an empty holder, if another storage does not have one.
+    /// @return empty holder.
+    static constexpr H take(std::nullptr_t)
+    {
+        return H {};
+    }
+
+    /// Keep the holder intact, if another storage does not have one.
+    constexpr void copy(std::nullptr_t) {}
+
+    /// Keep the holder intact, if another storage does not have one.
+    constexpr void move(std::nullptr_t) {}
+
+    /// Keep the holder intact, if another storage does not have one.
+    template<typename Policy>
+    void merge(std::nullptr_t, const Policy &) {}
+};
+
+/// Look up a slot of a holder within a storage.
+/// @tparam H holder type.
+/// @param storage pointer to a storage having the holder.
+/// @return pointer to the slot.
+template<typename H> constexpr slot<H> *find_slot(slot<H> *storage) noexcept
+{
+    return storage;
+}
+
+/// Look up a slot of a holder within a storage.
+/// @tparam H holder type.
+/// @param storage pointer to a storage having the holder.
+/// @return pointer to the slot.
+template<typename H> constexpr const slot<H> *find_slot(const slot<H> *storage) noexcept
+{
+    return storage;
+}
+
+/// Look up a slot of a holder within a storage not having the holder.
+/// @tparam H holder type.
+/// @return nullptr.
+template<typename H> constexpr std::nullptr_t find_slot(const void *) noexcept
+{
+    return nullptr;
+}
+
+/// Template that stores a pack of holders, deriving from one slot per holder in pack order.
+/// Unlike std::tuple, access takes a single base conversion rather than recursion through the pack.
+template<typename... Hs> struct slots : slot<Hs>...
+{
+    /// Default ctor.
+    slots() = default;
+
+    /// Construct holders from another storage: common holders are copied or moved from it, other ones are empty.
+    /// @tparam Source source storage type, const for copies.
+    /// @param source pointer to source storage.
+    template<typename Source>
+    constexpr explicit slots(Source *source)
+        : slot<Hs> {slot<Hs>::take(find_slot<Hs>(source))}...
+    {
+    }
+
+    /// Construct empty holders, passing provided allocator to allocator-aware ones.
+    template<typename Alloc>
+    slots(std::allocator_arg_t, const Alloc &allocator)
+        : slot<Hs> {make_holder<Hs>(allocator)}...
+    {
+    }
+
+    /// Copy holders, passing provided allocator to allocator-aware ones.
+    template<typename Alloc>
+    slots(std::allocator_arg_t, const Alloc &allocator, const slots &other)
+        : slot<Hs> {make_holder<Hs>(allocator, static_cast<const slot<Hs> &>(other).holder)}...
+    {
+    }
+
+    /// Move holders, passing provided allocator to allocator-aware ones.
+    template<typename Alloc>
+    slots(std::allocator_arg_t, const Alloc &allocator, slots &&other)
+        : slot<Hs> {make_holder<Hs>(allocator, std::move(static_cast<slot<Hs> &>(other).holder))}...
+    {
+    }
+};
+
+/// Access a stored holder by type.
+template<typename H> constexpr H &get(slot<H> &storage) noexcept
+{
+    return storage.holder;
+}
+
+/// Access a stored holder by type.
+template<typename H> constexpr const H &get(const slot<H> &storage) noexcept
+{
+    return storage.holder;
+}
+
+/// Access a stored holder by type.
+template<typename H> constexpr H &&get(slot<H> &&storage) noexcept
+{
+    return std::move(storage.holder);
+}
+
+/// Helper alias for storage of a pack of holders, sorted by decreasing alignment and size.
+template<typename... Hs> using layout_t = typename reorder<slots, layout_order<Hs...>, Hs...>::type;
+
+
+/// Defines a node of a concatenation chain: the preceding chain and the attribute value container added to it.
+/// @tparam Prev preceding chain type, a collection or another node.
+/// @tparam Attr attribute value container type.
+template<typename Prev, typename Attr> struct link
+{
+    /// Stores the preceding chain.
+    Prev prev;
+
+    /// Stores the added attribute value container.
+    Attr attr;
+
+    /// Construct a node.
+    /// @tparam P preceding chain type.
+    /// @tparam A attribute value container type.
+    /// @param p preceding chain.
+    /// @param a attribute value container.
+    template<typename P, typename A>
+    constexpr link(P &&p, A &&a) : prev(std::forward<P>(p)), attr(std::forward<A>(a)) {}
+
+    /// Copy ctor. Copies members one by one rather than as a block with padding,
+    /// so that nodes built and consumed in one expression stay in registers.
+    constexpr link(const link &other) : prev(other.prev), attr(other.attr) {}
+
+    /// Move ctor. Moves members one by one, see the copy ctor.
+    constexpr link(link &&other) : prev(std::move(other.prev)), attr(std::move(other.attr)) {}
+};
+
+/// Template that checks whether a type is a concatenation chain node.
+template<typename T> struct is_link : std::false_type {};
+
+/// Template that checks whether a type is a concatenation chain node.
+/// Defines the check for nodes.
+template<typename Prev, typename Attr> struct is_link<link<Prev, Attr>> : std::true_type {};
+
+/// Helper variable for checking whether a type is a concatenation chain node.
+template<typename T> constexpr bool is_link_v = is_link<std::remove_const_t<T>>::value;
+
+/// Template that defines a concatenation chain of a collection and a pack of attribute value containers,
+/// nesting one node per container, so that appending moves the preceding chain as a single member.
+template<typename Chain, typename... Attrs> struct chain { using type = Chain; };
+
+/// Template that defines a concatenation chain of a collection and a pack of attribute value containers.
+/// Defines the chain for non-empty packs.
+template<typename Chain, typename Attr, typename... Attrs>
+struct chain<Chain, Attr, Attrs...> : chain<link<Chain, Attr>, Attrs...> {};
+
+/// Helper alias for a concatenation chain of a collection and a pack of attribute value containers.
+template<typename Chain, typename... Attrs> using chain_t = typename chain<Chain, Attrs...>::type;
+
+/// Access the collection a concatenation chain starts with.
+/// @tparam Chain chain type, auto-deduced.
+/// @param chain concatenation chain.
+/// @return reference to the collection.
+template<typename Chain> constexpr auto &chain_base(Chain &chain) noexcept
+{
+    if constexpr (is_link_v<Chain>)
+    {
+        return chain_base(chain.prev);
+    }
+    else
+    {
+        return chain;
+    }
+}
+
+/// Access attribute value containers of a concatenation chain.
+/// @tparam Chain chain type, auto-deduced.
+/// @param chain concatenation chain.
+/// @return tuple of references to attribute value containers, in addition order.
+template<typename Chain> constexpr auto chain_parts(Chain &chain) noexcept
+{
+    if constexpr (is_link_v<Chain>)
+    {
+        return std::tuple_cat(chain_parts(chain.prev), std::tie(chain.attr));
+    }
+    else
+    {
+        return std::tuple<> {};
+    }
+}
+
+
 } // namespace traits
 
 
@@ -108,31 +651,17 @@ class Collection
 
     static_assert(traits::are_holders_valid_v<Holders...>, "One or more holder types are not valid");
 
-    /// Stores attribute value holders.
-    std::tuple<Holders...> d_holders;
-
-private:
-    /// Update (copy) stored attribute value from another collection, if present.
-    /// @tparam Current attribute holder type to update.
-    /// @tparam Others attribute holder types of source collection.
-    /// @param other const reference to source collection.
-    template<typename Current, typename... Others>
-    void assign(const Collection<Others...> &other);
+    /// Stores attribute value holders, ordered by decreasing alignment and size (see traits::layout_t).
+    /// Holders are always accessed by type, so storage order is not observable.
+    traits::layout_t<Holders...> d_holders;
 
-    /// Update (move) stored attribute value from another collection, if present.
-    /// @tparam Current attribute holder type to update.
-    /// @tparam Others attribute holder types of source collection.
-    /// @param other rvalue reference to source collection.
-    template<typename Current, typename... Others>
-    void assign(Collection<Others...> &&other);
+public:
+    /// Checks whether any holder may own heap memory.
+    static constexpr bool dynamic = (false || ... || Holders::dynamic);
 
-    /// Check whether all contained attributes are in valid state.
-    /// @tparam Idx sequence of pack indices, auto-deduced.
-    /// @return true if all attributes are properly set.
-    template<size_t... Idx>
-    bool ready(std::index_sequence<Idx...>) const;
+    /// Defines collection size in bytes, fixed at compile time if no holder may own heap memory; 0 otherwise.
+    static constexpr size_t static_size = dynamic ? 0 : sizeof(traits::layout_t<Holders...>);
 
-public:
     /// Default ctor.
     Collection() = default;
 
@@ -151,28 +680,110 @@ public:
     /// Construct a collection from another by copying common attribute values.
     /// @tparam Others attribute holder types of source collection.
     /// @param other source collection.
-    template<typename... Others>
-    explicit Collection(const Collection<Others...> &other);
+    template<
+        typename... Others,
+        std::enable_if_t<!traits::is_permutation_v<Collection<Holders...>, Collection<Others...>>, int> = 0>
+    constexpr explicit Collection(const Collection<Others...> &other);
+
+    /// Construct a collection from another of the same holders in a different order, copying attribute values.
+    /// Not explicit, since no attribute values are lost.
+    /// @tparam Others attribute holder types of source collection, a permutation of Holders.
+    /// @param other source collection.
+    template<
+        typename... Others,
+        std::enable_if_t<traits::is_permutation_v<Collection<Holders...>, Collection<Others...>>, int> = 0>
+    constexpr Collection(const Collection<Others...> &other);
 
-    /// Construct a collection from another by moving common attribute values.
+    /// Construct a collection from another by moving common attribute holders, which keep their allocators.
     /// @tparam Others attribute holder types of source collection.
     /// @param other source collection.
-    template<typename... Others>
-    explicit Collection(Collection<Others...> &&other);
+    template<
+        typename... Others,
+        std::enable_if_t<!traits::is_permutation_v<Collection<Holders...>, Collection<Others...>>, int> = 0>
+    constexpr explicit Collection(Collection<Others...> &&other);
+
+    /// Construct a collection from another of the same holders in a different order, moving attribute holders.
+    /// Not explicit, since no attribute values are lost.
+    /// @tparam Others attribute holder types of source collection, a permutation of Holders.
+    /// @param other source collection.
+    template<
+        typename... Others,
+        std::enable_if_t<traits::is_permutation_v<Collection<Holders...>, Collection<Others...>>, int> = 0>
+    constexpr Collection(Collection<Others...> &&other);
+
+    /// Construct an empty collection, passing an allocator to allocator-aware holders.
+    /// @tparam Alloc allocator type, e.g. std::pmr::polymorphic_allocator.
+    /// @param allocator allocator for holder storage and values.
+    template<typename Alloc>
+    Collection(std::allocator_arg_t, const Alloc &allocator);
+
+    /// Copy a collection, passing an allocator to allocator-aware holders.
+    /// @tparam Alloc allocator type, e.g. std::pmr::polymorphic_allocator.
+    /// @param allocator allocator for holder storage and values.
+    /// @param other source collection.
+    template<typename Alloc>
+    Collection(std::allocator_arg_t, const Alloc &allocator, const Collection &other);
+
+    /// Move a collection, passing an allocator to allocator-aware holders.
+    /// @tparam Alloc allocator type, e.g. std::pmr::polymorphic_allocator.
+    /// @param allocator allocator for holder storage and values.
+    /// @param other source collection.
+    template<typename Alloc>
+    Collection(std::allocator_arg_t, const Alloc &allocator, Collection &&other);
+
+    /// Construct a collection from another by copying common attribute values,
+    /// passing an allocator to allocator-aware holders.
+    /// @tparam Alloc allocator type, e.g. std::pmr::polymorphic_allocator.
+    /// @tparam Others attribute holder types of source collection.
+    /// @param allocator allocator for holder storage and values.
+    /// @param other source collection.
+    template<typename Alloc, typename... Others>
+    Collection(std::allocator_arg_t, const Alloc &allocator, const Collection<Others...> &other);
+
+    /// Construct a collection from another by moving common attribute values,
+    /// passing an allocator to allocator-aware holders.
+    /// @tparam Alloc allocator type, e.g. std::pmr::polymorphic_allocator.
+    /// @tparam Others attribute holder types of source collection.
+    /// @param allocator allocator for holder storage and values.
+    /// @param other source collection.
+    template<typename Alloc, typename... Others>
+    Collection(std::allocator_arg_t, const Alloc &allocator, Collection<Others...> &&other);
 
     /// Copy-assign common attribute values from another collection.
     /// @tparam Others attribute holder types of source collection.
     /// @param other source collection.
     /// @return reference to self.
     template<typename... Others>
-    Collection<Holders...> &operator=(const Collection<Others...> &other);
+    constexpr Collection<Holders...> &operator=(const Collection<Others...> &other);
 
     /// Move-assign common attribute values from another collection.
     /// @tparam Others attribute holder types of source collection.
     /// @param other source collection.
     /// @return reference to self.
     template<typename... Others>
-    Collection<Holders...> &operator=(Collection<Others...> &&other);
+    constexpr Collection<Holders...> &operator=(Collection<Others...> &&other);
+
+    /// Merge (copy) common attribute values of another collection.
+    /// Unset attribute values are taken from the source, associative attributes get the union of both names;
+    /// conflicting attribute values are resolved by policy (see resolve()).
+    /// Custom policies are called for conflicts of every common holder, so they are typically generic lambdas.
+    /// @tparam Policy merge policy type: KeepLeft, KeepRight or a custom callable.
+    /// @tparam Others attribute holder types of source collection.
+    /// @param other source collection.
+    /// @param policy conflict resolution policy.
+    /// @return reference to self.
+    template<typename Policy = KeepRight, typename... Others>
+    Collection<Holders...> &merge(const Collection<Others...> &other, const Policy &policy = {});
+
+    /// Merge (move) common attribute values of another collection.
+    /// Hash map nodes of associative attributes are spliced rather than copied.
+    /// @tparam Policy merge policy type: KeepLeft, KeepRight or a custom callable.
+    /// @tparam Others attribute holder types of source collection.
+    /// @param other source collection, left with unspecified attribute values.
+    /// @param policy conflict resolution policy.
+    /// @return reference to self.
+    template<typename Policy = KeepRight, typename... Others>
+    Collection<Holders...> &merge(Collection<Others...> &&other, const Policy &policy = {});
 
     /// Update (copy) attribute value from Value container.
     /// @tparam Tag attribute tag type.
@@ -180,7 +791,7 @@ public:
     /// @param value attribute value container.
     /// @return reference to self.
     template<typename Tag, typename V>
-    Collection<Holders...> &operator<<(const Value<Tag, V> &value);
+    constexpr Collection<Holders...> &operator<<(const Value<Tag, V> &value);
 
     /// Update (move) attribute value from Value container.
     /// @tparam Tag attribute tag type.
@@ -188,7 +799,7 @@ public:
     /// @param value attribute value container.
     /// @return reference to self.
     template<typename Tag, typename V>
-    Collection<Holders...> &operator<<(Value<Tag, V> &&value);
+    constexpr Collection<Holders...> &operator<<(Value<Tag, V> &&value);
 
     /// Update (copy) attribute value from KeyValue container.
     /// @tparam Tag attribute tag type.
@@ -196,7 +807,7 @@ public:
     /// @param kv attribute value container.
     /// @return reference to self.
     template<typename Tag, typename V>
-    Collection<Holders...> &operator<<(const KeyValue<Tag, V> &kv);
+    constexpr Collection<Holders...> &operator<<(const KeyValue<Tag, V> &kv);
 
     /// Update (move) attribute value from KeyValue container.
     /// @tparam Tag attribute tag type.
@@ -204,213 +815,677 @@ public:
     /// @param kv attribute value container.
     /// @return reference to self.
     template<typename Tag, typename V>
-    Collection<Holders...> &operator<<(KeyValue<Tag, V> &&kv);
+    constexpr Collection<Holders...> &operator<<(KeyValue<Tag, V> &&kv);
 
     /// Construct a new collection by merging this one and a pack of attribute value containers.
     /// For duplicates, new attribute values take priority.
+    /// Attributes of present tags are stored in the existing holders, keeping their storage policies.
     /// @tparam New pack of attribute value containers.
     /// @param attributes pack of attribute value containers.
     /// @return new extended attribute value collection.
     template<typename... New>
-    traits::extend_t<Collection<Holders...>, traits::from_t<New>...> extend(New &&...attributes) &&;
+    constexpr traits::extend_t<Collection<Holders...>, traits::holder_for_t<New, Collection<Holders...>>...> extend(New &&...attributes) &&;
+
+    /// Construct a new collection by merging this one and a pack of attribute value containers,
+    /// passing an allocator to allocator-aware holders of the new collection.
+    /// For duplicates, new attribute values take priority.
+    /// Attributes of present tags are stored in the existing holders, keeping their storage policies.
+    /// @tparam Alloc allocator type, e.g. std::pmr::polymorphic_allocator.
+    /// @tparam New pack of attribute value containers.
+    /// @param allocator allocator for holder storage and values.
+    /// @param attributes pack of attribute value containers.
+    /// @return new extended attribute value collection.
+    template<typename Alloc, typename... New>
+    traits::extend_t<Collection<Holders...>, traits::holder_for_t<New, Collection<Holders...>>...> extend(
+        std::allocator_arg_t, const Alloc &allocator, New &&...attributes) &&;
 
     /// Checks whether all attribute values are properly set.
     /// @return true if all attribute values are properly set.
-    operator bool() const;
+    constexpr operator bool() const;
+
+    /// Get memory owned by the collection.
+    /// @return size of holder storage and heap memory owned by all holders.
+    MemoryUsage memory_usage() const;
+
+    /// Get attribute value holder.
+    /// @tparam H attribute holder type.
+    /// @return const reference to attribute holder.
+    template<typename H>
+    constexpr const H &holder() const &;
+
+    /// Get attribute value holder.
+    /// @tparam H attribute holder type.
+    /// @return reference to attribute holder.
+    template<typename H>
+    constexpr H &holder() &;
+
+    /// Take attribute value holder.
+    /// @tparam H attribute holder type.
+    /// @return rvalue reference to attribute holder.
+    template<typename H>
+    constexpr H &&holder() &&;
 
     /// Get attribute value or value storage.
     /// @tparam Tag attribute tag type.
     /// @tparam H attribute holder type, auto-deduced.
     /// @return attribute value or value storage reference.
     template<typename Tag, typename H = typename traits::by_tag_t<Tag, Holders...>>
-    const typename H::type &operator()(Tag) const;
+    constexpr const typename H::type &operator()(Tag) const;
 
     /// Get named attribute value for associative attributes (i.e. Multiple holder).
     /// @tparam Tag attribute tag type.
+    /// @tparam K attribute name type, anything the holder can look up by.
     /// @tparam H attribute holder type, auto-deduced.
     /// @param key attribute value name.
     /// @return attribute value reference or std::nullopt, if not found.
     template<
         typename Tag,
+        typename K,
         typename H = traits::by_tag_t<Tag, Holders...>,
         typename = std::void_t<typename H::key_type>>
-    typename H::mapped_type operator()(Tag, const typename H::key_type &key) const;
+    typename H::mapped_type operator()(Tag, const K &key) const;
+};
+
+
+/// Defines a lazy concatenation of a collection and a pack of attribute value containers.
+/// Produced by operator+, so that chains of additions compute their resulting collection type once
+/// and construct it in a single pass, instead of building an intermediate collection for every term.
+/// Stores only the collection and the containers (see traits::chain_t); attribute values are readable
+/// without materialization, later attribute values take priority.
+/// The resulting collection is only constructed by conversions, updates (operator<<) and holder access,
+/// which consume the concatenation.
+/// @tparam Base collection type the attribute values are added to.
+/// @tparam Attrs pack of attribute value container types.
+template<typename Base, typename... Attrs>
+class Concat
+{
+public:
+    /// Defines resulting collection type.
+    using type = traits::extend_t<Base, traits::holder_for_t<Attrs, Base>...>;
+
+private:
+    /// Stores the collection the attribute values are added to and the attribute value containers.
+    traits::chain_t<Base, Attrs...> d_chain;
+
+private:
+    /// Defines position of the last attribute value container of a tag.
+    /// Evaluates to pack size if there are no containers of the tag.
+    template<typename Tag>
+    static constexpr size_t last_of = [] {
+        constexpr bool matches[] = {std::is_same_v<Tag, traits::tag_of_t<Attrs>>..., false};
+
+        size_t last = sizeof...(Attrs);
+        for (size_t idx = 0; idx < sizeof...(Attrs); ++idx)
+        {
+            if (matches[idx])
+            {
+                last = idx;
+            }
+        }
+
+        return last;
+    }();
+
+    /// Check whether an attribute of the resulting collection is in valid state.
+    /// @tparam H attribute holder type.
+    /// @return true if the attribute would be properly set after materialization.
+    template<typename H>
+    constexpr bool ready() const;
+
+    /// Check whether all attributes of the resulting collection are in valid state.
+    /// @tparam Hs attribute holder types of the resulting collection, auto-deduced.
+    /// @return true if all attributes would be properly set after materialization.
+    template<typename... Hs>
+    constexpr bool ready(const Collection<Hs...> *) const;
+
+public:
+    /// Construct a concatenation by adding an attribute value container to a chain, in place.
+    /// @tparam Prev preceding chain type, the collection or the chain of a shorter concatenation.
+    /// @tparam Attr attribute value container type.
+    /// @param prev preceding chain.
+    /// @param attribute attribute value container.
+    template<typename Prev, typename Attr>
+    constexpr Concat(Prev &&prev, Attr &&attribute);
+
+    /// Construct a concatenation extended with a pack of attribute value containers.
+    /// @tparam New pack of attribute value containers.
+    /// @param attributes pack of attribute value containers to add.
+    /// @return concatenation of this one and the attribute value containers.
+    template<typename... New>
+    constexpr Concat<Base, Attrs..., New...> append(New &&...attributes) &&;
+
+    /// Materialize the resulting collection, extended with a pack of attribute value containers.
+    /// For duplicates, new attribute values take priority.
+    /// @tparam New pack of attribute value containers.
+    /// @param attributes pack of attribute value containers.
+    /// @return new extended attribute value collection.
+    template<typename... New>
+    constexpr traits::extend_t<type, traits::holder_for_t<New, type>...> extend(New &&...attributes) &&;
+
+    /// Materialize the resulting collection.
+    /// @return resulting collection with copied attribute values.
+    constexpr type collection() const &;
+
+    /// Materialize the resulting collection.
+    /// @return resulting collection with moved attribute values.
+    constexpr type collection() &&;
+
+    /// Materialize the resulting collection, or one of the same holders in a different order.
+    /// @tparam C target collection type, a permutation of type.
+    template<typename C, typename = std::enable_if_t<traits::is_permutation_v<C, type>>>
+    constexpr operator C() const &;
+
+    /// Materialize the resulting collection, or one of the same holders in a different order.
+    /// @tparam C target collection type, a permutation of type.
+    template<typename C, typename = std::enable_if_t<traits::is_permutation_v<C, type>>>
+    constexpr operator C() &&;
+
+    /// Checks whether all attribute values of the resulting collection are properly set.
+    /// @return true if all attribute values are properly set.
+    constexpr operator bool() const;
+
+    /// Update attribute value of the resulting collection, materializing it.
+    /// @tparam A attribute value container type, Value or KeyValue.
+    /// @param attribute attribute value container.
+    /// @return updated resulting collection.
+    template<typename A>
+    constexpr type operator<<(A &&attribute) &&;
+
+    /// Take attribute value holder of the resulting collection, materializing it.
+    /// @tparam H attribute holder type.
+    /// @return attribute holder with moved value.
+    template<typename H>
+    constexpr H holder() &&;
+
+    /// Get attribute value, without materialization. Value storage of associative attributes
+    /// (i.e. Multiple holder) is only accessible from a materialized collection.
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @return attribute value.
+    template<typename Tag, typename H = typename traits::find_tag_t<Tag, type>>
+    constexpr const typename H::type &operator()(Tag) const;
+
+    /// Get named attribute value for associative attributes (i.e. Multiple holder), without materialization.
+    /// @tparam Tag attribute tag type.
+    /// @tparam K attribute name type, anything convertible to std::string_view.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param key attribute value name.
+    /// @return attribute value reference or std::nullopt, if not found.
+    template<
+        typename Tag,
+        typename K,
+        typename H = traits::find_tag_t<Tag, type>,
+        typename = std::void_t<typename H::key_type>>
+    typename H::mapped_type operator()(Tag, const K &key) const;
 };
 
 
 /// Define addition for collections and attribute containers.
 template<typename... Holders, typename Tag, typename V>
-auto operator+(Collection<Holders...> &&collection, Value<Tag, V> &&attribute)
+constexpr Concat<Collection<Holders...>, Value<Tag, V>> operator+(Collection<Holders...> &&collection, Value<Tag, V> &&attribute)
 {
-    return std::move(collection).extend(std::move(attribute));
+    return {std::move(collection), std::move(attribute)};
 }
 
 /// Define addition for collections and attribute containers.
 template<typename Tag, typename V, typename... Holders>
-auto operator+(Value<Tag, V> &&attribute, Collection<Holders...> &&collection)
+constexpr auto operator+(Value<Tag, V> &&attribute, Collection<Holders...> &&collection)
 {
     return std::move(collection) + std::move(attribute);
 }
 
 /// Define addition for attribute containers.
 template<typename Tagl, typename Vl, typename Tagr, typename Vr>
-auto operator+(Value<Tagl, Vl> &&lhs, Value<Tagr, Vr> &&rhs)
+constexpr auto operator+(Value<Tagl, Vl> &&lhs, Value<Tagr, Vr> &&rhs)
 {
     return (Collection<> {} + std::move(lhs)) + std::move(rhs);
 }
 
 /// Define addition for collections and attribute containers.
 template<typename... Holders, typename Tag, typename V>
-auto operator+(Collection<Holders...> &&collection, KeyValue<Tag, V> &&attribute)
+constexpr Concat<Collection<Holders...>, KeyValue<Tag, V>> operator+(
+    Collection<Holders...> &&collection, KeyValue<Tag, V> &&attribute)
 {
-    return std::move(collection).extend(std::move(attribute));
+    return {std::move(collection), std::move(attribute)};
 }
 
 /// Define addition for collections and attribute containers.
 template<typename Tag, typename V, typename... Holders>
-auto operator+(KeyValue<Tag, V> &&attribute, Collection<Holders...> &&collection)
+constexpr auto operator+(KeyValue<Tag, V> &&attribute, Collection<Holders...> &&collection)
 {
     return std::move(collection) + std::move(attribute);
 }
 
 /// Define addition for attribute containers.
 template<typename Tagl, typename Vl, typename Tagr, typename Vr>
-auto operator+(KeyValue<Tagl, Vl> &&lhs, KeyValue<Tagr, Vr> &&rhs)
+constexpr auto operator+(KeyValue<Tagl, Vl> &&lhs, KeyValue<Tagr, Vr> &&rhs)
 {
     return (Collection<> {} + std::move(lhs)) + std::move(rhs);
 }
 
 /// Define addition for attribute containers.
 template<typename Tagl, typename Vl, typename Tagr, typename Vr>
-auto operator+(Value<Tagl, Vl> &&lhs, KeyValue<Tagr, Vr> &&rhs)
+constexpr auto operator+(Value<Tagl, Vl> &&lhs, KeyValue<Tagr, Vr> &&rhs)
 {
     return (Collection<> {} + std::move(lhs)) + std::move(rhs);
 }
 
 /// Define addition for attribute containers.
 template<typename Tagl, typename Vl, typename Tagr, typename Vr>
-auto operator+(KeyValue<Tagl, Vl> &&lhs, Value<Tagr, Vr> &&rhs)
+constexpr auto operator+(KeyValue<Tagl, Vl> &&lhs, Value<Tagr, Vr> &&rhs)
 {
     return std::move(rhs) + std::move(lhs);
 }
 
+/// Define addition for concatenations and attribute containers.
+template<typename Base, typename... Attrs, typename Tag, typename V>
+constexpr auto operator+(Concat<Base, Attrs...> &&concat, Value<Tag, V> &&attribute)
+{
+    return std::move(concat).append(std::move(attribute));
+}
+
+/// Define addition for concatenations and attribute containers.
+template<typename Tag, typename V, typename Base, typename... Attrs>
+constexpr auto operator+(Value<Tag, V> &&attribute, Concat<Base, Attrs...> &&concat)
+{
+    return std::move(concat) + std::move(attribute);
+}
+
+/// Define addition for concatenations and attribute containers.
+template<typename Base, typename... Attrs, typename Tag, typename V>
+constexpr auto operator+(Concat<Base, Attrs...> &&concat, KeyValue<Tag, V> &&attribute)
+{
+    return std::move(concat).append(std::move(attribute));
+}
+
+/// Define addition for concatenations and attribute containers.
+template<typename Tag, typename V, typename Base, typename... Attrs>
+constexpr auto operator+(KeyValue<Tag, V> &&attribute, Concat<Base, Attrs...> &&concat)
+{
+    return std::move(concat) + std::move(attribute);
+}
+
 
 
 template<typename... Holders>
-template<typename Current, typename... Others>
-void Collection<Holders...>::assign(const Collection<Others...> &other)
+template<
+    typename... Others,
+    std::enable_if_t<!traits::is_permutation_v<Collection<Holders...>, Collection<Others...>>, int>>
+constexpr Collection<Holders...>::Collection(const Collection<Others...> &other)
+    : d_holders(&other.d_holders)
 {
-    if constexpr (traits::contains_v<Current, Others...>)
-    {
-        std::get<Current>(d_holders) = std::get<Current>(other.d_holders);
-    }
+    instrument::record(instrument::Event::conversion);
 }
 
 template<typename... Holders>
-template<typename Current, typename... Others>
-void Collection<Holders...>::assign(Collection<Others...> &&other)
+template<
+    typename... Others,
+    std::enable_if_t<traits::is_permutation_v<Collection<Holders...>, Collection<Others...>>, int>>
+constexpr Collection<Holders...>::Collection(const Collection<Others...> &other)
+    : d_holders(&other.d_holders)
 {
-    if constexpr (traits::contains_v<Current, Others...>)
-    {
-        std::get<Current>(d_holders) = std::get<Current>(std::move(other.d_holders));
-    }
+    instrument::record(instrument::Event::conversion);
 }
 
 template<typename... Holders>
-template<size_t... Idx> bool Collection<Holders...>::ready(std::index_sequence<Idx...>) const
+template<
+    typename... Others,
+    std::enable_if_t<!traits::is_permutation_v<Collection<Holders...>, Collection<Others...>>, int>>
+constexpr Collection<Holders...>::Collection(Collection<Others...> &&other)
+    : d_holders(&other.d_holders)
 {
-    return (true && ... && bool(std::get<Idx>(d_holders)));
+    instrument::record(instrument::Event::conversion);
 }
 
+template<typename... Holders>
+template<
+    typename... Others,
+    std::enable_if_t<traits::is_permutation_v<Collection<Holders...>, Collection<Others...>>, int>>
+constexpr Collection<Holders...>::Collection(Collection<Others...> &&other)
+    : d_holders(&other.d_holders)
+{
+    instrument::record(instrument::Event::conversion);
+}
 
 template<typename... Holders>
-template<typename... Others>
-Collection<Holders...>::Collection(const Collection<Others...> &other)
+template<typename Alloc>
+Collection<Holders...>::Collection(std::allocator_arg_t, const Alloc &allocator)
+    : d_holders(std::allocator_arg, allocator)
 {
-    (assign<Holders>(other), ...);
 }
 
 template<typename... Holders>
-template<typename... Others>
-Collection<Holders...>::Collection(Collection<Others...> &&other)
+template<typename Alloc>
+Collection<Holders...>::Collection(std::allocator_arg_t, const Alloc &allocator, const Collection &other)
+    : d_holders(std::allocator_arg, allocator, other.d_holders)
+{
+}
+
+template<typename... Holders>
+template<typename Alloc>
+Collection<Holders...>::Collection(std::allocator_arg_t, const Alloc &allocator, Collection &&other)
+    : d_holders(std::allocator_arg, allocator, std::move(other.d_holders))
 {
-    (assign<Holders>(std::move(other)), ...);
+}
+
+template<typename... Holders>
+template<typename Alloc, typename... Others>
+Collection<Holders...>::Collection(std::allocator_arg_t, const Alloc &allocator, const Collection<Others...> &other)
+    : d_holders(std::allocator_arg, allocator)
+{
+    instrument::record(instrument::Event::conversion);
+    (static_cast<traits::slot<Holders> &>(d_holders).copy(traits::find_slot<Holders>(&other.d_holders)), ...);
+}
+
+template<typename... Holders>
+template<typename Alloc, typename... Others>
+Collection<Holders...>::Collection(std::allocator_arg_t, const Alloc &allocator, Collection<Others...> &&other)
+    : d_holders(std::allocator_arg, allocator)
+{
+    instrument::record(instrument::Event::conversion);
+    (static_cast<traits::slot<Holders> &>(d_holders).move(traits::find_slot<Holders>(&other.d_holders)), ...);
 }
 
 template<typename... Holders>
 template<typename... Others>
-Collection<Holders...> &Collection<Holders...>::operator=(const Collection<Others...> &other)
+constexpr Collection<Holders...> &Collection<Holders...>::operator=(const Collection<Others...> &other)
 {
-    (assign<Holders>(other), ...);
+    instrument::record(instrument::Event::conversion);
+    (static_cast<traits::slot<Holders> &>(d_holders).copy(traits::find_slot<Holders>(&other.d_holders)), ...);
+    return *this;
 }
 
 template<typename... Holders>
 template<typename... Others>
-Collection<Holders...> &Collection<Holders...>::operator=(Collection<Others...> &&other)
+constexpr Collection<Holders...> &Collection<Holders...>::operator=(Collection<Others...> &&other)
 {
-    (assign<Holders>(std::move(other)), ...);
+    instrument::record(instrument::Event::conversion);
+    (static_cast<traits::slot<Holders> &>(d_holders).move(traits::find_slot<Holders>(&other.d_holders)), ...);
+    return *this;
+}
+
+template<typename... Holders>
+template<typename Policy, typename... Others>
+Collection<Holders...> &Collection<Holders...>::merge(const Collection<Others...> &other, const Policy &policy)
+{
+    (static_cast<traits::slot<Holders> &>(d_holders).merge(traits::find_slot<Holders>(&other.d_holders), policy), ...);
+    return *this;
+}
+
+template<typename... Holders>
+template<typename Policy, typename... Others>
+Collection<Holders...> &Collection<Holders...>::merge(Collection<Others...> &&other, const Policy &policy)
+{
+    (static_cast<traits::slot<Holders> &>(d_holders).merge(traits::find_slot<Holders>(&other.d_holders), policy), ...);
+    return *this;
 }
 
 template<typename... Holders>
 template<typename Tag, typename V>
-Collection<Holders...> &Collection<Holders...>::operator<<(const Value<Tag, V> &value)
+constexpr Collection<Holders...> &Collection<Holders...>::operator<<(const Value<Tag, V> &value)
 {
-    std::get<traits::by_tag_t<Tag, Holders...>>(d_holders) = value;
+    traits::get<traits::by_tag_t<Tag, Holders...>>(d_holders) = value;
     return *this;
 }
 
 template<typename... Holders>
 template<typename Tag, typename V>
-Collection<Holders...> &Collection<Holders...>::operator<<(Value<Tag, V> &&value)
+constexpr Collection<Holders...> &Collection<Holders...>::operator<<(Value<Tag, V> &&value)
 {
-    std::get<traits::by_tag_t<Tag, Holders...>>(d_holders) = std::move(value);
+    traits::get<traits::by_tag_t<Tag, Holders...>>(d_holders) = std::move(value);
     return *this;
 }
 
 template<typename... Holders>
 template<typename Tag, typename V>
-Collection<Holders...> &Collection<Holders...>::operator<<(const KeyValue<Tag, V> &kv)
+constexpr Collection<Holders...> &Collection<Holders...>::operator<<(const KeyValue<Tag, V> &kv)
 {
-    std::get<traits::by_tag_t<Tag, Holders...>>(d_holders) = kv;
+    traits::get<traits::by_tag_t<Tag, Holders...>>(d_holders) = kv;
     return *this;
 }
 
 template<typename... Holders>
 template<typename Tag, typename V>
-Collection<Holders...> &Collection<Holders...>::operator<<(KeyValue<Tag, V> &&kv)
+constexpr Collection<Holders...> &Collection<Holders...>::operator<<(KeyValue<Tag, V> &&kv)
 {
-    std::get<traits::by_tag_t<Tag, Holders...>>(d_holders) = std::move(kv);
+    traits::get<traits::by_tag_t<Tag, Holders...>>(d_holders) = std::move(kv);
     return *this;
 }
 
 template<typename... Holders>
 template<typename... New>
-traits::extend_t<Collection<Holders...>, traits::from_t<New>...> Collection<Holders...>::extend(New &&...attributes) &&
+constexpr traits::extend_t<Collection<Holders...>, traits::holder_for_t<New, Collection<Holders...>>...> Collection<Holders...>::extend(New &&...attributes) &&
+{
+    traits::extend_t<Collection<Holders...>, traits::holder_for_t<New, Collection<Holders...>>...> extended {std::move(*this)};
+    instrument::record(instrument::Event::extension);
+    static_cast<void>((extended << ... << std::forward<New>(attributes)));
+
+    return extended;
+}
+
+template<typename... Holders>
+template<typename Alloc, typename... New>
+traits::extend_t<Collection<Holders...>, traits::holder_for_t<New, Collection<Holders...>>...> Collection<Holders...>::extend(
+    std::allocator_arg_t, const Alloc &allocator, New &&...attributes) &&
 {
-    traits::extend_t<Collection<Holders...>, traits::from_t<New>...> extended {std::move(*this)};
-    (extended << ... << std::forward<New>(attributes));
+    traits::extend_t<Collection<Holders...>, traits::holder_for_t<New, Collection<Holders...>>...> extended {
+        std::allocator_arg, allocator, std::move(*this)};
+    instrument::record(instrument::Event::extension);
+    static_cast<void>((extended << ... << std::forward<New>(attributes)));
 
     return extended;
 }
 
 template<typename... Holders>
-Collection<Holders...>::operator bool() const
+constexpr Collection<Holders...>::operator bool() const
 {
-    return ready(std::index_sequence_for<Holders...> {});
+    return (true && ... && bool(traits::get<Holders>(d_holders)));
+}
+
+template<typename... Holders>
+MemoryUsage Collection<Holders...>::memory_usage() const
+{
+    MemoryUsage usage {sizeof(d_holders), 0};
+    ((usage.heap_bytes += traits::get<Holders>(d_holders).memory_usage().heap_bytes), ...);
+
+    return usage;
+}
+
+template<typename... Holders>
+template<typename H>
+constexpr const H &Collection<Holders...>::holder() const &
+{
+    return traits::get<H>(d_holders);
+}
+
+template<typename... Holders>
+template<typename H>
+constexpr H &Collection<Holders...>::holder() &
+{
+    return traits::get<H>(d_holders);
+}
+
+template<typename... Holders>
+template<typename H>
+constexpr H &&Collection<Holders...>::holder() &&
+{
+    return traits::get<H>(std::move(d_holders));
 }
 
 template<typename... Holders>
 template<typename Tag, typename H>
-const typename H::type &Collection<Holders...>::operator()(Tag) const
+constexpr const typename H::type &Collection<Holders...>::operator()(Tag) const
 {
-    return *std::get<traits::by_tag_t<Tag, Holders...>>(d_holders);
+    return *traits::get<traits::by_tag_t<Tag, Holders...>>(d_holders);
 }
 
 template<typename... Holders>
-template<typename Tag, typename H, typename>
-typename H::mapped_type Collection<Holders...>::operator()(Tag, const typename H::key_type &key) const
+template<typename Tag, typename K, typename H, typename>
+typename H::mapped_type Collection<Holders...>::operator()(Tag, const K &key) const
 {
-    return std::get<traits::by_tag_t<Tag, Holders...>>(d_holders)(key);
+    return traits::get<traits::by_tag_t<Tag, Holders...>>(d_holders)(key);
+}
+
+
+
+template<typename Base, typename... Attrs>
+template<typename H>
+constexpr bool Concat<Base, Attrs...>::ready() const
+{
+    using Tag = traits::tag_of_t<H>;
+    constexpr size_t last = last_of<Tag>;
+
+    if constexpr (!traits::is_required_v<H>)
+    {
+        return true;
+    }
+    else if constexpr (last < sizeof...(Attrs) && std::is_same_v<H, traits::find_tag_t<Tag, type>>)
+    {
+        return (*std::get<last>(traits::chain_parts(d_chain))).has_value();
+    }
+    else if constexpr (std::is_same_v<H, traits::find_tag_t<Tag, Base>>)
+    {
+        return bool(traits::chain_base(d_chain).template holder<H>());
+    }
+    else
+    {
+        return false;
+    }
+}
+
+template<typename Base, typename... Attrs>
+template<typename... Hs>
+constexpr bool Concat<Base, Attrs...>::ready(const Collection<Hs...> *) const
+{
+    return (true && ... && ready<Hs>());
+}
+
+
+template<typename Base, typename... Attrs>
+template<typename Prev, typename Attr>
+constexpr Concat<Base, Attrs...>::Concat(Prev &&prev, Attr &&attribute)
+    : d_chain {std::forward<Prev>(prev), std::forward<Attr>(attribute)}
+{
+}
+
+template<typename Base, typename... Attrs>
+template<typename... New>
+constexpr Concat<Base, Attrs..., New...> Concat<Base, Attrs...>::append(New &&...attributes) &&
+{
+    if constexpr (sizeof...(New) == 0)
+    {
+        return std::move(*this);
+    }
+    else
+    {
+        // Containers are linked one by one, each node moves the preceding chain as a whole
+        return [&](auto &&first, auto &&...rest) {
+            Concat<Base, Attrs..., std::tuple_element_t<0, std::tuple<New...>>> appended {
+                std::move(d_chain), std::forward<decltype(first)>(first)};
+            return std::move(appended).append(std::forward<decltype(rest)>(rest)...);
+        }(std::forward<New>(attributes)...);
+    }
+}
+
+template<typename Base, typename... Attrs>
+template<typename... New>
+constexpr traits::extend_t<typename Concat<Base, Attrs...>::type, traits::holder_for_t<New, typename Concat<Base, Attrs...>::type>...> Concat<Base, Attrs...>::extend(
+    New &&...attributes) &&
+{
+    return std::apply(
+        [&](Attrs &...parts) {
+            return std::move(traits::chain_base(d_chain)).extend(std::move(parts)..., std::forward<New>(attributes)...);
+        },
+        traits::chain_parts(d_chain));
+}
+
+template<typename Base, typename... Attrs>
+constexpr typename Concat<Base, Attrs...>::type Concat<Base, Attrs...>::collection() const &
+{
+    return Concat<Base, Attrs...> {*this}.collection();
+}
+
+template<typename Base, typename... Attrs>
+constexpr typename Concat<Base, Attrs...>::type Concat<Base, Attrs...>::collection() &&
+{
+    return std::move(*this).extend();
+}
+
+template<typename Base, typename... Attrs>
+template<typename C, typename>
+constexpr Concat<Base, Attrs...>::operator C() const &
+{
+    return C {collection()};
+}
+
+template<typename Base, typename... Attrs>
+template<typename C, typename>
+constexpr Concat<Base, Attrs...>::operator C() &&
+{
+    return C {std::move(*this).collection()};
+}
+
+template<typename Base, typename... Attrs>
+constexpr Concat<Base, Attrs...>::operator bool() const
+{
+    return ready(static_cast<const type *>(nullptr));
+}
+
+template<typename Base, typename... Attrs>
+template<typename A>
+constexpr typename Concat<Base, Attrs...>::type Concat<Base, Attrs...>::operator<<(A &&attribute) &&
+{
+    type collection = std::move(*this).collection();
+    collection << std::forward<A>(attribute);
+    return collection;
+}
+
+template<typename Base, typename... Attrs>
+template<typename H>
+constexpr H Concat<Base, Attrs...>::holder() &&
+{
+    return std::move(*this).collection().template holder<H>();
+}
+
+template<typename Base, typename... Attrs>
+template<typename Tag, typename H>
+constexpr const typename H::type &Concat<Base, Attrs...>::operator()(Tag) const
+{
+    static_assert(!traits::is_multiple_v<H>, "Value storage is only accessible from a materialized collection");
+
+    if constexpr (constexpr size_t last = last_of<Tag>; last < sizeof...(Attrs))
+    {
+        return *std::get<last>(traits::chain_parts(d_chain));
+    }
+    else
+    {
+        return traits::chain_base(d_chain)(Tag {});
+    }
+}
+
+template<typename Base, typename... Attrs>
+template<typename Tag, typename K, typename H, typename>
+typename H::mapped_type Concat<Base, Attrs...>::operator()(Tag, const K &key) const
+{
+    typename H::mapped_type found;
+
+    if constexpr (!std::is_same_v<void, traits::find_tag_t<Tag, Base>>)
+    {
+        found = traits::chain_base(d_chain)(Tag {}, key);
+    }
+
+    auto match = [&](const auto &part) {
+        if constexpr (std::is_same_v<Tag, traits::tag_of_t<std::decay_t<decltype(part)>>>)
+        {
+            if (*part && std::string_view((*part)->first) == std::string_view(key))
+            {
+                found = std::cref((*part)->second);
+            }
+        }
+    };
+    std::apply([&](const Attrs &...parts) { (match(parts), ...); }, traits::chain_parts(d_chain));
+
+    return found;
 }
 
 
@@ -0,0 +1,101 @@
+// Measures template instantiation cost of collections with large holder packs.
+// Build with -DPORTER_ATTR_BENCH_HOLDERS=N (16 by default) and time the compilation, see README.md.
+
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+
+#ifndef PORTER_ATTR_BENCH_HOLDERS
+#define PORTER_ATTR_BENCH_HOLDERS 16
+#endif
+
+
+namespace porter {
+namespace tag {
+
+
+/// Defines a generated tag name: "t" followed by decimal digits of the tag number.
+template<size_t I>
+struct bench_name
+{
+    static constexpr size_t digits = [] {
+        size_t digits = 1;
+        for (size_t value = I; value >= 10; value /= 10)
+        {
+            ++digits;
+        }
+        return digits;
+    }();
+
+    static constexpr auto chars = [] {
+        struct { char data[digits + 1]; } chars {};
+        chars.data[0] = 't';
+        size_t value = I;
+        for (size_t idx = digits; idx > 0; --idx, value /= 10)
+        {
+            chars.data[idx] = char('0' + value % 10);
+        }
+        return chars;
+    }();
+};
+
+/// Defines generated tags.
+template<size_t I>
+struct bench_t
+{
+    using type = uint32_t;
+    static constexpr std::string_view value {bench_name<I>::chars.data, bench_name<I>::digits + 1};
+};
+
+
+} // namespace tag
+
+
+/// Defines a collection of N generated holders.
+template<typename Idx> struct bench_collection;
+
+/// Defines a collection of N generated holders.
+template<size_t... Idx> struct bench_collection<std::index_sequence<Idx...>>
+{
+    using type = attr::Collection<attr::Single<tag::bench_t<Idx>, true>...>;
+};
+
+using Holders = std::make_index_sequence<PORTER_ATTR_BENCH_HOLDERS>;
+using Coll = bench_collection<Holders>::type;
+
+
+/// Set and read every tag: validation, then one tag lookup per tag for assignment and access.
+template<size_t... Idx>
+uint32_t fill(Coll &coll, std::index_sequence<Idx...>)
+{
+    (coll << ... << attr::Value<tag::bench_t<Idx>> {uint32_t(Idx)});
+    return (0 + ... + *coll(tag::bench_t<Idx> {}));
+}
+
+/// Extend the collection with every tag again, canonicalizing and deduplicating the holder pack.
+template<size_t... Idx>
+auto extend(Coll &&coll, std::index_sequence<Idx...>)
+{
+    return std::move(coll).extend(attr::Value<tag::bench_t<Idx>> {uint32_t(Idx + 1)}...);
+}
+
+
+} // namespace porter
+
+
+int main()
+{
+    porter::Coll coll;
+    const uint32_t sum = porter::fill(coll, porter::Holders {});
+    assert( sum == PORTER_ATTR_BENCH_HOLDERS * (PORTER_ATTR_BENCH_HOLDERS - 1) / 2 );
+
+    auto extended = porter::extend(std::move(coll), porter::Holders {});
+    assert( *extended(porter::tag::bench_t<0> {}) == 1 );
+
+    return 0;
+}
@@ -0,0 +1,638 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "serialize.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+namespace porter::attr {
+
+
+/// Defines a kind of attribute change between two collections.
+enum class Change : uint8_t
+{
+    /// Attribute values are equal.
+    none,
+
+    /// Attribute value was set (or associative attribute got its first named values).
+    added,
+
+    /// Attribute value was changed (or some named values were added, changed or removed).
+    changed,
+
+    /// Attribute value was cleared (or associative attribute lost all named values).
+    removed,
+};
+
+
+namespace traits {
+
+
+/// Template that defines removal record of a holder in a delta.
+/// Single holders record whether their value was cleared.
+template<typename H, typename = void> struct removed { using type = bool; };
+
+/// Defines removal record of associative holders: names of removed values.
+template<typename H> struct removed<H, std::void_t<typename H::key_type>>
+{
+    using type = std::vector<typename H::key_type>;
+};
+
+/// Helper alias for removal record of a holder in a delta.
+template<typename H> using removed_t = typename removed<H>::type;
+
+
+} // namespace traits
+
+
+template<typename... Holders> class Delta;
+
+/// Compute changes that turn one collection into another.
+/// Holders missing from the source collection are treated as unset, holders missing from the target are ignored.
+/// @tparam From attribute holder types of the source collection.
+/// @tparam To attribute holder types of the target collection.
+/// @param from source collection.
+/// @param to target collection.
+/// @return changes; refers to attribute names of both collections, so it must not outlive them.
+template<typename... From, typename... To>
+Delta<To...> diff(const Collection<From...> &from, const Collection<To...> &to);
+
+
+/// Defines changes between two collections: added and changed attribute values, cleared attributes
+/// and per-name changes of associative attributes.
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class Delta
+{
+    template<typename... From, typename... To>
+    friend Delta<To...> diff(const Collection<From...> &from, const Collection<To...> &to);
+
+    /// Stores added and changed attribute values, including named values.
+    Collection<Holders...> d_values;
+
+    /// Stores removal records of holders.
+    std::tuple<traits::removed_t<Holders>...> d_removed;
+
+    /// Stores change kinds of holders.
+    std::array<Change, sizeof...(Holders)> d_changes {};
+
+public:
+    /// Construct an empty delta.
+    Delta() = default;
+
+    /// Check whether there are no changes.
+    bool empty() const;
+
+    /// Get change kind of an attribute.
+    /// @tparam Tag attribute tag type.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    Change change(Tag) const;
+
+    /// Get added and changed attribute values, including named values of associative attributes.
+    const Collection<Holders...> &values() const;
+
+    /// Get removal record of an attribute.
+    /// @tparam Tag attribute tag type.
+    /// @return whether the value was cleared, or names of removed values of associative attributes.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    const traits::removed_t<H> &removed(Tag) const;
+
+    /// Apply changes to a collection.
+    /// @param collection collection to update, normally equal to the source collection of the delta.
+    void apply(Collection<Holders...> &collection) const;
+
+    /// Append encoded changes to a buffer: a record count followed by records of tag id, operation and payload.
+    /// @param out output buffer.
+    void encode(std::string &out) const;
+};
+
+
+/// Defines encoder of collection streams, that sends changes against the previously sent collection.
+/// The reference collection is a copy, so views it holds (string values, names) must outlive the next encode().
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class DeltaEncoder
+{
+    /// Stores the previously sent collection.
+    Collection<Holders...> d_reference;
+
+public:
+    /// Construct an encoder with an empty reference collection.
+    DeltaEncoder() = default;
+
+    /// Append encoded changes to a buffer and make the collection the reference.
+    /// @param collection next collection of the stream.
+    /// @param out output buffer.
+    void encode(const Collection<Holders...> &collection, std::string &out);
+
+    /// Get the reference collection.
+    const Collection<Holders...> &reference() const;
+};
+
+
+/// Defines decoder of collection streams, that applies received changes to the previous collection.
+/// Decoded names and string values are copied into storage owned by the decoder,
+/// so collections of string views do not refer to received buffers.
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class DeltaDecoder
+{
+    /// Defines storage of decoded strings of a holder: a string for single values,
+    /// or names and values for each name of associative attributes.
+    template<typename H>
+    using backing_t = std::conditional_t<
+        traits::is_multiple_v<H>,
+        std::unordered_map<std::string, std::string>,
+        std::string>;
+
+    /// Stores the current collection.
+    Collection<Holders...> d_collection;
+
+    /// Stores decoded strings referred to by the current collection.
+    std::tuple<backing_t<Holders>...> d_backing;
+
+private:
+    /// Check whether encoded changes are well-formed and refer to known attributes.
+    /// @param frame encoded changes.
+    static bool valid(std::string_view frame);
+
+    /// Apply a well-formed encoded change record of a holder.
+    /// @tparam H attribute holder type.
+    /// @param op operation.
+    /// @param record record payload, advanced past the record.
+    template<typename H>
+    void apply(uint8_t op, std::string_view &record);
+
+public:
+    /// Construct a decoder with an empty collection.
+    DeltaDecoder() = default;
+
+    /// Not copyable: the collection refers to decoder storage.
+    DeltaDecoder(const DeltaDecoder &) = delete;
+
+    /// Not copyable: the collection refers to decoder storage.
+    DeltaDecoder &operator=(const DeltaDecoder &) = delete;
+
+    /// Apply encoded changes to the current collection.
+    /// @param frame encoded changes.
+    /// @return false if changes are malformed, in which case the collection is not changed.
+    bool decode(std::string_view frame);
+
+    /// Get the current collection.
+    const Collection<Holders...> &collection() const;
+};
+
+
+namespace wire {
+
+
+/// Defines operations of encoded change records.
+enum Op : uint8_t
+{
+    /// Set a single attribute value: followed by the value block.
+    set = 0,
+
+    /// Clear a single attribute value.
+    reset = 1,
+
+    /// Set a named value: followed by name and value blocks.
+    set_key = 2,
+
+    /// Remove a named value: followed by the name block.
+    erase_key = 3,
+};
+
+
+/// Append a length-prefixed block to a buffer.
+/// @param out output buffer.
+/// @param block block contents.
+void put_block(std::string &out, std::string_view block);
+
+/// Append a length-prefixed encoded value to a buffer.
+/// @tparam V attribute value type.
+/// @param out output buffer.
+/// @param value attribute value.
+template<typename V>
+void put_value(std::string &out, const V &value);
+
+
+} // namespace wire
+
+
+
+template<typename... From, typename... To>
+Delta<To...> diff(const Collection<From...> &from, const Collection<To...> &to)
+{
+    Delta<To...> delta;
+    size_t idx = 0;
+
+    auto compare = [&](auto tag) {
+        using Tag = decltype(tag);
+        using H = traits::by_tag_t<Tag, To...>;
+        using F = traits::find_tag_t<Tag, Collection<From...>>;
+
+        static_assert(
+            std::is_void_v<F> || std::is_same_v<F, H>,
+            "Common attributes of compared collections must have the same holder types");
+
+        Change &change = delta.d_changes[idx++];
+
+        if constexpr (traits::is_multiple_v<H>)
+        {
+            const auto &next = *to.template holder<H>();
+            bool modified = false;
+
+            for (const auto &[key, value] : next)
+            {
+                typename H::mapped_type prev;
+                if constexpr (!std::is_void_v<F>)
+                {
+                    prev = from(tag, key);
+                }
+
+                if (!prev || !(prev->get() == value))
+                {
+                    delta.d_values << KeyValue<Tag, std::pair<typename H::key_type, typename H::value_type>> {key, value};
+                    modified = true;
+                }
+            }
+
+            if constexpr (!std::is_void_v<F>)
+            {
+                const auto &prev = *from.template holder<F>();
+                auto &removed = std::get<traits::index_of_v<H, To...>>(delta.d_removed);
+
+                for (const auto &entry : prev)
+                {
+                    if (!to(tag, entry.first))
+                    {
+                        removed.push_back(entry.first);
+                    }
+                }
+
+                if (prev.empty() && !next.empty())
+                {
+                    change = Change::added;
+                }
+                else if (!prev.empty() && next.empty())
+                {
+                    change = Change::removed;
+                }
+                else if (modified || !removed.empty())
+                {
+                    change = Change::changed;
+                }
+            }
+            else if (!next.empty())
+            {
+                change = Change::added;
+            }
+        }
+        else
+        {
+            const auto &next = to(tag);
+
+            typename H::type prev;
+            if constexpr (!std::is_void_v<F>)
+            {
+                prev = from(tag);
+            }
+
+            if (next && !prev)
+            {
+                change = Change::added;
+            }
+            else if (next && !(*prev == *next))
+            {
+                change = Change::changed;
+            }
+            else if (!next && prev)
+            {
+                change = Change::removed;
+                std::get<traits::index_of_v<H, To...>>(delta.d_removed) = true;
+            }
+
+            if (change == Change::added || change == Change::changed)
+            {
+                delta.d_values << Value<Tag, typename H::value_type> {*next};
+            }
+        }
+    };
+    (compare(traits::tag_of_t<To> {}), ...);
+
+    return delta;
+}
+
+
+template<typename... Holders>
+bool Delta<Holders...>::empty() const
+{
+    for (Change change : d_changes)
+    {
+        if (change != Change::none)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+Change Delta<Holders...>::change(Tag) const
+{
+    return d_changes[traits::index_of_v<H, Holders...>];
+}
+
+template<typename... Holders>
+const Collection<Holders...> &Delta<Holders...>::values() const
+{
+    return d_values;
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+const traits::removed_t<H> &Delta<Holders...>::removed(Tag) const
+{
+    return std::get<traits::index_of_v<H, Holders...>>(d_removed);
+}
+
+template<typename... Holders>
+void Delta<Holders...>::apply(Collection<Holders...> &collection) const
+{
+    auto update = [&](auto tag) {
+        using Tag = decltype(tag);
+        using H = traits::by_tag_t<Tag, Holders...>;
+
+        H &holder = collection.template holder<H>();
+
+        if constexpr (traits::is_multiple_v<H>)
+        {
+            for (const auto &key : removed(tag))
+            {
+                holder.erase(key);
+            }
+
+            for (const auto &[key, value] : d_values(tag))
+            {
+                holder = KeyValue<Tag, std::pair<typename H::key_type, typename H::value_type>> {key, value};
+            }
+        }
+        else if (removed(tag))
+        {
+            holder.reset();
+        }
+        else if (const auto &value = d_values(tag))
+        {
+            holder = Value<Tag, typename H::value_type> {*value};
+        }
+    };
+    (update(traits::tag_of_t<Holders> {}), ...);
+}
+
+template<typename... Holders>
+void Delta<Holders...>::encode(std::string &out) const
+{
+    const size_t prefix = out.size();
+    wire::put(out, uint32_t(0));
+
+    uint32_t records = 0;
+    auto record = [&](auto tag, wire::Op op) {
+        wire::put(out, wire::tag_id<decltype(tag)>);
+        wire::put(out, uint8_t(op));
+        ++records;
+    };
+
+    auto put = [&](auto tag) {
+        using Tag = decltype(tag);
+        using H = traits::by_tag_t<Tag, Holders...>;
+
+        if constexpr (traits::is_multiple_v<H>)
+        {
+            for (const auto &key : removed(tag))
+            {
+                record(tag, wire::erase_key);
+                wire::put_block(out, key);
+            }
+
+            for (const auto &[key, value] : d_values(tag))
+            {
+                record(tag, wire::set_key);
+                wire::put_block(out, key);
+                wire::put_value(out, value);
+            }
+        }
+        else if (removed(tag))
+        {
+            record(tag, wire::reset);
+        }
+        else if (const auto &value = d_values(tag))
+        {
+            record(tag, wire::set);
+            wire::put_value(out, *value);
+        }
+    };
+    (put(traits::tag_of_t<Holders> {}), ...);
+
+    wire::put(out, prefix, records);
+}
+
+
+template<typename... Holders>
+void DeltaEncoder<Holders...>::encode(const Collection<Holders...> &collection, std::string &out)
+{
+    const Delta<Holders...> delta = diff(d_reference, collection);
+    delta.encode(out);
+    delta.apply(d_reference);
+}
+
+template<typename... Holders>
+const Collection<Holders...> &DeltaEncoder<Holders...>::reference() const
+{
+    return d_reference;
+}
+
+
+template<typename... Holders>
+bool DeltaDecoder<Holders...>::valid(std::string_view frame)
+{
+    std::optional<uint32_t> records = wire::get<uint32_t>(frame);
+    if (!records)
+    {
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < *records; ++idx)
+    {
+        std::optional<uint32_t> id = wire::get<uint32_t>(frame);
+        std::optional<uint8_t> op = id ? wire::get<uint8_t>(frame) : std::nullopt;
+        if (!op)
+        {
+            return false;
+        }
+
+        bool known = false;
+        auto check = [&](auto tag) {
+            using Tag = decltype(tag);
+            using H = traits::by_tag_t<Tag, Holders...>;
+
+            if (known || *id != wire::tag_id<Tag>)
+            {
+                return;
+            }
+
+            std::optional<std::string_view> value;
+            if constexpr (traits::is_multiple_v<H>)
+            {
+                std::optional<std::string_view> key = wire::block(frame);
+                known = key && *op == wire::erase_key;
+
+                if (key && *op == wire::set_key)
+                {
+                    value = wire::block(frame);
+                }
+            }
+            else
+            {
+                known = *op == wire::reset;
+
+                if (*op == wire::set)
+                {
+                    value = wire::block(frame);
+                }
+            }
+
+            known = known || (value && Codec<typename H::value_type>::valid(*value));
+        };
+        (check(traits::tag_of_t<Holders> {}), ...);
+
+        if (!known)
+        {
+            return false;
+        }
+    }
+
+    return frame.empty();
+}
+
+template<typename... Holders>
+template<typename H>
+void DeltaDecoder<Holders...>::apply(uint8_t op, std::string_view &record)
+{
+    using Tag = traits::tag_of_t<H>;
+    using V = typename H::value_type;
+
+    H &holder = d_collection.template holder<H>();
+    auto &backing = std::get<traits::index_of_v<H, Holders...>>(d_backing);
+
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        const std::string_view key = *wire::block(record);
+
+        if (op == wire::erase_key)
+        {
+            holder.erase(key);
+            backing.erase(std::string {key});
+            return;
+        }
+
+        const auto value = Codec<V>::decode(*wire::block(record));
+        auto &[name, text] = *backing.try_emplace(std::string {key}).first;
+
+        if constexpr (std::is_same_v<V, std::string_view>)
+        {
+            text.assign(value);
+            holder = KeyValue<Tag, std::pair<std::string_view, V>> {std::string_view {name}, std::string_view {text}};
+        }
+        else
+        {
+            holder = KeyValue<Tag, std::pair<std::string_view, V>> {std::string_view {name}, V(value)};
+        }
+    }
+    else if (op == wire::reset)
+    {
+        holder.reset();
+    }
+    else
+    {
+        const auto value = Codec<V>::decode(*wire::block(record));
+
+        if constexpr (std::is_same_v<V, std::string_view>)
+        {
+            backing.assign(value);
+            holder = Value<Tag, V> {std::string_view {backing}};
+        }
+        else
+        {
+            holder = Value<Tag, V> {V(value)};
+        }
+    }
+}
+
+template<typename... Holders>
+bool DeltaDecoder<Holders...>::decode(std::string_view frame)
+{
+    if (!valid(frame))
+    {
+        return false;
+    }
+
+    const uint32_t records = *wire::get<uint32_t>(frame);
+    for (uint32_t idx = 0; idx < records; ++idx)
+    {
+        const uint32_t id = *wire::get<uint32_t>(frame);
+        const uint8_t op = *wire::get<uint8_t>(frame);
+
+        bool applied = false;
+        auto dispatch = [&](auto tag) {
+            using Tag = decltype(tag);
+
+            if (!applied && id == wire::tag_id<Tag>)
+            {
+                apply<traits::by_tag_t<Tag, Holders...>>(op, frame);
+                applied = true;
+            }
+        };
+        (dispatch(traits::tag_of_t<Holders> {}), ...);
+    }
+
+    return true;
+}
+
+template<typename... Holders>
+const Collection<Holders...> &DeltaDecoder<Holders...>::collection() const
+{
+    return d_collection;
+}
+
+
+inline void wire::put_block(std::string &out, std::string_view block)
+{
+    put(out, uint32_t(block.size()));
+    out.append(block);
+}
+
+template<typename V>
+void wire::put_value(std::string &out, const V &value)
+{
+    const size_t prefix = out.size();
+    put(out, uint32_t(0));
+    Codec<V>::encode(out, value);
+    put(out, prefix, uint32_t(out.size() - prefix - sizeof(uint32_t)));
+}
+
+
+} // namespace porter::attr
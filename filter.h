@@ -0,0 +1,605 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "batch.h"
+#include "symbol.h"
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if !defined(PORTER_ATTR_NO_SIMD) && defined(__AVX2__)
+#include <immintrin.h>
+#define PORTER_ATTR_SIMD_AVX2 1
+#elif !defined(PORTER_ATTR_NO_SIMD) && defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PORTER_ATTR_SIMD_NEON 1
+#endif
+
+
+namespace porter::attr {
+
+
+/// Defines a set of selected batch rows as a bitmap, bit i % 64 of word i / 64 is set if row i is selected.
+class Selection
+{
+    /// Stores bitmap words.
+    std::vector<uint64_t> d_words;
+
+    /// Stores number of rows.
+    size_t d_size = 0;
+
+private:
+    /// Clear bits past the last row.
+    void trim();
+
+public:
+    /// Construct a selection.
+    /// @param size number of rows.
+    /// @param selected whether all rows are selected.
+    explicit Selection(size_t size = 0, bool selected = false);
+
+    /// Get number of rows.
+    size_t size() const;
+
+    /// Get number of selected rows.
+    size_t count() const;
+
+    /// Check whether a row is selected.
+    /// @param row row index.
+    bool test(size_t row) const;
+
+    /// Get bitmap words.
+    const uint64_t *words() const;
+
+    /// Get bitmap words.
+    uint64_t *words();
+
+    /// Intersect with another selection of the same size.
+    Selection &operator&=(const Selection &other);
+
+    /// Unite with another selection of the same size.
+    Selection &operator|=(const Selection &other);
+
+    /// Get a complement selection.
+    Selection operator~() const;
+
+    /// Call a function with the index of every selected row, in increasing order.
+    /// @tparam F function type, callable with size_t.
+    /// @param function function to call.
+    template<typename F>
+    void for_each(F &&function) const;
+
+    /// Intersect selections of the same size.
+    friend Selection operator&(Selection lhs, const Selection &rhs) { return lhs &= rhs; }
+
+    /// Unite selections of the same size.
+    friend Selection operator|(Selection lhs, const Selection &rhs) { return lhs |= rhs; }
+};
+
+
+namespace filter {
+
+
+/// Get bits of a 64-bit value compared by identity (see traits::is_wide_comparable).
+/// @tparam V value type.
+/// @param value value.
+/// @return value bits.
+template<typename V>
+int64_t bits_of(const V &value);
+
+/// Select rows with values in [lo, hi] range.
+/// AVX2 and NEON kernels are used for 32-bit integer values if available; other values are compared one by one.
+/// @tparam V value type.
+/// @param data values.
+/// @param size number of values.
+/// @param lo lower bound (inclusive).
+/// @param hi upper bound (inclusive).
+/// @param out output bitmap words, overwritten.
+template<typename V>
+void select_range(const V *data, size_t size, V lo, V hi, uint64_t *out);
+
+/// Select rows with values in a set.
+/// AVX2 and NEON kernels are used for 32-bit and 64-bit integer values and interned strings if available;
+/// other values are compared one by one.
+/// @tparam V value type.
+/// @param data values.
+/// @param size number of values.
+/// @param set set values.
+/// @param count number of set values.
+/// @param out output bitmap words, overwritten.
+template<typename V>
+void select_any(const V *data, size_t size, const V *set, size_t count, uint64_t *out);
+
+
+/// Defines a predicate that matches rows with a value equal to a constant.
+/// @tparam Tag attribute tag type.
+template<typename Tag>
+struct Equal
+{
+    /// Matched value.
+    typename Tag::type value;
+
+    /// Evaluate the predicate over values.
+    /// Interned string columns are matched by symbol identity. The value is looked up without interning it,
+    /// so that queries don't grow the symbol table; values that were never interned match no rows.
+    template<typename V>
+    void operator()(const V *data, size_t size, uint64_t *out) const
+    {
+        if constexpr (traits::is_interned_v<V>)
+        {
+            const std::optional<Symbol> symbol = V::table().find(value);
+            const V match = symbol ? V {*symbol} : V {};
+            select_any<V>(data, size, &match, symbol ? 1 : 0, out);
+        }
+        else
+        {
+            select_range<V>(data, size, value, value, out);
+        }
+    }
+};
+
+/// Defines a predicate that matches rows with a value in [lo, hi] range.
+/// @tparam Tag attribute tag type.
+template<typename Tag>
+struct Between
+{
+    /// Lower bound (inclusive).
+    typename Tag::type lo;
+
+    /// Upper bound (inclusive).
+    typename Tag::type hi;
+
+    /// Evaluate the predicate over values.
+    template<typename V>
+    void operator()(const V *data, size_t size, uint64_t *out) const { select_range<V>(data, size, lo, hi, out); }
+};
+
+/// Defines a predicate that matches rows with a value in a set.
+/// @tparam Tag attribute tag type.
+template<typename Tag>
+struct In
+{
+    /// Matched values.
+    std::vector<typename Tag::type> values;
+
+    /// Evaluate the predicate over values.
+    /// Interned string columns are matched by symbol identity of the values that were interned, see Equal.
+    template<typename V>
+    void operator()(const V *data, size_t size, uint64_t *out) const
+    {
+        if constexpr (traits::is_interned_v<V>)
+        {
+            std::vector<V> set;
+            set.reserve(values.size());
+            for (const auto &value : values)
+            {
+                if (std::optional<Symbol> symbol = V::table().find(value))
+                {
+                    set.emplace_back(*symbol);
+                }
+            }
+
+            select_any<V>(data, size, set.data(), set.size(), out);
+        }
+        else
+        {
+            select_any<V>(data, size, values.data(), values.size(), out);
+        }
+    }
+};
+
+/// Defines a predicate that matches rows with a set value.
+/// @tparam Tag attribute tag type.
+template<typename Tag>
+struct Present {};
+
+/// Defines a predicate that matches rows without a set value.
+/// @tparam Tag attribute tag type.
+template<typename Tag>
+struct Missing {};
+
+
+/// Create a predicate that matches rows with a value equal to a constant.
+template<typename Tag>
+Equal<Tag> equal(Tag, typename Tag::type value) { return {value}; }
+
+/// Create a predicate that matches rows with a value in [lo, hi] range.
+template<typename Tag>
+Between<Tag> between(Tag, typename Tag::type lo, typename Tag::type hi) { return {lo, hi}; }
+
+/// Create a predicate that matches rows with a value in a set.
+template<typename Tag>
+In<Tag> in(Tag, std::initializer_list<typename Tag::type> values) { return {values}; }
+
+/// Create a predicate that matches rows with a set value.
+template<typename Tag>
+Present<Tag> present(Tag) { return {}; }
+
+/// Create a predicate that matches rows without a set value.
+template<typename Tag>
+Missing<Tag> missing(Tag) { return {}; }
+
+
+} // namespace filter
+
+
+namespace traits {
+
+
+/// Template that defines tag type of a filter predicate.
+template<typename P> struct predicate_tag;
+
+/// Defines tag type of a filter predicate.
+template<template<typename> typename P, typename Tag> struct predicate_tag<P<Tag>> { using type = Tag; };
+
+/// Helper alias for tag type of a filter predicate.
+template<typename P> using predicate_tag_t = typename predicate_tag<P>::type;
+
+
+/// Template that checks whether values are 64 bits wide and equal if and only if their bits are equal,
+/// i.e. 64-bit integers and interned strings, so that they can be compared with SIMD kernels.
+template<typename V> struct is_wide_comparable
+    : std::bool_constant<sizeof(V) == 8 && std::is_trivially_copyable_v<V> && (std::is_integral_v<V> || is_interned_v<V>)>
+{
+};
+
+/// Helper variable for checking whether values are 64 bits wide and compared by their bits.
+template<typename V> inline constexpr bool is_wide_comparable_v = is_wide_comparable<V>::value;
+
+
+} // namespace traits
+
+
+/// Select batch rows that match all predicates.
+/// Value predicates never match rows without a set value; use filter::missing() to match such rows.
+/// @tparam Holders attribute holder types of the batch.
+/// @tparam Predicates predicate types.
+/// @param batch batch of collections.
+/// @param predicates predicates over single attribute values.
+/// @return selected rows.
+template<typename... Holders, typename... Predicates>
+Selection select(const CollectionBatch<Holders...> &batch, const Predicates &...predicates);
+
+
+
+inline Selection::Selection(size_t size, bool selected)
+    : d_words((size + 63) / 64, selected ? ~uint64_t(0) : 0)
+    , d_size(size)
+{
+    trim();
+}
+
+inline void Selection::trim()
+{
+    if (d_size % 64)
+    {
+        d_words.back() &= (uint64_t(1) << (d_size % 64)) - 1;
+    }
+}
+
+inline size_t Selection::size() const
+{
+    return d_size;
+}
+
+inline size_t Selection::count() const
+{
+    size_t count = 0;
+    for (uint64_t word : d_words)
+    {
+        count += __builtin_popcountll(word);
+    }
+
+    return count;
+}
+
+inline bool Selection::test(size_t row) const
+{
+    return d_words[row / 64] >> (row % 64) & 1;
+}
+
+inline const uint64_t *Selection::words() const
+{
+    return d_words.data();
+}
+
+inline uint64_t *Selection::words()
+{
+    return d_words.data();
+}
+
+inline Selection &Selection::operator&=(const Selection &other)
+{
+    for (size_t idx = 0; idx < d_words.size(); ++idx)
+    {
+        d_words[idx] &= other.d_words[idx];
+    }
+
+    return *this;
+}
+
+inline Selection &Selection::operator|=(const Selection &other)
+{
+    for (size_t idx = 0; idx < d_words.size(); ++idx)
+    {
+        d_words[idx] |= other.d_words[idx];
+    }
+
+    return *this;
+}
+
+inline Selection Selection::operator~() const
+{
+    Selection complement = *this;
+    for (uint64_t &word : complement.d_words)
+    {
+        word = ~word;
+    }
+
+    complement.trim();
+    return complement;
+}
+
+template<typename F>
+void Selection::for_each(F &&function) const
+{
+    for (size_t idx = 0; idx < d_words.size(); ++idx)
+    {
+        for (uint64_t word = d_words[idx]; word; word &= word - 1)
+        {
+            function(idx * 64 + size_t(__builtin_ctzll(word)));
+        }
+    }
+}
+
+
+template<typename V>
+int64_t filter::bits_of(const V &value)
+{
+    static_assert(sizeof(V) == sizeof(int64_t), "Value is not 64 bits wide");
+
+    int64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+template<typename V>
+void filter::select_range(const V *data, size_t size, V lo, V hi, uint64_t *out)
+{
+    size_t row = 0;
+
+#if PORTER_ATTR_SIMD_AVX2
+    if constexpr (std::is_integral_v<V> && sizeof(V) == 4)
+    {
+        const __m256i vlo = _mm256_set1_epi32(int32_t(lo));
+        const __m256i vhi = _mm256_set1_epi32(int32_t(hi));
+
+        for (; row + 8 <= size; row += 8)
+        {
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + row));
+
+            __m256i matched;
+            if constexpr (std::is_signed_v<V>)
+            {
+                matched = _mm256_and_si256(
+                    _mm256_cmpeq_epi32(_mm256_max_epi32(values, vlo), values),
+                    _mm256_cmpeq_epi32(_mm256_min_epi32(values, vhi), values));
+            }
+            else
+            {
+                matched = _mm256_and_si256(
+                    _mm256_cmpeq_epi32(_mm256_max_epu32(values, vlo), values),
+                    _mm256_cmpeq_epi32(_mm256_min_epu32(values, vhi), values));
+            }
+
+            const uint64_t bits = uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(matched)));
+            if (row % 64 == 0)
+            {
+                out[row / 64] = 0;
+            }
+            out[row / 64] |= bits << (row % 64);
+        }
+    }
+#elif PORTER_ATTR_SIMD_NEON
+    if constexpr (std::is_integral_v<V> && sizeof(V) == 4)
+    {
+        static constexpr uint32_t weights[] = {1, 2, 4, 8};
+        const uint32x4_t vweights = vld1q_u32(weights);
+
+        for (; row + 4 <= size; row += 4)
+        {
+            uint32x4_t matched;
+            if constexpr (std::is_signed_v<V>)
+            {
+                const int32x4_t values = vld1q_s32(reinterpret_cast<const int32_t *>(data + row));
+                matched = vandq_u32(vcgeq_s32(values, vdupq_n_s32(lo)), vcleq_s32(values, vdupq_n_s32(hi)));
+            }
+            else
+            {
+                const uint32x4_t values = vld1q_u32(reinterpret_cast<const uint32_t *>(data + row));
+                matched = vandq_u32(vcgeq_u32(values, vdupq_n_u32(lo)), vcleq_u32(values, vdupq_n_u32(hi)));
+            }
+
+            const uint64_t bits = vaddvq_u32(vandq_u32(matched, vweights));
+            if (row % 64 == 0)
+            {
+                out[row / 64] = 0;
+            }
+            out[row / 64] |= bits << (row % 64);
+        }
+    }
+#endif
+
+    for (; row < size; ++row)
+    {
+        if (row % 64 == 0)
+        {
+            out[row / 64] = 0;
+        }
+        out[row / 64] |= uint64_t(lo <= data[row] && data[row] <= hi) << (row % 64);
+    }
+}
+
+template<typename V>
+void filter::select_any(const V *data, size_t size, const V *set, size_t count, uint64_t *out)
+{
+    size_t row = 0;
+
+#if PORTER_ATTR_SIMD_AVX2
+    if constexpr (std::is_integral_v<V> && sizeof(V) == 4)
+    {
+        for (; row + 8 <= size; row += 8)
+        {
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + row));
+
+            __m256i matched = _mm256_setzero_si256();
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                matched = _mm256_or_si256(matched, _mm256_cmpeq_epi32(values, _mm256_set1_epi32(int32_t(set[idx]))));
+            }
+
+            const uint64_t bits = uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(matched)));
+            if (row % 64 == 0)
+            {
+                out[row / 64] = 0;
+            }
+            out[row / 64] |= bits << (row % 64);
+        }
+    }
+    else if constexpr (traits::is_wide_comparable_v<V>)
+    {
+        for (; row + 4 <= size; row += 4)
+        {
+            const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + row));
+
+            __m256i matched = _mm256_setzero_si256();
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                matched = _mm256_or_si256(matched, _mm256_cmpeq_epi64(values, _mm256_set1_epi64x(bits_of(set[idx]))));
+            }
+
+            const uint64_t bits = uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(matched)));
+            if (row % 64 == 0)
+            {
+                out[row / 64] = 0;
+            }
+            out[row / 64] |= bits << (row % 64);
+        }
+    }
+#elif PORTER_ATTR_SIMD_NEON
+    if constexpr (std::is_integral_v<V> && sizeof(V) == 4)
+    {
+        static constexpr uint32_t weights[] = {1, 2, 4, 8};
+        const uint32x4_t vweights = vld1q_u32(weights);
+
+        for (; row + 4 <= size; row += 4)
+        {
+            const uint32x4_t values = vld1q_u32(reinterpret_cast<const uint32_t *>(data + row));
+
+            uint32x4_t matched = vdupq_n_u32(0);
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                matched = vorrq_u32(matched, vceqq_u32(values, vdupq_n_u32(uint32_t(set[idx]))));
+            }
+
+            const uint64_t bits = vaddvq_u32(vandq_u32(matched, vweights));
+            if (row % 64 == 0)
+            {
+                out[row / 64] = 0;
+            }
+            out[row / 64] |= bits << (row % 64);
+        }
+    }
+    else if constexpr (traits::is_wide_comparable_v<V>)
+    {
+        for (; row + 2 <= size; row += 2)
+        {
+            const uint64x2_t values = vld1q_u64(reinterpret_cast<const uint64_t *>(data + row));
+
+            uint64x2_t matched = vdupq_n_u64(0);
+            for (size_t idx = 0; idx < count; ++idx)
+            {
+                matched = vorrq_u64(matched, vceqq_u64(values, vdupq_n_u64(uint64_t(bits_of(set[idx])))));
+            }
+
+            const uint64_t bits = (vgetq_lane_u64(matched, 0) & 1) | (vgetq_lane_u64(matched, 1) & 2);
+            if (row % 64 == 0)
+            {
+                out[row / 64] = 0;
+            }
+            out[row / 64] |= bits << (row % 64);
+        }
+    }
+#endif
+
+    for (; row < size; ++row)
+    {
+        bool matched = false;
+        for (size_t idx = 0; idx < count && !matched; ++idx)
+        {
+            matched = data[row] == set[idx];
+        }
+
+        if (row % 64 == 0)
+        {
+            out[row / 64] = 0;
+        }
+        out[row / 64] |= uint64_t(matched) << (row % 64);
+    }
+}
+
+
+template<typename... Holders, typename... Predicates>
+Selection select(const CollectionBatch<Holders...> &batch, const Predicates &...predicates)
+{
+    Selection selection {batch.size(), true};
+
+    auto apply = [&](const auto &predicate) {
+        using P = std::decay_t<decltype(predicate)>;
+        using Tag = traits::predicate_tag_t<P>;
+
+        static_assert(
+            !traits::is_multiple_v<traits::by_tag_t<Tag, Holders...>>,
+            "Only single attribute values can be filtered");
+
+        const auto column = batch.column(Tag {});
+        const size_t words = (column.size() + 63) / 64;
+
+        if constexpr (std::is_same_v<P, filter::Present<Tag>>)
+        {
+            for (size_t idx = 0; idx < words; ++idx)
+            {
+                selection.words()[idx] &= column.bitmap()[idx];
+            }
+        }
+        else if constexpr (std::is_same_v<P, filter::Missing<Tag>>)
+        {
+            for (size_t idx = 0; idx < words; ++idx)
+            {
+                selection.words()[idx] &= ~column.bitmap()[idx];
+            }
+        }
+        else
+        {
+            Selection matched {column.size()};
+            predicate(column.data(), column.size(), matched.words());
+
+            for (size_t idx = 0; idx < words; ++idx)
+            {
+                selection.words()[idx] &= matched.words()[idx] & column.bitmap()[idx];
+            }
+        }
+    };
+    (apply(predicates), ...);
+
+    return selection;
+}
+
+
+} // namespace porter::attr
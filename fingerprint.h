@@ -0,0 +1,340 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "key.h"
+#include "lazy.h"
+#include "symbol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+namespace porter::attr {
+namespace traits {
+
+
+/// Helper variable for the hash seed of an attribute, computed at compile time from its tag name.
+template<typename Tag> inline constexpr uint64_t seed_v = hash_name(Tag::value);
+
+
+} // namespace traits
+
+
+/// Mix bits of a hash (splitmix64 finalizer), so that sums of mixed hashes stay well distributed.
+/// @param hash hash to mix.
+/// @return mixed hash.
+constexpr uint64_t mix(uint64_t hash);
+
+/// Compute hash of an attribute value.
+/// Strings are hashed by contents, interned strings by symbol identity, deferred ones by computed value,
+/// other values with std::hash.
+/// @tparam V attribute value type.
+/// @param value attribute value.
+/// @return value hash.
+template<typename V>
+uint64_t hash_value(const V &value);
+
+/// Compute hash of an attribute name, consistent across storage key types.
+/// @tparam K attribute name type.
+/// @param key attribute name.
+/// @return name hash.
+template<typename K>
+uint64_t hash_key(const K &key);
+
+/// Compute contribution of a single attribute value to a collection hash.
+/// @tparam Tag attribute tag type.
+/// @tparam V attribute value type.
+/// @param value attribute value.
+/// @return value contribution.
+template<typename Tag, typename V>
+uint64_t hash_attribute(const V &value);
+
+/// Compute contribution of a named attribute value of an associative attribute to a collection hash.
+/// @tparam Tag attribute tag type.
+/// @tparam K attribute name type.
+/// @tparam V attribute value type.
+/// @param key attribute name.
+/// @param value attribute value.
+/// @return value contribution.
+template<typename Tag, typename K, typename V>
+uint64_t hash_attribute(const K &key, const V &value);
+
+/// Compute contribution of a holder to a collection hash.
+/// Associative attributes are hashed independently of their order, as a sum of named value contributions.
+/// @tparam H attribute holder type.
+/// @param holder attribute holder.
+/// @return holder contribution, zero if no value is set.
+template<typename H>
+uint64_t hash_holder(const H &holder);
+
+/// Compute structural hash of a collection: a sum of holder contributions, each seeded by its tag name.
+/// Hashes are process-local (interned strings are hashed by symbol identity), so they suit caches, not storage.
+/// @tparam Holders attribute holder types.
+/// @param collection collection to hash.
+/// @return collection hash.
+template<typename... Holders>
+uint64_t hash(const Collection<Holders...> &collection);
+
+
+/// Defines a collection with a memoized structural hash (see hash()).
+/// The hash is updated incrementally on each update, so reading it takes constant time.
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class Fingerprinted
+{
+    /// Stores attribute values.
+    Collection<Holders...> d_collection;
+
+    /// Stores collection hash.
+    uint64_t d_hash = 0;
+
+public:
+    /// Construct an empty collection.
+    Fingerprinted() = default;
+
+    /// Construct from a collection, hashing it once.
+    /// @param collection attribute values.
+    explicit Fingerprinted(Collection<Holders...> collection);
+
+    /// Update (copy or move) an attribute value, updating the hash by the holder or named value contribution.
+    /// @tparam Attr attribute value container type (Value or KeyValue).
+    /// @param attribute attribute value container.
+    /// @return reference to self.
+    template<typename Attr>
+    Fingerprinted &operator<<(Attr &&attribute);
+
+    /// Get collection hash.
+    uint64_t fingerprint() const;
+
+    /// Checks whether all attribute values are properly set.
+    operator bool() const;
+
+    /// Get attribute value.
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @return attribute value or std::nullopt, if not set.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    const typename H::type &operator()(Tag) const;
+
+    /// Get named attribute value for associative attributes (i.e. Multiple holder).
+    /// @tparam Tag attribute tag type.
+    /// @tparam K attribute name type, anything the holder can look up by.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param key attribute value name.
+    /// @return attribute value reference or std::nullopt, if not found.
+    template<
+        typename Tag,
+        typename K,
+        typename H = traits::by_tag_t<Tag, Holders...>,
+        typename = std::void_t<typename H::key_type>>
+    typename H::mapped_type operator()(Tag, const K &key) const;
+
+    /// Get attribute values.
+    const Collection<Holders...> &collection() const &;
+
+    /// Take attribute values.
+    Collection<Holders...> &&collection() &&;
+};
+
+
+
+constexpr uint64_t mix(uint64_t hash)
+{
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+
+    return hash;
+}
+
+template<typename V>
+uint64_t hash_value(const V &value)
+{
+    if constexpr (traits::is_lazy_v<V>)
+    {
+        return hash_value(value.get());
+    }
+    else if constexpr (traits::is_interned_v<V>)
+    {
+        return std::hash<Symbol> {}(value);
+    }
+    else if constexpr (std::is_convertible_v<const V &, std::string_view>)
+    {
+        return std::hash<std::string_view> {}(std::string_view(value));
+    }
+    else
+    {
+        return std::hash<V> {}(value);
+    }
+}
+
+template<typename K>
+uint64_t hash_key(const K &key)
+{
+    if constexpr (std::is_same_v<K, Key>)
+    {
+        return key.hash();
+    }
+    else
+    {
+        return hash_name(std::string_view(key));
+    }
+}
+
+template<typename Tag, typename V>
+uint64_t hash_attribute(const V &value)
+{
+    return mix(traits::seed_v<Tag> ^ mix(hash_value(value)));
+}
+
+template<typename Tag, typename K, typename V>
+uint64_t hash_attribute(const K &key, const V &value)
+{
+    return mix(traits::seed_v<Tag> ^ mix(hash_key(key) + mix(hash_value(value))));
+}
+
+template<typename H>
+uint64_t hash_holder(const H &holder)
+{
+    using Tag = traits::tag_of_t<H>;
+
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        uint64_t hash = 0;
+        for (const auto &[key, value] : *holder)
+        {
+            hash += hash_attribute<Tag>(key, value);
+        }
+
+        return hash;
+    }
+    else
+    {
+        return *holder ? hash_attribute<Tag>(**holder) : 0;
+    }
+}
+
+template<typename... Holders>
+uint64_t hash(const Collection<Holders...> &collection)
+{
+    return (uint64_t(0) + ... + hash_holder(collection.template holder<Holders>()));
+}
+
+
+template<typename... Holders>
+Fingerprinted<Holders...>::Fingerprinted(Collection<Holders...> collection)
+    : d_collection(std::move(collection))
+    , d_hash(hash(d_collection))
+{
+}
+
+template<typename... Holders>
+template<typename Attr>
+Fingerprinted<Holders...> &Fingerprinted<Holders...>::operator<<(Attr &&attribute)
+{
+    using Tag = traits::tag_of_t<std::decay_t<Attr>>;
+    using H = traits::by_tag_t<Tag, Holders...>;
+
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        if (!*attribute)
+        {
+            return *this;
+        }
+
+        const auto key = (**attribute).first;
+        if (typename H::mapped_type old = d_collection(Tag {}, key))
+        {
+            d_hash -= hash_attribute<Tag>(key, old->get());
+        }
+
+        d_collection << std::forward<Attr>(attribute);
+        d_hash += hash_attribute<Tag>(key, d_collection(Tag {}, key)->get());
+    }
+    else
+    {
+        const H &holder = d_collection.template holder<H>();
+
+        d_hash -= hash_holder(holder);
+        d_collection << std::forward<Attr>(attribute);
+        d_hash += hash_holder(holder);
+    }
+
+    return *this;
+}
+
+template<typename... Holders>
+uint64_t Fingerprinted<Holders...>::fingerprint() const
+{
+    return d_hash;
+}
+
+template<typename... Holders>
+Fingerprinted<Holders...>::operator bool() const
+{
+    return bool(d_collection);
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+const typename H::type &Fingerprinted<Holders...>::operator()(Tag) const
+{
+    return d_collection(Tag {});
+}
+
+template<typename... Holders>
+template<typename Tag, typename K, typename H, typename>
+typename H::mapped_type Fingerprinted<Holders...>::operator()(Tag, const K &key) const
+{
+    return d_collection(Tag {}, key);
+}
+
+template<typename... Holders>
+const Collection<Holders...> &Fingerprinted<Holders...>::collection() const &
+{
+    return d_collection;
+}
+
+template<typename... Holders>
+Collection<Holders...> &&Fingerprinted<Holders...>::collection() &&
+{
+    return std::move(d_collection);
+}
+
+
+} // namespace porter::attr
+
+
+namespace std {
+
+
+/// Collections are hashed structurally.
+template<typename... Holders>
+struct hash<porter::attr::Collection<Holders...>>
+{
+    size_t operator()(const porter::attr::Collection<Holders...> &collection) const
+    {
+        return size_t(porter::attr::hash(collection));
+    }
+};
+
+/// Fingerprinted collections are hashed by their memoized hash.
+template<typename... Holders>
+struct hash<porter::attr::Fingerprinted<Holders...>>
+{
+    size_t operator()(const porter::attr::Fingerprinted<Holders...> &collection) const noexcept
+    {
+        return size_t(collection.fingerprint());
+    }
+};
+
+
+} // namespace std
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "lazy.h"
+
+#include <array>
+#include <charconv>
+#include <limits>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+
+namespace porter::attr {
+
+
+/// Defines text formatting of an attribute value type.
+/// Specializations provide format(first, last, value) that writes the value into [first, last)
+/// and reports the end of written text the way std::to_chars does.
+/// Fixed-width value types also provide max_size, the upper bound of formatted value length.
+/// @tparam V attribute value type.
+template<typename V, typename = void> struct Formatter;
+
+/// Defines text formatting of integer values.
+template<typename V>
+struct Formatter<V, std::enable_if_t<std::is_integral_v<V> && !std::is_same_v<V, bool>>>
+{
+    /// Defines upper bound of formatted value length: digits and sign.
+    static constexpr size_t max_size = std::numeric_limits<V>::digits10 + 1 + std::is_signed_v<V>;
+
+    /// Format a value into a buffer.
+    static std::to_chars_result format(char *first, char *last, V value);
+};
+
+/// Defines text formatting of boolean values.
+template<>
+struct Formatter<bool>
+{
+    /// Defines upper bound of formatted value length.
+    static constexpr size_t max_size = 5;
+
+    /// Format a value into a buffer.
+    static std::to_chars_result format(char *first, char *last, bool value);
+};
+
+/// Defines text formatting of enumeration values, as their underlying integers.
+template<typename V>
+struct Formatter<V, std::enable_if_t<std::is_enum_v<V>>> : Formatter<std::underlying_type_t<V>>
+{
+    /// Format a value into a buffer.
+    static std::to_chars_result format(char *first, char *last, V value);
+};
+
+/// Defines text formatting of string values, written as is.
+template<typename V>
+struct Formatter<V, std::enable_if_t<std::is_convertible_v<const V &, std::string_view> && !std::is_arithmetic_v<V>>>
+{
+    /// Format a value into a buffer.
+    static std::to_chars_result format(char *first, char *last, std::string_view value);
+};
+
+/// Defines text formatting of deferred values, as their computed values, which are forced.
+template<typename V>
+struct Formatter<Lazy<V>> : Formatter<V>
+{
+    /// Format a value into a buffer.
+    static std::to_chars_result format(char *first, char *last, const Lazy<V> &value);
+};
+
+
+namespace traits {
+
+
+/// Template that checks whether a value type has bounded formatted length.
+template<typename V, typename = void> struct is_fixed_width : std::false_type {};
+
+/// Template that checks whether a value type has bounded formatted length.
+template<typename V>
+struct is_fixed_width<V, std::void_t<decltype(Formatter<V>::max_size)>> : std::true_type {};
+
+/// Helper variable for checking whether a value type has bounded formatted length.
+template<typename V> inline constexpr bool is_fixed_width_v = is_fixed_width<V>::value;
+
+
+/// Template that defines formatted name prefix of a tag, e.g. "service=", or "context." for associative attributes.
+/// @tparam Tag attribute tag type.
+/// @tparam Separator character following the tag name.
+template<typename Tag, char Separator = '='> struct prefix
+{
+    static constexpr std::array<char, Tag::value.size() + 1> value = [] {
+        std::array<char, Tag::value.size() + 1> text {};
+        for (size_t idx = 0; idx < Tag::value.size(); ++idx)
+        {
+            text[idx] = Tag::value[idx];
+        }
+        text[Tag::value.size()] = Separator;
+        return text;
+    }();
+};
+
+/// Helper variable for formatted name prefix of a tag.
+template<typename Tag, char Separator = '='>
+inline constexpr std::string_view prefix_v {prefix<Tag, Separator>::value.data(), prefix<Tag, Separator>::value.size()};
+
+
+/// Template that defines upper bound of formatted collection length.
+/// Only defined for collections of single holders with fixed-width values.
+template<typename C> struct max_formatted_size;
+
+/// Template that defines upper bound of formatted collection length.
+/// Defines the bound for collections.
+template<typename... Holders> struct max_formatted_size<Collection<Holders...>>
+{
+    static_assert(
+        (!is_multiple_v<Holders> && ...),
+        "Formatted length of associative attributes is not bounded");
+    static_assert(
+        (is_fixed_width_v<typename Holders::value_type> && ...),
+        "Formatted length of one or more attribute value types is not bounded");
+
+    /// Every attribute is prefixed with its name and all but the first one with a separator.
+    static constexpr size_t value = (sizeof...(Holders) ? sizeof...(Holders) - 1 : 0)
+        + (0 + ... + (prefix_v<tag_of_t<Holders>>.size() + Formatter<typename Holders::value_type>::max_size));
+};
+
+/// Helper variable for upper bound of formatted collection length.
+template<typename C> inline constexpr size_t max_formatted_size_v = max_formatted_size<C>::value;
+
+
+} // namespace traits
+
+
+/// Format a collection into a buffer as space-separated name=value fields, e.g.
+/// "service=pisvc label=42 context.LID=FIINDEX:LUATTRUU".
+/// Unset attributes are skipped; associative attributes produce a tag.name=value field per value.
+/// Values are written as is, without escaping.
+/// @tparam Holders attribute holder types of the collection.
+/// @param first beginning of the buffer.
+/// @param last end of the buffer.
+/// @param collection collection to format.
+/// @return end of written text, or last and std::errc::value_too_large if the buffer is too small.
+template<typename... Holders>
+std::to_chars_result format(char *first, char *last, const Collection<Holders...> &collection);
+
+/// Format a collection into a buffer sized by compile-time upper bound of its formatted length.
+/// Only available for collections of single holders with fixed-width values.
+/// @tparam Holders attribute holder types of the collection.
+/// @param buffer output buffer.
+/// @param collection collection to format.
+/// @return formatted text within the buffer.
+template<typename... Holders>
+std::string_view format(
+    std::array<char, traits::max_formatted_size_v<Collection<Holders...>>> &buffer,
+    const Collection<Holders...> &collection);
+
+
+
+template<typename V>
+std::to_chars_result Formatter<V, std::enable_if_t<std::is_integral_v<V> && !std::is_same_v<V, bool>>>::format(
+    char *first, char *last, V value)
+{
+    return std::to_chars(first, last, value);
+}
+
+inline std::to_chars_result Formatter<bool>::format(char *first, char *last, bool value)
+{
+    return Formatter<std::string_view>::format(first, last, value ? "true" : "false");
+}
+
+template<typename V>
+std::to_chars_result Formatter<V, std::enable_if_t<std::is_enum_v<V>>>::format(char *first, char *last, V value)
+{
+    return Formatter<std::underlying_type_t<V>>::format(first, last, static_cast<std::underlying_type_t<V>>(value));
+}
+
+template<typename V>
+std::to_chars_result Formatter<V, std::enable_if_t<std::is_convertible_v<const V &, std::string_view> && !std::is_arithmetic_v<V>>>::format(
+    char *first, char *last, std::string_view value)
+{
+    if (size_t(last - first) < value.size())
+    {
+        return {last, std::errc::value_too_large};
+    }
+
+    value.copy(first, value.size());
+    return {first + value.size(), std::errc {}};
+}
+
+template<typename V>
+std::to_chars_result Formatter<Lazy<V>>::format(char *first, char *last, const Lazy<V> &value)
+{
+    return Formatter<V>::format(first, last, value.get());
+}
+
+
+template<typename... Holders>
+std::to_chars_result format(char *first, char *last, const Collection<Holders...> &collection)
+{
+    std::to_chars_result result {first, std::errc {}};
+
+    auto write = [&](std::string_view text) {
+        if (result.ec == std::errc {})
+        {
+            result = Formatter<std::string_view>::format(result.ptr, last, text);
+        }
+    };
+
+    auto value = [&](const auto &value) {
+        if (result.ec == std::errc {})
+        {
+            result = Formatter<std::decay_t<decltype(value)>>::format(result.ptr, last, value);
+        }
+    };
+
+    auto put = [&](const auto &holder) {
+        using H = std::decay_t<decltype(holder)>;
+        using Tag = traits::tag_of_t<H>;
+
+        if constexpr (traits::is_multiple_v<H>)
+        {
+            for (const auto &[key, item] : *holder)
+            {
+                write(result.ptr == first ? std::string_view {} : std::string_view {" "});
+                write(traits::prefix_v<Tag, '.'>);
+                write(std::string_view(key));
+                write("=");
+                value(item);
+            }
+        }
+        else if (const auto &item = *holder)
+        {
+            write(result.ptr == first ? std::string_view {} : std::string_view {" "});
+            write(traits::prefix_v<Tag>);
+            value(*item);
+        }
+    };
+    (put(collection.template holder<Holders>()), ...);
+
+    return result.ec == std::errc {} ? result : std::to_chars_result {last, result.ec};
+}
+
+template<typename... Holders>
+std::string_view format(
+    std::array<char, traits::max_formatted_size_v<Collection<Holders...>>> &buffer,
+    const Collection<Holders...> &collection)
+{
+    std::to_chars_result result = format(buffer.data(), buffer.data() + buffer.size(), collection);
+    return {buffer.data(), size_t(result.ptr - buffer.data())};
+}
+
+
+} // namespace porter::attr
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "attribute.h"
+#include "storage.h"
+#include "instrument.h"
+#include "memory.h"
 
 #include <optional>
 #include <functional>
-#include <unordered_map>
 
 
 namespace porter::attr {
@@ -18,9 +20,37 @@ template<typename H, typename = void> struct is_valid : std::false_type {};
 template<typename H> inline constexpr bool is_valid_v = is_valid<H>::value;
 
 
+/// Template that checks whether a value storage supports node extraction (e.g. std::unordered_map).
+template<typename C, typename = void> struct has_nodes : std::false_type {};
+
+/// Defines the check for containers with node handles.
+template<typename C> struct has_nodes<C, std::void_t<typename C::node_type>> : std::true_type {};
+
+/// Helper variable for checking whether a value storage supports node extraction.
+template<typename C> inline constexpr bool has_nodes_v = has_nodes<C>::value;
+
+
 } // namespace traits;
 
 
+/// Merge policy that keeps current attribute values on conflicts.
+struct KeepLeft {};
+
+/// Merge policy that takes incoming attribute values on conflicts.
+struct KeepRight {};
+
+/// Resolve a merge conflict between an attribute value and an incoming one.
+/// Custom policies are callables that update current value in place, e.g. [](V &current, const V &incoming) {...}.
+/// @tparam Policy merge policy type: KeepLeft, KeepRight or a custom callable.
+/// @tparam V attribute value type.
+/// @tparam U incoming attribute value reference type.
+/// @param policy merge policy.
+/// @param current current attribute value.
+/// @param incoming incoming attribute value.
+template<typename Policy, typename V, typename U>
+void resolve(const Policy &policy, V &current, U &&incoming);
+
+
 /// Defines a single value storage for an attribute (tag).
 /// Can be set or updated from Value container.
 /// @tparam Tag tag type that defines attribute properties.
@@ -32,43 +62,99 @@ class Single
     static_assert(traits::is_tag_valid_v<Tag>, "Tag type is invalid");
 
     /// Stores attribute value.
-    std::optional<V> d_value;
+    traits::optional_t<V> d_value;
 
 public:
+    /// Defines attribute value type.
+    using value_type = V;
+
     /// Defines attribute storage type.
     using type = std::optional<V>;
 
+    /// Checks whether the holder may own heap memory.
+    static constexpr bool dynamic = traits::is_dynamic_v<traits::optional_t<V>>;
+
+    /// Default ctor.
+    Single() = default;
+
+    /// Construct an empty holder that keeps its value on provided allocator.
+    /// Available for allocator-aware value types only.
+    /// @tparam Alloc allocator type.
+    /// @param allocator allocator for attribute value.
+    template<typename Alloc, typename = std::enable_if_t<traits::is_allocator_aware_v<V> && std::uses_allocator_v<V, Alloc>>>
+    explicit Single(const Alloc &allocator);
+
+    /// Copy holder onto provided allocator.
+    /// Available for allocator-aware value types only.
+    /// @tparam Alloc allocator type.
+    /// @param other holder to copy.
+    /// @param allocator allocator for attribute value.
+    template<typename Alloc, typename = std::enable_if_t<traits::is_allocator_aware_v<V> && std::uses_allocator_v<V, Alloc>>>
+    Single(const Single<Tag, Required, V> &other, const Alloc &allocator);
+
+    /// Move holder onto provided allocator.
+    /// Available for allocator-aware value types only.
+    /// @tparam Alloc allocator type.
+    /// @param other holder to move.
+    /// @param allocator allocator for attribute value.
+    template<typename Alloc, typename = std::enable_if_t<traits::is_allocator_aware_v<V> && std::uses_allocator_v<V, Alloc>>>
+    Single(Single<Tag, Required, V> &&other, const Alloc &allocator);
+
     /// Assign from a Value container with different tag or value type.
     /// Not allowed; causes static assertion.
     template<typename Tagt, typename Vt>
-    Single<Tag, Required, V> &operator=(const Value<Tagt, Vt> &);
+    constexpr Single<Tag, Required, V> &operator=(const Value<Tagt, Vt> &);
 
     /// Copy-assign from a compatible Value container.
     /// @param value value container to copy attribute value from.
     /// @return reference to self.
-    Single<Tag, Required, V> &operator=(const Value<Tag, V> &value);
+    constexpr Single<Tag, Required, V> &operator=(const Value<Tag, V> &value);
 
     /// Move-assign from a compatible Value container.
     /// @param value value container to move attribute value from.
     /// @return reference to self.
-    Single<Tag, Required, V> &operator=(Value<Tag, V> &&value);
+    constexpr Single<Tag, Required, V> &operator=(Value<Tag, V> &&value);
 
     /// Assign from a KeyValue container.
     /// Not allowed; causes static assertion.
     template<typename Vt>
-    Single<Tag, Required, V> &operator=(const KeyValue<Tag, Vt> &);
+    constexpr Single<Tag, Required, V> &operator=(const KeyValue<Tag, Vt> &);
+
+    /// Merge (copy) attribute value of another holder: unset values are taken, conflicts are resolved by policy.
+    /// @tparam Policy merge policy type, see resolve().
+    /// @param other source holder.
+    /// @param policy conflict resolution policy.
+    /// @return reference to self.
+    template<typename Policy = KeepRight>
+    Single<Tag, Required, V> &merge(const Single<Tag, Required, V> &other, const Policy &policy = {});
+
+    /// Merge (move) attribute value of another holder: unset values are taken, conflicts are resolved by policy.
+    /// @tparam Policy merge policy type, see resolve().
+    /// @param other source holder.
+    /// @param policy conflict resolution policy.
+    /// @return reference to self.
+    template<typename Policy = KeepRight>
+    Single<Tag, Required, V> &merge(Single<Tag, Required, V> &&other, const Policy &policy = {});
+
+    /// Clear attribute value.
+    /// @return reference to self.
+    constexpr Single<Tag, Required, V> &reset();
 
     /// Checks whether attribute storage state is valid.
     /// @return true if the value is present or not required.
-    operator bool() const;
+    constexpr operator bool() const;
 
     /// Get stored value.
     /// @return const reference to stored value.
-    const type &operator*() const &;
+    constexpr const type &operator*() const &;
 
     /// Take stored value.
     /// @return rvalue reference to stored value.
-    type &&operator*() &&;
+    constexpr type &&operator*() &&;
+
+    /// Get memory owned by the holder.
+    /// @return holder size and heap memory owned by the value.
+    MemoryUsage memory_usage() const;
 };
 
 
@@ -76,43 +162,88 @@ public:
 /// Can be extended or updated from KeyValue container.
 /// @tparam Tag tag type that defines attribute properties.
 /// @tparam V attribute value type. Normally auto-deduced.
-template<typename Tag, typename V = typename Tag::type>
+/// @tparam Storage value storage policy, see storage::Hashed and storage::Flat.
+template<typename Tag, typename V = typename Tag::type, typename Storage = storage::Hashed>
 class Multiple
 {
     static_assert(traits::is_tag_valid_v<Tag>, "Tag type is invalid");
 
-    /// Stores attribute values.
-    std::unordered_map<std::string_view, V> d_values;
-
 public:
     /// Defines attribute name type.
-    using key_type = std::string_view;
+    using key_type = typename Storage::key_type;
+
+    /// Defines attribute value type.
+    using value_type = V;
 
     /// Defines stored attribute value.
     using mapped_type = std::optional<std::reference_wrapper<const V>>;
 
     /// Defines attribute value storage type.
-    using type = std::unordered_map<key_type, V>;
+    using type = typename Storage::template type<key_type, V>;
+
+    /// Defines value storage allocator type.
+    using allocator_type = typename type::allocator_type;
+
+    /// Checks whether the holder may own heap memory.
+    static constexpr bool dynamic = true;
+
+private:
+    /// Stores attribute values.
+    type d_values;
+
+public:
+    /// Default ctor.
+    Multiple() = default;
+
+    /// Default copy ctor.
+    Multiple(const Multiple<Tag, V, Storage> &) = default;
+
+    /// Default move ctor.
+    Multiple(Multiple<Tag, V, Storage> &&) = default;
+
+    /// Default copy assignment.
+    Multiple<Tag, V, Storage> &operator=(const Multiple<Tag, V, Storage> &) = default;
+
+    /// Default move assignment.
+    Multiple<Tag, V, Storage> &operator=(Multiple<Tag, V, Storage> &&) = default;
+
+    /// Construct an empty holder with provided value storage allocator.
+    /// @param allocator value storage allocator.
+    explicit Multiple(const allocator_type &allocator);
+
+    /// Copy holder onto provided value storage allocator.
+    /// @param other holder to copy.
+    /// @param allocator value storage allocator.
+    Multiple(const Multiple<Tag, V, Storage> &other, const allocator_type &allocator);
+
+    /// Move holder onto provided value storage allocator.
+    /// @param other holder to move.
+    /// @param allocator value storage allocator.
+    Multiple(Multiple<Tag, V, Storage> &&other, const allocator_type &allocator);
 
     /// Assign from KeyValue container with different tag or value type.
     /// Not allowed; causes a static assertion.
     template<typename Tagt, typename Vt>
-    Multiple<Tag, V> &operator=(const KeyValue<Tagt, Vt> &);
+    Multiple<Tag, V, Storage> &operator=(const KeyValue<Tagt, Vt> &);
 
     /// Copy-assign from a compatible KeyValue container.
+    /// @tparam K attribute name type, anything the storage policy can translate into its key.
     /// @param kv key-value pair to copy.
     /// @return reference to self.
-    Multiple<Tag, V> &operator=(const KeyValue<Tag> &kv);
+    template<typename K>
+    Multiple<Tag, V, Storage> &operator=(const KeyValue<Tag, std::pair<K, V>> &kv);
 
     /// Move-assign from a compatible KeyValue container.
+    /// @tparam K attribute name type, anything the storage policy can translate into its key.
     /// @param kv key-value pair to move.
     /// @return reference to self.
-    Multiple<Tag, V> &operator=(KeyValue<Tag> &&kv);
+    template<typename K>
+    Multiple<Tag, V, Storage> &operator=(KeyValue<Tag, std::pair<K, V>> &&kv);
 
     /// Assign from Value container.
     /// Not allowed; causes a static assertion.
     template<typename Vt>
-    Multiple<Tag, V> &operator=(const Value<Tag, Vt> &);
+    Multiple<Tag, V, Storage> &operator=(const Value<Tag, Vt> &);
 
     /// Checks whether attribute storage state is valid.
     /// Always returns true.
@@ -126,10 +257,41 @@ public:
     /// @return rvalue reference to value storage.
     type &&operator*() &&;
 
-    /// Get storeg value by key.
+    /// Get stored value by key.
+    /// @tparam K attribute name type, anything the storage policy can look up by.
     /// @param item value key.
     /// @return stored value reference or std::nullopt, if key was not found.
-    mapped_type operator()(const key_type &item) const;
+    template<typename K>
+    mapped_type operator()(const K &item) const;
+
+    /// Merge (copy) attribute values of another holder, reserving storage up front.
+    /// @tparam Policy merge policy type, see resolve().
+    /// @param other source holder.
+    /// @param policy conflict resolution policy.
+    /// @return reference to self.
+    template<typename Policy = KeepRight>
+    Multiple<Tag, V, Storage> &merge(const Multiple<Tag, V, Storage> &other, const Policy &policy = {});
+
+    /// Merge (move) attribute values of another holder.
+    /// Hash map nodes are spliced when allocators are equal, so no entries are reallocated.
+    /// @tparam Policy merge policy type, see resolve().
+    /// @param other source holder, left with unspecified attribute values.
+    /// @param policy conflict resolution policy.
+    /// @return reference to self.
+    template<typename Policy = KeepRight>
+    Multiple<Tag, V, Storage> &merge(Multiple<Tag, V, Storage> &&other, const Policy &policy = {});
+
+    /// Remove a stored value by key.
+    /// @tparam K attribute name type, anything the storage policy can look up by.
+    /// @param item value key.
+    /// @return true if the value was found and removed.
+    template<typename K>
+    bool erase(const K &item);
+
+    /// Get memory owned by the holder.
+    /// @return holder size, including inline entries of flat storage,
+    /// and heap memory owned by the value storage and its names and values.
+    MemoryUsage memory_usage() const;
 };
 
 
@@ -141,8 +303,8 @@ template<typename Tag, bool Required, typename V>
 struct is_valid<Single<Tag, Required, V>, std::enable_if_t<traits::is_tag_valid_v<Tag>>> : std::true_type {};
 
 /// Defines validity check for multiple attribute values holder.
-template<typename Tag, typename V>
-struct is_valid<Multiple<Tag, V>, std::enable_if_t<traits::is_tag_valid_v<Tag>>> : std::true_type {};
+template<typename Tag, typename V, typename Storage>
+struct is_valid<Multiple<Tag, V, Storage>, std::enable_if_t<traits::is_tag_valid_v<Tag>>> : std::true_type {};
 
 
 /// Defines tag type for single attribute value holder.
@@ -150,18 +312,41 @@ template<typename Tag, bool Required, typename V>
 struct tag_of<Single<Tag, Required, V>> { using type = Tag; };
 
 /// Defines tag type for multiple attribute values holder.
-template<typename Tag, typename V>
-struct tag_of<Multiple<Tag, V>> { using type = Tag; };
+template<typename Tag, typename V, typename Storage>
+struct tag_of<Multiple<Tag, V, Storage>> { using type = Tag; };
+
+
+/// Template that checks whether a holder stores multiple named values.
+template<typename H> struct is_multiple : std::false_type {};
+
+/// Defines the check for multiple attribute values holder.
+template<typename Tag, typename V, typename Storage>
+struct is_multiple<Multiple<Tag, V, Storage>> : std::true_type {};
+
+/// Helper variable for checking whether a holder stores multiple named values.
+template<typename H> inline constexpr bool is_multiple_v = is_multiple<H>::value;
+
+
+/// Template that checks whether a holder requires its value to be set.
+template<typename H> struct is_required : std::false_type {};
+
+/// Defines the check for single attribute value holder.
+template<typename Tag, bool Required, typename V>
+struct is_required<Single<Tag, Required, V>> : std::bool_constant<Required> {};
+
+/// Helper variable for checking whether a holder requires its value to be set.
+template<typename H> inline constexpr bool is_required_v = is_required<H>::value;
 
 
 /// Defines holder type for provided value container type.
+/// Collections use it for tags they do not hold yet, see traits::holder_for.
 template<typename Attr> struct from;
 
 /// Defines holder type for Value container types.
 template<typename Tag, typename V> struct from<Value<Tag, V>> { using type = Single<Tag, true, V>; };
 
 /// Defines holder type for KeyValue container types.
-template<typename Tag, typename V> struct from<KeyValue<Tag, V>> { using type = Multiple<Tag, V>; };
+template<typename Tag, typename K, typename V> struct from<KeyValue<Tag, std::pair<K, V>>> { using type = Multiple<Tag, V>; };
 
 // Helper variable for inferring holder types from attribute value container types.
 template<typename Attr> using from_t = typename from<Attr>::type;
@@ -171,9 +356,44 @@ template<typename Attr> using from_t = typename from<Attr>::type;
 
 
 
+template<typename Policy, typename V, typename U>
+void resolve(const Policy &policy, V &current, U &&incoming)
+{
+    if constexpr (std::is_same_v<Policy, KeepRight>)
+    {
+        current = std::forward<U>(incoming);
+    }
+    else if constexpr (!std::is_same_v<Policy, KeepLeft>)
+    {
+        policy(current, std::forward<U>(incoming));
+    }
+}
+
+
+template<typename Tag, bool Required, typename V>
+template<typename Alloc, typename>
+Single<Tag, Required, V>::Single(const Alloc &allocator)
+    : d_value(allocator)
+{
+}
+
+template<typename Tag, bool Required, typename V>
+template<typename Alloc, typename>
+Single<Tag, Required, V>::Single(const Single<Tag, Required, V> &other, const Alloc &allocator)
+    : d_value(other.d_value, allocator)
+{
+}
+
+template<typename Tag, bool Required, typename V>
+template<typename Alloc, typename>
+Single<Tag, Required, V>::Single(Single<Tag, Required, V> &&other, const Alloc &allocator)
+    : d_value(std::move(other.d_value), allocator)
+{
+}
+
 template<typename Tag, bool Required, typename V>
 template<typename Tagt, typename Vt>
-Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(const Value<Tagt, Vt> &)
+constexpr Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(const Value<Tagt, Vt> &)
 {
     static_assert(
         std::is_same_v<Tag, Tagt> && std::is_same_v<V, Vt>,
@@ -183,22 +403,26 @@ Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(const Value<Tagt,
 }
 
 template<typename Tag, bool Required, typename V>
-Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(const Value<Tag, V> &value)
+constexpr Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(const Value<Tag, V> &value)
 {
     d_value = *value;
+    instrument::record<Tag>(instrument::Event::assignment);
+
     return *this;
 }
 
 template<typename Tag, bool Required, typename V>
-Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(Value<Tag, V> &&value)
+constexpr Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(Value<Tag, V> &&value)
 {
     d_value = *std::move(value);
+    instrument::record<Tag>(instrument::Event::assignment);
+
     return *this;
 }
 
 template<typename Tag, bool Required, typename V>
 template<typename Vt>
-Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(const KeyValue<Tag, Vt> &)
+constexpr Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(const KeyValue<Tag, Vt> &)
 {
     static_assert(
         std::is_same_v<Tag, Tag *>,
@@ -208,62 +432,151 @@ Single<Tag, Required, V> &Single<Tag, Required, V>::operator=(const KeyValue<Tag
 };
 
 template<typename Tag, bool Required, typename V>
-Single<Tag, Required, V>::operator bool() const
+template<typename Policy>
+Single<Tag, Required, V> &Single<Tag, Required, V>::merge(const Single<Tag, Required, V> &other, const Policy &policy)
+{
+    if (!other.d_value || this == &other)
+    {
+        return *this;
+    }
+
+    if (!d_value)
+    {
+        d_value = other.d_value;
+    }
+    else
+    {
+        resolve(policy, *d_value, *other.d_value);
+    }
+
+    return *this;
+}
+
+template<typename Tag, bool Required, typename V>
+template<typename Policy>
+Single<Tag, Required, V> &Single<Tag, Required, V>::merge(Single<Tag, Required, V> &&other, const Policy &policy)
+{
+    if (!other.d_value || this == &other)
+    {
+        return *this;
+    }
+
+    if (!d_value)
+    {
+        d_value = std::move(other.d_value);
+    }
+    else
+    {
+        resolve(policy, *d_value, std::move(*other.d_value));
+    }
+
+    return *this;
+}
+
+template<typename Tag, bool Required, typename V>
+constexpr Single<Tag, Required, V> &Single<Tag, Required, V>::reset()
+{
+    d_value.reset();
+    return *this;
+}
+
+template<typename Tag, bool Required, typename V>
+constexpr Single<Tag, Required, V>::operator bool() const
 {
     return !Required || d_value.has_value();
 }
 
 template<typename Tag, bool Required, typename V>
-const typename Single<Tag, Required, V>::type &Single<Tag, Required, V>::operator*() const &
+constexpr const typename Single<Tag, Required, V>::type &Single<Tag, Required, V>::operator*() const &
 {
     return d_value;
 }
 
 template<typename Tag, bool Required, typename V>
-typename Single<Tag, Required, V>::type &&Single<Tag, Required, V>::operator*() &&
+constexpr typename Single<Tag, Required, V>::type &&Single<Tag, Required, V>::operator*() &&
 {
     return std::move(d_value);
 }
 
+template<typename Tag, bool Required, typename V>
+MemoryUsage Single<Tag, Required, V>::memory_usage() const
+{
+    return {sizeof(*this), HeapSize<traits::optional_t<V>>::bytes(d_value)};
+}
+
+
+template<typename Tag, typename V, typename Storage>
+Multiple<Tag, V, Storage>::Multiple(const allocator_type &allocator)
+    : d_values(allocator)
+{
+}
+
+template<typename Tag, typename V, typename Storage>
+Multiple<Tag, V, Storage>::Multiple(const Multiple<Tag, V, Storage> &other, const allocator_type &allocator)
+    : d_values(other.d_values, allocator)
+{
+}
+
+template<typename Tag, typename V, typename Storage>
+Multiple<Tag, V, Storage>::Multiple(Multiple<Tag, V, Storage> &&other, const allocator_type &allocator)
+    : d_values(std::move(other.d_values), allocator)
+{
+}
 
-template<typename Tag, typename V>
+template<typename Tag, typename V, typename Storage>
 template<typename Tagt, typename Vt>
-Multiple<Tag, V> &Multiple<Tag, V>::operator=(const KeyValue<Tagt, Vt> &)
+Multiple<Tag, V, Storage> &Multiple<Tag, V, Storage>::operator=(const KeyValue<Tagt, Vt> &)
 {
     static_assert(
         std::is_same_v<Tag, Tagt> && std::is_same_v<std::pair<std::string_view, V>, Vt>,
-        "Values can't be updated from key-value pair of mismatching tag/key type/value type");
+        "Values can't be updated from key-value pair of mismatching tag/value type");
 
     return *this;
 }
 
-template<typename Tag, typename V>
-Multiple<Tag, V> &Multiple<Tag, V>::operator=(const KeyValue<Tag> &kv)
+template<typename Tag, typename V, typename Storage>
+template<typename K>
+Multiple<Tag, V, Storage> &Multiple<Tag, V, Storage>::operator=(const KeyValue<Tag, std::pair<K, V>> &kv)
 {
+    static_assert(
+        traits::is_key_of_v<Storage, const K &>,
+        "Values can't be updated from key-value pair of mismatching key type");
+
     if (*kv)
     {
         const auto &[key, value] = **kv;
-        d_values[key] = value;
+        const auto footprint = instrument::measure(d_values);
+        d_values[Storage::key(key)] = value;
+        instrument::grown<Tag>(footprint, d_values);
+        instrument::record<Tag>(instrument::Event::assignment);
     }
 
     return *this;
 }
 
-template<typename Tag, typename V>
-Multiple<Tag, V> &Multiple<Tag, V>::operator=(KeyValue<Tag> &&kv)
+template<typename Tag, typename V, typename Storage>
+template<typename K>
+Multiple<Tag, V, Storage> &Multiple<Tag, V, Storage>::operator=(KeyValue<Tag, std::pair<K, V>> &&kv)
 {
+    static_assert(
+        traits::is_key_of_v<Storage, const K &>,
+        "Values can't be updated from key-value pair of mismatching key type");
+
     if (*kv)
     {
         auto &&[key, value] = **std::move(kv);
-        d_values[std::move(key)] = std::move(value);
+        const auto footprint = instrument::measure(d_values);
+        d_values[Storage::key(std::move(key))] = std::move(value);
+        instrument::grown<Tag>(footprint, d_values);
+        instrument::record<Tag>(instrument::Event::assignment);
     }
 
     return *this;
 }
 
-template<typename Tag, typename V>
+template<typename Tag, typename V, typename Storage>
 template<typename Vt>
-Multiple<Tag, V> &Multiple<Tag, V>::operator=(const Value<Tag, Vt> &)
+Multiple<Tag, V, Storage> &Multiple<Tag, V, Storage>::operator=(const Value<Tag, Vt> &)
 {
     static_assert(
         std::is_same_v<Tag, Tag *>,
@@ -272,30 +585,142 @@ Multiple<Tag, V> &Multiple<Tag, V>::operator=(const Value<Tag, Vt> &)
     return *this;
 }
 
-template<typename Tag, typename V>
-Multiple<Tag, V>::operator bool() const
+template<typename Tag, typename V, typename Storage>
+Multiple<Tag, V, Storage>::operator bool() const
 {
     return true;
 }
 
-template<typename Tag, typename V>
-const typename Multiple<Tag, V>::type &Multiple<Tag, V>::operator*() const &
+template<typename Tag, typename V, typename Storage>
+const typename Multiple<Tag, V, Storage>::type &Multiple<Tag, V, Storage>::operator*() const &
 {
     return d_values;
 }
 
-template<typename Tag, typename V>
-typename Multiple<Tag, V>::type &&Multiple<Tag, V>::operator*() &&
+template<typename Tag, typename V, typename Storage>
+typename Multiple<Tag, V, Storage>::type &&Multiple<Tag, V, Storage>::operator*() &&
 {
     return std::move(d_values);
 }
 
-template<typename Tag, typename V>
-typename Multiple<Tag, V>::mapped_type Multiple<Tag, V>::operator()(const key_type &item) const
+template<typename Tag, typename V, typename Storage>
+template<typename K>
+typename Multiple<Tag, V, Storage>::mapped_type Multiple<Tag, V, Storage>::operator()(const K &item) const
 {
-    auto it = d_values.find(item);
+    auto it = Storage::find(d_values, item);
     return it == d_values.end() ? mapped_type {} : std::make_optional(std::cref(it->second));
 }
 
+template<typename Tag, typename V, typename Storage>
+template<typename K>
+bool Multiple<Tag, V, Storage>::erase(const K &item)
+{
+    auto it = Storage::find(d_values, item);
+    if (it == d_values.end())
+    {
+        return false;
+    }
+
+    d_values.erase(it);
+    return true;
+}
+
+template<typename Tag, typename V, typename Storage>
+MemoryUsage Multiple<Tag, V, Storage>::memory_usage() const
+{
+    return {sizeof(*this), HeapSize<type>::bytes(d_values)};
+}
+
+template<typename Tag, typename V, typename Storage>
+template<typename Policy>
+Multiple<Tag, V, Storage> &Multiple<Tag, V, Storage>::merge(const Multiple<Tag, V, Storage> &other, const Policy &policy)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    d_values.reserve(d_values.size() + other.d_values.size());
+
+    for (const auto &[key, value] : other.d_values)
+    {
+        if (auto it = d_values.find(key); it != d_values.end())
+        {
+            resolve(policy, it->second, value);
+        }
+        else
+        {
+            d_values[key] = value;
+        }
+    }
+
+    return *this;
+}
+
+template<typename Tag, typename V, typename Storage>
+template<typename Policy>
+Multiple<Tag, V, Storage> &Multiple<Tag, V, Storage>::merge(Multiple<Tag, V, Storage> &&other, const Policy &policy)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+
+    if constexpr (traits::has_nodes_v<type>)
+    {
+        if (d_values.get_allocator() == other.d_values.get_allocator())
+        {
+            if constexpr (std::is_same_v<Policy, KeepLeft>)
+            {
+                d_values.merge(other.d_values);
+            }
+            else
+            {
+                d_values.reserve(d_values.size() + other.d_values.size());
+
+                while (!other.d_values.empty())
+                {
+                    auto node = other.d_values.extract(other.d_values.begin());
+                    auto result = d_values.insert(std::move(node));
+                    if (!result.inserted)
+                    {
+                        resolve(policy, result.position->second, std::move(result.node.mapped()));
+                    }
+                }
+            }
+
+            return *this;
+        }
+    }
+
+    d_values.reserve(d_values.size() + other.d_values.size());
+
+    for (auto &[key, value] : other.d_values)
+    {
+        if (auto it = d_values.find(key); it != d_values.end())
+        {
+            resolve(policy, it->second, std::move(value));
+        }
+        else
+        {
+            d_values[std::move(key)] = std::move(value);
+        }
+    }
+
+    return *this;
+}
+
 
 } // namespace porter::attr
+
+
+namespace std {
+
+
+/// Single holders use allocators of their allocator-aware values.
+template<typename Tag, bool Required, typename V, typename Alloc>
+struct uses_allocator<porter::attr::Single<Tag, Required, V>, Alloc>
+    : bool_constant<porter::attr::traits::is_allocator_aware_v<V> && uses_allocator_v<V, Alloc>> {};
+
+
+} // namespace std
@@ -0,0 +1,432 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifndef PORTER_ATTR_INSTRUMENTATION
+#define PORTER_ATTR_INSTRUMENTATION 0
+#endif
+
+
+namespace porter::attr {
+namespace traits {
+
+
+/// Template that checks whether a value storage is a hash map with buckets.
+template<typename C, typename = void> struct has_buckets : std::false_type {};
+
+/// Defines the check for containers exposing bucket_count().
+template<typename C> struct has_buckets<C, std::void_t<decltype(std::declval<const C &>().bucket_count())>> : std::true_type {};
+
+/// Helper variable for checking whether a value storage is a hash map with buckets.
+template<typename C> inline constexpr bool has_buckets_v = has_buckets<C>::value;
+
+
+/// Template that checks whether a value storage is a contiguous buffer with capacity.
+template<typename C, typename = void> struct has_capacity : std::false_type {};
+
+/// Defines the check for containers exposing capacity().
+template<typename C> struct has_capacity<C, std::void_t<decltype(std::declval<const C &>().capacity())>> : std::true_type {};
+
+/// Helper variable for checking whether a value storage is a contiguous buffer with capacity.
+template<typename C> inline constexpr bool has_capacity_v = has_capacity<C>::value;
+
+
+} // namespace traits
+
+
+/// Hot-path counters, compiled in with -DPORTER_ATTR_INSTRUMENTATION=1.
+/// When disabled, all recording functions are empty and snapshot() returns no counters.
+/// The macro must have the same value in all translation units of a program: inline functions and templates
+/// compiled with different values violate the one definition rule.
+namespace instrument {
+
+
+/// Checks whether counters are compiled in.
+inline constexpr bool enabled = PORTER_ATTR_INSTRUMENTATION;
+
+
+/// Defines counted operations.
+enum class Event : size_t
+{
+    /// Value assigned to a holder.
+    assignment,
+    /// Holder copied by a collection conversion or extension.
+    copy,
+    /// Holder moved by a collection conversion or extension.
+    move,
+    /// Holder bytes copied by collection conversions: holder size plus stored entries of Multiple holders.
+    copied_bytes,
+    /// Hash map storage of a Multiple holder rehashed.
+    rehash,
+    /// Multiple holder storage allocated: a node of a hash map, or a grown buffer of a flat map.
+    allocation,
+    /// Collection constructed or assigned from another collection type.
+    conversion,
+    /// Collection extended with attributes.
+    extension,
+    /// Number of counted operations.
+    count
+};
+
+
+/// Defines counter values indexed by Event.
+using Counters = std::array<uint64_t, size_t(Event::count)>;
+
+
+/// Defines counter values of one tag.
+struct TagCounters
+{
+    /// Stores tag name (Tag::value), empty for collection-level events.
+    std::string_view tag;
+
+    /// Stores counter values.
+    Counters counters {};
+
+    /// Get counter value.
+    uint64_t operator[](Event event) const { return counters[size_t(event)]; }
+};
+
+
+/// Defines a point-in-time copy of all counters, e.g. for exporting to a metrics system.
+struct Snapshot
+{
+    /// Stores counters of tags that recorded at least one event, most recently registered first.
+    std::vector<TagCounters> tags;
+
+    /// Stores counter sums over all tags and collection-level events.
+    Counters totals {};
+
+    /// Get counter sum.
+    uint64_t operator[](Event event) const { return totals[size_t(event)]; }
+
+    /// Find tag counters by tag name.
+    /// @param tag tag name.
+    /// @return tag counters or nullptr, if the tag did not record any event.
+    const TagCounters *find(std::string_view tag) const;
+};
+
+
+/// Defines holder storage measurement, used to detect growth across an insertion.
+struct Footprint
+{
+    /// Stores number of entries.
+    size_t size = 0;
+
+    /// Stores number of hash map buckets.
+    size_t buckets = 0;
+
+    /// Stores flat map capacity.
+    size_t capacity = 0;
+};
+
+
+#if PORTER_ATTR_INSTRUMENTATION
+/// Defines counters of one tag, linked into a global registry on first use.
+class Slot
+{
+    /// Stores tag name.
+    std::string_view d_tag;
+
+    /// Stores counter values.
+    std::array<std::atomic<uint64_t>, size_t(Event::count)> d_counts {};
+
+    /// Stores next registered slot.
+    Slot *d_next = nullptr;
+
+private:
+    /// Get registry head, the most recently registered slot.
+    static std::atomic<Slot *> &registry();
+
+public:
+    /// Construct and register tag counters.
+    /// @param tag tag name.
+    explicit Slot(std::string_view tag);
+
+    /// Slots are registered by address and are not copyable.
+    Slot(const Slot &) = delete;
+
+    /// Slots are registered by address and are not copyable.
+    Slot &operator=(const Slot &) = delete;
+
+    /// Get counters of a tag.
+    /// @tparam Tag tag type, void for collection-level events.
+    template<typename Tag>
+    static Slot &of();
+
+    /// Get the most recently registered slot.
+    static Slot *first();
+
+    /// Get the slot registered before this one.
+    Slot *next() const;
+
+    /// Count an event.
+    void add(Event event, uint64_t amount);
+
+    /// Load counter values.
+    TagCounters load() const;
+
+    /// Zero counter values.
+    void clear();
+};
+#endif
+
+
+/// Check whether the call is a part of constant evaluation, where nothing is counted.
+constexpr bool constant_evaluated();
+
+/// Count an event of a tag.
+/// @tparam Tag tag type.
+/// @param event counted operation.
+/// @param amount counter increment.
+template<typename Tag>
+constexpr void record(Event event, uint64_t amount = 1);
+
+/// Count a collection-level event.
+/// @param event counted operation.
+/// @param amount counter increment.
+constexpr void record(Event event, uint64_t amount = 1);
+
+/// Count a holder copy and its copied bytes.
+/// @tparam Tag tag type.
+/// @tparam H holder type.
+/// @param holder copied holder.
+template<typename Tag, typename H>
+constexpr void copied(const H &holder);
+
+/// Measure holder storage before an insertion.
+/// @tparam C value storage type.
+/// @param values value storage.
+/// @return storage measurement, empty when counters are disabled.
+template<typename C>
+constexpr Footprint measure(const C &values);
+
+/// Count allocations and rehashes of holder storage after an insertion.
+/// @tparam Tag tag type.
+/// @tparam C value storage type.
+/// @param before storage measurement before the insertion.
+/// @param values value storage.
+template<typename Tag, typename C>
+constexpr void grown(const Footprint &before, const C &values);
+
+/// Copy all counters.
+/// @return counters snapshot, empty when counters are disabled.
+Snapshot snapshot();
+
+/// Zero all counters.
+void reset();
+
+
+
+inline const TagCounters *Snapshot::find(std::string_view tag) const
+{
+    for (const auto &entry : tags)
+    {
+        if (entry.tag == tag)
+        {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+
+#if PORTER_ATTR_INSTRUMENTATION
+inline std::atomic<Slot *> &Slot::registry()
+{
+    static std::atomic<Slot *> head {nullptr};
+    return head;
+}
+
+inline Slot::Slot(std::string_view tag)
+    : d_tag(tag)
+{
+    auto &head = registry();
+
+    d_next = head.load(std::memory_order_relaxed);
+    while (!head.compare_exchange_weak(d_next, this, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+}
+
+template<typename Tag>
+Slot &Slot::of()
+{
+    if constexpr (std::is_void_v<Tag>)
+    {
+        static Slot slot {std::string_view {}};
+        return slot;
+    }
+    else
+    {
+        static Slot slot {Tag::value};
+        return slot;
+    }
+}
+
+inline Slot *Slot::first()
+{
+    return registry().load(std::memory_order_acquire);
+}
+
+inline Slot *Slot::next() const
+{
+    return d_next;
+}
+
+inline void Slot::add(Event event, uint64_t amount)
+{
+    d_counts[size_t(event)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+inline TagCounters Slot::load() const
+{
+    TagCounters counters {d_tag};
+    for (size_t idx = 0; idx < d_counts.size(); ++idx)
+    {
+        counters.counters[idx] = d_counts[idx].load(std::memory_order_relaxed);
+    }
+
+    return counters;
+}
+
+inline void Slot::clear()
+{
+    for (auto &count : d_counts)
+    {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+#endif
+
+
+constexpr bool constant_evaluated()
+{
+#if __cpp_lib_is_constant_evaluated
+    return std::is_constant_evaluated();
+#elif defined(__GNUC__)
+    return __builtin_is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+
+template<typename Tag>
+constexpr void record([[maybe_unused]] Event event, [[maybe_unused]] uint64_t amount)
+{
+#if PORTER_ATTR_INSTRUMENTATION
+    if (!constant_evaluated())
+    {
+        Slot::of<Tag>().add(event, amount);
+    }
+#endif
+}
+
+constexpr void record(Event event, uint64_t amount)
+{
+    record<void>(event, amount);
+}
+
+template<typename Tag, typename H>
+constexpr void copied([[maybe_unused]] const H &holder)
+{
+#if PORTER_ATTR_INSTRUMENTATION
+    uint64_t bytes = sizeof(H);
+    if constexpr (traits::has_buckets_v<std::decay_t<decltype(*holder)>> || traits::has_capacity_v<std::decay_t<decltype(*holder)>>)
+    {
+        bytes += (*holder).size() * sizeof(typename std::decay_t<decltype(*holder)>::value_type);
+    }
+
+    record<Tag>(Event::copy);
+    record<Tag>(Event::copied_bytes, bytes);
+#endif
+}
+
+template<typename C>
+constexpr Footprint measure([[maybe_unused]] const C &values)
+{
+    Footprint footprint;
+
+#if PORTER_ATTR_INSTRUMENTATION
+    footprint.size = values.size();
+    if constexpr (traits::has_buckets_v<C>)
+    {
+        footprint.buckets = values.bucket_count();
+    }
+    else if constexpr (traits::has_capacity_v<C>)
+    {
+        footprint.capacity = values.capacity();
+    }
+#endif
+
+    return footprint;
+}
+
+template<typename Tag, typename C>
+constexpr void grown([[maybe_unused]] const Footprint &before, [[maybe_unused]] const C &values)
+{
+#if PORTER_ATTR_INSTRUMENTATION
+    const Footprint after = measure(values);
+    if constexpr (traits::has_buckets_v<C>)
+    {
+        if (after.size > before.size)
+        {
+            record<Tag>(Event::allocation);
+        }
+        if (after.buckets != before.buckets)
+        {
+            record<Tag>(Event::rehash);
+        }
+    }
+    else if (after.capacity != before.capacity)
+    {
+        record<Tag>(Event::allocation);
+    }
+#endif
+}
+
+inline Snapshot snapshot()
+{
+    Snapshot snapshot;
+
+#if PORTER_ATTR_INSTRUMENTATION
+    for (Slot *slot = Slot::first(); slot; slot = slot->next())
+    {
+        TagCounters counters = slot->load();
+
+        bool recorded = false;
+        for (size_t idx = 0; idx < counters.counters.size(); ++idx)
+        {
+            snapshot.totals[idx] += counters.counters[idx];
+            recorded = recorded || counters.counters[idx];
+        }
+
+        if (recorded && !counters.tag.empty())
+        {
+            snapshot.tags.push_back(counters);
+        }
+    }
+#endif
+
+    return snapshot;
+}
+
+inline void reset()
+{
+#if PORTER_ATTR_INSTRUMENTATION
+    for (Slot *slot = Slot::first(); slot; slot = slot->next())
+    {
+        slot->clear();
+    }
+#endif
+}
+
+
+} // namespace instrument
+} // namespace porter::attr
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+
+namespace porter::attr {
+
+
+/// Compute a hash of an attribute name (64-bit FNV-1a, truncated to size_t).
+/// Usable in constant expressions, so names known at compile time can be hashed once.
+/// @param name attribute name.
+/// @return name hash.
+constexpr size_t hash_name(std::string_view name);
+
+
+/// Defines an attribute name with precomputed hash.
+/// Constant keys (see literals::operator""_akey) carry a hash computed at compile time,
+/// so that lookups by them skip runtime hashing.
+class Key
+{
+    /// Stores attribute name.
+    std::string_view d_name;
+
+    /// Stores attribute name hash.
+    size_t d_hash = hash_name({});
+
+public:
+    /// Construct a key of an empty name.
+    constexpr Key() = default;
+
+    /// Construct a key, hashing the name.
+    /// @param name attribute name.
+    constexpr explicit Key(std::string_view name);
+
+    /// Get attribute name.
+    constexpr std::string_view view() const;
+
+    /// Get attribute name hash.
+    constexpr size_t hash() const;
+
+    /// Get attribute name.
+    constexpr operator std::string_view() const;
+
+    /// Compare keys, checking hashes first.
+    friend constexpr bool operator==(const Key &lhs, const Key &rhs)
+    {
+        return lhs.d_hash == rhs.d_hash && lhs.d_name == rhs.d_name;
+    }
+
+    /// Compare keys, checking hashes first.
+    friend constexpr bool operator!=(const Key &lhs, const Key &rhs)
+    {
+        return !(lhs == rhs);
+    }
+};
+
+
+namespace literals {
+
+
+/// Define a key with compile-time hash, e.g. "LID"_akey.
+constexpr Key operator""_akey(const char *name, size_t size);
+
+
+} // namespace literals
+
+
+
+constexpr size_t hash_name(std::string_view name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+
+    return static_cast<size_t>(hash);
+}
+
+
+constexpr Key::Key(std::string_view name)
+    : d_name(name)
+    , d_hash(hash_name(name))
+{
+}
+
+constexpr std::string_view Key::view() const
+{
+    return d_name;
+}
+
+constexpr size_t Key::hash() const
+{
+    return d_hash;
+}
+
+constexpr Key::operator std::string_view() const
+{
+    return d_name;
+}
+
+
+constexpr Key literals::operator""_akey(const char *name, size_t size)
+{
+    return Key {std::string_view {name, size}};
+}
+
+
+} // namespace porter::attr
+
+
+namespace std {
+
+
+/// Keys are hashed by their precomputed hash.
+template<>
+struct hash<porter::attr::Key>
+{
+    size_t operator()(const porter::attr::Key &key) const noexcept { return key.hash(); }
+};
+
+
+} // namespace std
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+
+namespace porter::attr {
+
+
+/// Defines a copy-on-write collection made of shared immutable layers and a mutable overlay.
+/// Layers are reference-counted and shared between collections derived from each other,
+/// so deriving a collection only copies the overlay, regardless of the number of attribute values in layers.
+/// Reads check the overlay first, then layers from the most recent one.
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class Layered
+{
+    /// Defines an immutable layer.
+    struct Layer
+    {
+        /// Attribute values set on the layer.
+        Collection<Holders...> values;
+
+        /// Previous layer.
+        std::shared_ptr<const Layer> parent;
+    };
+
+    /// Stores the most recent shared layer.
+    std::shared_ptr<const Layer> d_layer;
+
+    /// Stores attribute values set since the collection was derived.
+    Collection<Holders...> d_overlay;
+
+    /// Stores whether any attribute value was set on the overlay.
+    bool d_dirty = false;
+
+private:
+    /// Construct a collection on top of a layer.
+    /// @param layer the most recent layer.
+    explicit Layered(std::shared_ptr<const Layer> layer);
+
+public:
+    /// Construct an empty collection.
+    Layered() = default;
+
+    /// Construct a collection with a single base layer.
+    /// @param base base attribute values.
+    explicit Layered(Collection<Holders...> base);
+
+    /// Set (copy or move) an attribute value on the overlay.
+    /// @tparam Attr attribute value container type (Value or KeyValue).
+    /// @param attribute attribute value container.
+    /// @return reference to self.
+    template<typename Attr>
+    Layered &operator<<(Attr &&attribute);
+
+    /// Derive a collection that shares all layers of this one.
+    /// The overlay is copied into a new shared layer, unless it is empty.
+    /// @return derived collection with an empty overlay.
+    Layered derive() const;
+
+    /// Get number of shared layers.
+    size_t depth() const;
+
+    /// Checks whether all attribute values are properly set.
+    /// @return true if all required attribute values are set on the overlay or on some layer.
+    operator bool() const;
+
+    /// Get the most recently set attribute value.
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @return attribute value or std::nullopt, if not set.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    const typename H::type &operator()(Tag) const;
+
+    /// Get the most recently set named attribute value for associative attributes (i.e. Multiple holder).
+    /// @tparam Tag attribute tag type.
+    /// @tparam K attribute name type, anything the holder can look up by.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param key attribute value name.
+    /// @return attribute value reference or std::nullopt, if not found.
+    template<
+        typename Tag,
+        typename K,
+        typename H = traits::by_tag_t<Tag, Holders...>,
+        typename = std::void_t<typename H::key_type>>
+    typename H::mapped_type operator()(Tag, const K &key) const;
+
+    /// Build a regular collection of effective attribute values.
+    /// @return collection of the most recently set attribute values.
+    Collection<Holders...> collection() const;
+};
+
+
+
+template<typename... Holders>
+Layered<Holders...>::Layered(std::shared_ptr<const Layer> layer)
+    : d_layer(std::move(layer))
+{
+}
+
+template<typename... Holders>
+Layered<Holders...>::Layered(Collection<Holders...> base)
+    : d_layer(std::make_shared<const Layer>(Layer {std::move(base), nullptr}))
+{
+}
+
+template<typename... Holders>
+template<typename Attr>
+Layered<Holders...> &Layered<Holders...>::operator<<(Attr &&attribute)
+{
+    d_overlay << std::forward<Attr>(attribute);
+    d_dirty = true;
+
+    return *this;
+}
+
+template<typename... Holders>
+Layered<Holders...> Layered<Holders...>::derive() const
+{
+    if (!d_dirty)
+    {
+        return Layered {d_layer};
+    }
+
+    return Layered {std::make_shared<const Layer>(Layer {d_overlay, d_layer})};
+}
+
+template<typename... Holders>
+size_t Layered<Holders...>::depth() const
+{
+    size_t depth = 0;
+    for (const Layer *layer = d_layer.get(); layer; layer = layer->parent.get())
+    {
+        ++depth;
+    }
+
+    return depth;
+}
+
+template<typename... Holders>
+Layered<Holders...>::operator bool() const
+{
+    auto is_ready = [&](auto tag) {
+        using H = traits::by_tag_t<decltype(tag), Holders...>;
+
+        if constexpr (traits::is_required_v<H>)
+        {
+            return (*this)(tag).has_value();
+        }
+        else
+        {
+            return true;
+        }
+    };
+
+    return (true && ... && is_ready(traits::tag_of_t<Holders> {}));
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+const typename H::type &Layered<Holders...>::operator()(Tag) const
+{
+    static_assert(!traits::is_multiple_v<H>, "Associative attributes are only accessible by name");
+
+    static const typename H::type empty;
+
+    if (const typename H::type &value = *d_overlay.template holder<H>())
+    {
+        return value;
+    }
+
+    for (const Layer *layer = d_layer.get(); layer; layer = layer->parent.get())
+    {
+        if (const typename H::type &value = *layer->values.template holder<H>())
+        {
+            return value;
+        }
+    }
+
+    return empty;
+}
+
+template<typename... Holders>
+template<typename Tag, typename K, typename H, typename>
+typename H::mapped_type Layered<Holders...>::operator()(Tag, const K &key) const
+{
+    if (typename H::mapped_type value = d_overlay.template holder<H>()(key))
+    {
+        return value;
+    }
+
+    for (const Layer *layer = d_layer.get(); layer; layer = layer->parent.get())
+    {
+        if (typename H::mapped_type value = layer->values.template holder<H>()(key))
+        {
+            return value;
+        }
+    }
+
+    return std::nullopt;
+}
+
+template<typename... Holders>
+Collection<Holders...> Layered<Holders...>::collection() const
+{
+    Collection<Holders...> effective {d_overlay};
+
+    // Inner layers are visited first, so their values are kept
+    for (const Layer *layer = d_layer.get(); layer; layer = layer->parent.get())
+    {
+        effective.merge(layer->values, KeepLeft {});
+    }
+
+    return effective;
+}
+
+
+} // namespace porter::attr
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+
+namespace porter::attr {
+
+
+/// Defines a deferred attribute value, e.g. Value<tag::host_t, Lazy<std::string>>.
+/// A lazy value is constructed either from a value or from a callable that computes it.
+/// The callable is invoked once, on the first read (get(), comparison, formatting, serialization or hashing),
+/// and its result is cached. If the callable throws, the value stays pending and the next read calls it again.
+/// Holders treat a pending value as set, so readiness checks don't force it.
+/// Evaluation is not synchronized: collections with pending values must not be read concurrently.
+/// Copies of a pending value evaluate independently.
+/// @tparam V attribute value type.
+template<typename V>
+class Lazy
+{
+    static_assert(std::is_default_constructible_v<V>, "Lazy attribute values must be default constructible");
+
+    /// Stores computed value.
+    mutable V d_value {};
+
+    /// Stores the callable that computes the value, empty once computed.
+    mutable std::function<V()> d_compute;
+
+public:
+    /// Defines computed value type.
+    using value_type = V;
+
+    /// Construct a default value.
+    Lazy() = default;
+
+    /// Construct from a value or from a callable that computes it.
+    /// @tparam Vt value type, convertible to the attribute value type, or callable type returning it.
+    /// @param value initial value or its callable.
+    template<
+        typename Vt,
+        typename = std::enable_if_t<!std::is_same_v<std::decay_t<Vt>, Lazy<V>>>,
+        typename = std::enable_if_t<std::is_invocable_r_v<V, Vt &> || std::is_constructible_v<V, Vt &&>>>
+    explicit Lazy(Vt &&value);
+
+    /// Check whether the value is not computed yet.
+    bool pending() const;
+
+    /// Get the value, computing it on first access.
+    /// Exceptions of the callable are propagated, leaving the value pending.
+    const V &get() const;
+
+    /// Get the value, computing it on first access.
+    operator const V &() const;
+
+    /// Compare computed values.
+    friend bool operator==(const Lazy &lhs, const Lazy &rhs) { return lhs.get() == rhs.get(); }
+
+    /// Compare computed values.
+    friend bool operator!=(const Lazy &lhs, const Lazy &rhs) { return !(lhs == rhs); }
+
+    /// Compare computed values.
+    friend bool operator<(const Lazy &lhs, const Lazy &rhs) { return lhs.get() < rhs.get(); }
+
+    /// Compare a computed value.
+    template<typename U, typename = std::enable_if_t<!std::is_same_v<U, Lazy>>>
+    friend auto operator==(const Lazy &lhs, const U &rhs) -> decltype(lhs.get() == rhs) { return lhs.get() == rhs; }
+
+    /// Compare a computed value.
+    template<typename U, typename = std::enable_if_t<!std::is_same_v<U, Lazy>>>
+    friend auto operator==(const U &lhs, const Lazy &rhs) -> decltype(lhs == rhs.get()) { return lhs == rhs.get(); }
+
+    /// Compare a computed value.
+    template<typename U, typename = std::enable_if_t<!std::is_same_v<U, Lazy>>>
+    friend auto operator!=(const Lazy &lhs, const U &rhs) -> decltype(lhs.get() != rhs) { return lhs.get() != rhs; }
+
+    /// Compare a computed value.
+    template<typename U, typename = std::enable_if_t<!std::is_same_v<U, Lazy>>>
+    friend auto operator!=(const U &lhs, const Lazy &rhs) -> decltype(lhs != rhs.get()) { return lhs != rhs.get(); }
+};
+
+
+namespace traits {
+
+
+/// Template that checks whether a value type is deferred.
+template<typename V> struct is_lazy : std::false_type {};
+
+/// Template that checks whether a value type is deferred.
+template<typename V> struct is_lazy<Lazy<V>> : std::true_type {};
+
+/// Helper variable for checking whether a value type is deferred.
+template<typename V> inline constexpr bool is_lazy_v = is_lazy<V>::value;
+
+
+} // namespace traits
+
+
+
+template<typename V>
+template<typename Vt, typename, typename>
+Lazy<V>::Lazy(Vt &&value)
+{
+    if constexpr (std::is_invocable_r_v<V, Vt &>)
+    {
+        d_compute = std::forward<Vt>(value);
+    }
+    else
+    {
+        d_value = V(std::forward<Vt>(value));
+    }
+}
+
+template<typename V>
+bool Lazy<V>::pending() const
+{
+    return bool(d_compute);
+}
+
+template<typename V>
+const V &Lazy<V>::get() const
+{
+    if (d_compute)
+    {
+        // The callable is dropped only once it returns, so a failed computation stays pending
+        d_value = d_compute();
+        d_compute = nullptr;
+    }
+
+    return d_value;
+}
+
+template<typename V>
+Lazy<V>::operator const V &() const
+{
+    return get();
+}
+
+
+} // namespace porter::attr
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "storage.h"
+#include "lazy.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+
+namespace porter::attr {
+
+
+/// Defines memory owned by an attribute holder or collection.
+struct MemoryUsage
+{
+    /// Stores bytes of the object itself (its sizeof), including inline entries of flat storages.
+    size_t inline_bytes = 0;
+
+    /// Stores bytes of heap allocations owned by the object.
+    /// Hash map buckets and nodes are estimated from their counts, allocator bookkeeping is not included.
+    size_t heap_bytes = 0;
+
+    /// Get total owned bytes.
+    constexpr size_t total() const { return inline_bytes + heap_bytes; }
+
+    /// Add memory owned by another object.
+    constexpr MemoryUsage &operator+=(const MemoryUsage &other)
+    {
+        inline_bytes += other.inline_bytes;
+        heap_bytes += other.heap_bytes;
+        return *this;
+    }
+};
+
+
+/// Defines heap memory owned by a value of an attribute or of its storage, specialize for custom value types.
+/// Trivially copyable values own no heap memory; other types are assumed to own some,
+/// but report none unless specialized.
+/// @tparam V value type.
+template<typename V, typename = void>
+struct HeapSize
+{
+    /// Checks whether values of the type may own heap memory.
+    static constexpr bool dynamic = !std::is_trivially_copyable_v<V>;
+
+    /// Get heap bytes owned by a value.
+    static constexpr size_t bytes(const V &) { return 0; }
+};
+
+/// Defines heap memory owned by strings past their small string buffer.
+template<typename C, typename T, typename A>
+struct HeapSize<std::basic_string<C, T, A>>
+{
+    /// Checks whether values may own heap memory.
+    static constexpr bool dynamic = true;
+
+    /// Get heap bytes owned by a value.
+    static size_t bytes(const std::basic_string<C, T, A> &value);
+};
+
+/// Defines heap memory owned by an optional value.
+template<typename V>
+struct HeapSize<std::optional<V>>
+{
+    /// Checks whether values may own heap memory.
+    static constexpr bool dynamic = HeapSize<V>::dynamic;
+
+    /// Get heap bytes owned by a value.
+    static size_t bytes(const std::optional<V> &value);
+};
+
+/// Defines heap memory owned by an optional value with allocator.
+template<typename V>
+struct HeapSize<AllocatedOptional<V>> : HeapSize<std::optional<V>> {};
+
+/// Defines heap memory owned by a key-value pair.
+template<typename K, typename V>
+struct HeapSize<std::pair<K, V>>
+{
+    /// Checks whether values may own heap memory.
+    static constexpr bool dynamic = HeapSize<std::remove_const_t<K>>::dynamic || HeapSize<V>::dynamic;
+
+    /// Get heap bytes owned by a value.
+    static size_t bytes(const std::pair<K, V> &value);
+};
+
+/// Defines heap memory owned by a deferred value.
+/// Pending values report nothing: their callable storage is opaque and they are not computed for accounting.
+template<typename V>
+struct HeapSize<Lazy<V>>
+{
+    /// Checks whether values may own heap memory.
+    static constexpr bool dynamic = true;
+
+    /// Get heap bytes owned by a value.
+    static size_t bytes(const Lazy<V> &value);
+};
+
+/// Defines heap memory owned by a hash map: bucket array, one node per entry and entries' own heap memory.
+/// Nodes are estimated as a link, a cached hash and an entry.
+template<typename K, typename V, typename H, typename E, typename A>
+struct HeapSize<std::unordered_map<K, V, H, E, A>>
+{
+    /// Checks whether values may own heap memory.
+    static constexpr bool dynamic = true;
+
+    /// Get heap bytes owned by a value.
+    static size_t bytes(const std::unordered_map<K, V, H, E, A> &values);
+};
+
+/// Defines heap memory owned by a flat map: heap buffer past the inline capacity and entries' own heap memory.
+template<typename K, typename V, size_t N, typename A>
+struct HeapSize<FlatMap<K, V, N, A>>
+{
+    /// Checks whether values may own heap memory.
+    static constexpr bool dynamic = true;
+
+    /// Get heap bytes owned by a value.
+    static size_t bytes(const FlatMap<K, V, N, A> &values);
+};
+
+
+namespace traits {
+
+
+/// Helper variable for checking whether values of a type may own heap memory.
+template<typename V> inline constexpr bool is_dynamic_v = HeapSize<V>::dynamic;
+
+
+} // namespace traits
+
+
+
+template<typename C, typename T, typename A>
+size_t HeapSize<std::basic_string<C, T, A>>::bytes(const std::basic_string<C, T, A> &value)
+{
+    const auto *data = reinterpret_cast<const unsigned char *>(value.data());
+    const auto *self = reinterpret_cast<const unsigned char *>(&value);
+
+    // Small strings keep their characters within the object
+    if (data >= self && data < self + sizeof(value))
+    {
+        return 0;
+    }
+
+    return (value.capacity() + 1) * sizeof(C);
+}
+
+template<typename V>
+size_t HeapSize<std::optional<V>>::bytes(const std::optional<V> &value)
+{
+    return value ? HeapSize<V>::bytes(*value) : 0;
+}
+
+template<typename K, typename V>
+size_t HeapSize<std::pair<K, V>>::bytes(const std::pair<K, V> &value)
+{
+    return HeapSize<std::remove_const_t<K>>::bytes(value.first) + HeapSize<V>::bytes(value.second);
+}
+
+template<typename V>
+size_t HeapSize<Lazy<V>>::bytes(const Lazy<V> &value)
+{
+    return value.pending() ? 0 : HeapSize<V>::bytes(value.get());
+}
+
+template<typename K, typename V, typename H, typename E, typename A>
+size_t HeapSize<std::unordered_map<K, V, H, E, A>>::bytes(const std::unordered_map<K, V, H, E, A> &values)
+{
+    using value_type = typename std::unordered_map<K, V, H, E, A>::value_type;
+
+    size_t bytes = values.bucket_count() * sizeof(void *);
+    bytes += values.size() * (sizeof(void *) + sizeof(size_t) + sizeof(value_type));
+
+    if constexpr (traits::is_dynamic_v<value_type>)
+    {
+        for (const auto &entry : values)
+        {
+            bytes += HeapSize<value_type>::bytes(entry);
+        }
+    }
+
+    return bytes;
+}
+
+template<typename K, typename V, size_t N, typename A>
+size_t HeapSize<FlatMap<K, V, N, A>>::bytes(const FlatMap<K, V, N, A> &values)
+{
+    using value_type = typename FlatMap<K, V, N, A>::value_type;
+
+    size_t bytes = values.capacity() > N ? values.capacity() * sizeof(value_type) : 0;
+
+    if constexpr (traits::is_dynamic_v<value_type>)
+    {
+        for (const auto &entry : values)
+        {
+            bytes += HeapSize<value_type>::bytes(entry);
+        }
+    }
+
+    return bytes;
+}
+
+
+} // namespace porter::attr
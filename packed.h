@@ -0,0 +1,388 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+
+#include <tuple>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <functional>
+#include <type_traits>
+
+
+namespace porter::attr {
+namespace traits {
+
+
+/// Template that defines the smallest unsigned integer type with at least N bits.
+template<size_t N> struct mask_of
+{
+    static_assert(N <= 64, "Too many holders for a packed collection");
+
+    using type = std::conditional_t<N <= 8, uint8_t,
+        std::conditional_t<N <= 16, uint16_t,
+        std::conditional_t<N <= 32, uint32_t, uint64_t>>>;
+};
+
+/// Helper alias for the smallest unsigned integer type with at least N bits.
+template<size_t N> using mask_of_t = typename mask_of<N>::type;
+
+
+/// Template that defines packed storage type for a holder.
+/// Single holders are stored as raw values, other holders are stored as is.
+template<typename H> struct packed { using type = H; };
+
+/// Defines packed storage type for single attribute value holder.
+template<typename Tag, bool Required, typename V> struct packed<Single<Tag, Required, V>> { using type = V; };
+
+/// Helper alias for packed storage type of a holder.
+template<typename H> using packed_t = typename packed<H>::type;
+
+
+} // namespace traits
+
+
+/// Defines a collection of unique attribute values with packed layout.
+/// Single holder values are stored without std::optional wrappers; their presence is tracked in one bitmask.
+/// Readiness check is a single mask comparison against a compile-time mask of required holders.
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class PackedCollection
+{
+    static_assert(traits::are_holders_valid_v<Holders...>, "One or more holder types are not valid");
+
+    static_assert(
+        (std::is_default_constructible_v<traits::packed_t<Holders>> && ...),
+        "Packed attribute values must be default constructible");
+
+public:
+    /// Defines presence bitmask type.
+    using mask_type = traits::mask_of_t<sizeof...(Holders)>;
+
+    /// Defines bitmask of holders that require their values to be set.
+    static constexpr mask_type required = mask_type((mask_type(0) | ... | mask_type(
+        traits::is_required_v<Holders> ? mask_type(1) << traits::index_of_v<Holders, Holders...> : 0)));
+
+    /// Defines attribute value access type for a holder.
+    /// Single holders return a reference to value or std::nullopt, other holders return value storage reference.
+    template<typename H>
+    using access_t = std::conditional_t<
+        traits::is_multiple_v<H>,
+        const typename H::type &,
+        std::optional<std::reference_wrapper<const typename H::value_type>>>;
+
+private:
+    /// Stores raw attribute values and non-single holders.
+    std::tuple<traits::packed_t<Holders>...> d_values;
+
+    /// Stores presence bits of single holder values.
+    mask_type d_present = 0;
+
+private:
+    /// Get presence bit of a holder.
+    /// @tparam H attribute holder type.
+    template<typename H>
+    static constexpr mask_type bit();
+
+    /// Update (copy) stored attribute value from a collection, if present.
+    /// @tparam Current attribute holder type to update.
+    /// @tparam Others attribute holder types of source collection.
+    /// @param other const reference to source collection.
+    template<typename Current, typename... Others>
+    void assign(const Collection<Others...> &other);
+
+    /// Update (move) stored attribute value from a collection, if present.
+    /// @tparam Current attribute holder type to update.
+    /// @tparam Others attribute holder types of source collection.
+    /// @param other rvalue reference to source collection.
+    template<typename Current, typename... Others>
+    void assign(Collection<Others...> &&other);
+
+    /// Store an attribute value.
+    /// @tparam Tag attribute tag type.
+    /// @tparam Attr attribute value container type.
+    /// @param attribute attribute value container.
+    template<typename Tag, typename Attr>
+    void set(Attr &&attribute);
+
+public:
+    /// Default ctor.
+    PackedCollection() = default;
+
+    /// Construct a packed collection by copying common attribute values from a collection.
+    /// @tparam Others attribute holder types of source collection.
+    /// @param other source collection.
+    template<typename... Others>
+    explicit PackedCollection(const Collection<Others...> &other);
+
+    /// Construct a packed collection by moving common attribute values from a collection.
+    /// @tparam Others attribute holder types of source collection.
+    /// @param other source collection.
+    template<typename... Others>
+    explicit PackedCollection(Collection<Others...> &&other);
+
+    /// Update (copy) attribute value from Value container.
+    /// @tparam Tag attribute tag type.
+    /// @tparam V attribute value type.
+    /// @param value attribute value container.
+    /// @return reference to self.
+    template<typename Tag, typename V>
+    PackedCollection<Holders...> &operator<<(const Value<Tag, V> &value);
+
+    /// Update (move) attribute value from Value container.
+    /// @tparam Tag attribute tag type.
+    /// @tparam V attribute value type.
+    /// @param value attribute value container.
+    /// @return reference to self.
+    template<typename Tag, typename V>
+    PackedCollection<Holders...> &operator<<(Value<Tag, V> &&value);
+
+    /// Update (copy) attribute value from KeyValue container.
+    /// @tparam Tag attribute tag type.
+    /// @tparam V attribute value type.
+    /// @param kv attribute value container.
+    /// @return reference to self.
+    template<typename Tag, typename V>
+    PackedCollection<Holders...> &operator<<(const KeyValue<Tag, V> &kv);
+
+    /// Update (move) attribute value from KeyValue container.
+    /// @tparam Tag attribute tag type.
+    /// @tparam V attribute value type.
+    /// @param kv attribute value container.
+    /// @return reference to self.
+    template<typename Tag, typename V>
+    PackedCollection<Holders...> &operator<<(KeyValue<Tag, V> &&kv);
+
+    /// Checks whether all attribute values are properly set.
+    /// @return true if all required attribute values are set.
+    operator bool() const;
+
+    /// Get presence bitmask of single holder values.
+    /// Holder bits follow holder declaration order.
+    mask_type present() const;
+
+    /// Get attribute value or value storage.
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @return attribute value reference (std::nullopt if not set) or value storage reference.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    access_t<H> operator()(Tag) const;
+
+    /// Get named attribute value for associative attributes (i.e. Multiple holder).
+    /// @tparam Tag attribute tag type.
+    /// @tparam K attribute name type, anything the holder can look up by.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param key attribute value name.
+    /// @return attribute value reference or std::nullopt, if not found.
+    template<
+        typename Tag,
+        typename K,
+        typename H = traits::by_tag_t<Tag, Holders...>,
+        typename = std::void_t<typename H::key_type>>
+    typename H::mapped_type operator()(Tag, const K &key) const;
+
+    /// Convert into a regular collection with the same holders.
+    /// @return regular collection with copied attribute values.
+    Collection<Holders...> unpack() const &;
+
+    /// Convert into a regular collection with the same holders.
+    /// @return regular collection with moved attribute values.
+    Collection<Holders...> unpack() &&;
+};
+
+
+
+template<typename... Holders>
+template<typename H>
+constexpr typename PackedCollection<Holders...>::mask_type PackedCollection<Holders...>::bit()
+{
+    return mask_type(mask_type(1) << traits::index_of_v<H, Holders...>);
+}
+
+template<typename... Holders>
+template<typename Current, typename... Others>
+void PackedCollection<Holders...>::assign(const Collection<Others...> &other)
+{
+    if constexpr (traits::contains_v<Current, Others...>)
+    {
+        if constexpr (traits::is_multiple_v<Current>)
+        {
+            std::get<traits::index_of_v<Current, Holders...>>(d_values) = other.template holder<Current>();
+        }
+        else if (const auto &value = *other.template holder<Current>())
+        {
+            std::get<traits::index_of_v<Current, Holders...>>(d_values) = *value;
+            d_present |= bit<Current>();
+        }
+    }
+}
+
+template<typename... Holders>
+template<typename Current, typename... Others>
+void PackedCollection<Holders...>::assign(Collection<Others...> &&other)
+{
+    if constexpr (traits::contains_v<Current, Others...>)
+    {
+        if constexpr (traits::is_multiple_v<Current>)
+        {
+            std::get<traits::index_of_v<Current, Holders...>>(d_values) = std::move(other).template holder<Current>();
+        }
+        else if (auto &value = other.template holder<Current>(); *value)
+        {
+            std::get<traits::index_of_v<Current, Holders...>>(d_values) = **std::move(value);
+            d_present |= bit<Current>();
+        }
+    }
+}
+
+template<typename... Holders>
+template<typename Tag, typename Attr>
+void PackedCollection<Holders...>::set(Attr &&attribute)
+{
+    using H = traits::by_tag_t<Tag, Holders...>;
+    constexpr size_t idx = traits::index_of_v<H, Holders...>;
+
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        std::get<idx>(d_values) = std::forward<Attr>(attribute);
+    }
+    else
+    {
+        using Expected = Value<Tag, typename H::value_type>;
+
+        static_assert(
+            !traits::is_multiple_v<traits::from_t<std::decay_t<Attr>>>,
+            "Key value pair cannot be assigned to a single value holder");
+        static_assert(
+            std::is_same_v<Expected, std::decay_t<Attr>>,
+            "Attribute can't be initialized from value of mismatching tag/type");
+
+        if (*attribute)
+        {
+            std::get<idx>(d_values) = **std::forward<Attr>(attribute);
+            d_present |= bit<H>();
+        }
+        else
+        {
+            d_present &= mask_type(~bit<H>());
+        }
+    }
+}
+
+
+template<typename... Holders>
+template<typename... Others>
+PackedCollection<Holders...>::PackedCollection(const Collection<Others...> &other)
+{
+    (assign<Holders>(other), ...);
+}
+
+template<typename... Holders>
+template<typename... Others>
+PackedCollection<Holders...>::PackedCollection(Collection<Others...> &&other)
+{
+    (assign<Holders>(std::move(other)), ...);
+}
+
+template<typename... Holders>
+template<typename Tag, typename V>
+PackedCollection<Holders...> &PackedCollection<Holders...>::operator<<(const Value<Tag, V> &value)
+{
+    set<Tag>(value);
+    return *this;
+}
+
+template<typename... Holders>
+template<typename Tag, typename V>
+PackedCollection<Holders...> &PackedCollection<Holders...>::operator<<(Value<Tag, V> &&value)
+{
+    set<Tag>(std::move(value));
+    return *this;
+}
+
+template<typename... Holders>
+template<typename Tag, typename V>
+PackedCollection<Holders...> &PackedCollection<Holders...>::operator<<(const KeyValue<Tag, V> &kv)
+{
+    set<Tag>(kv);
+    return *this;
+}
+
+template<typename... Holders>
+template<typename Tag, typename V>
+PackedCollection<Holders...> &PackedCollection<Holders...>::operator<<(KeyValue<Tag, V> &&kv)
+{
+    set<Tag>(std::move(kv));
+    return *this;
+}
+
+template<typename... Holders>
+PackedCollection<Holders...>::operator bool() const
+{
+    return (d_present & required) == required;
+}
+
+template<typename... Holders>
+typename PackedCollection<Holders...>::mask_type PackedCollection<Holders...>::present() const
+{
+    return d_present;
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+typename PackedCollection<Holders...>::template access_t<H> PackedCollection<Holders...>::operator()(Tag) const
+{
+    const auto &value = std::get<traits::index_of_v<H, Holders...>>(d_values);
+
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        return *value;
+    }
+    else
+    {
+        return d_present & bit<H>() ? std::make_optional(std::cref(value)) : std::nullopt;
+    }
+}
+
+template<typename... Holders>
+template<typename Tag, typename K, typename H, typename>
+typename H::mapped_type PackedCollection<Holders...>::operator()(Tag, const K &key) const
+{
+    return std::get<traits::index_of_v<H, Holders...>>(d_values)(key);
+}
+
+template<typename... Holders>
+Collection<Holders...> PackedCollection<Holders...>::unpack() const &
+{
+    return PackedCollection<Holders...> {*this}.unpack();
+}
+
+template<typename... Holders>
+Collection<Holders...> PackedCollection<Holders...>::unpack() &&
+{
+    Collection<Holders...> unpacked;
+
+    auto take = [&](auto tag, auto &value) {
+        using Tag = decltype(tag);
+        using H = traits::by_tag_t<Tag, Holders...>;
+
+        if constexpr (traits::is_multiple_v<H>)
+        {
+            unpacked.template holder<H>() = std::move(value);
+        }
+        else if (d_present & bit<H>())
+        {
+            unpacked << Value<Tag, typename H::value_type> {std::move(value)};
+        }
+    };
+
+    (take(traits::tag_of_t<Holders> {}, std::get<traits::index_of_v<Holders, Holders...>>(d_values)), ...);
+    d_present = 0;
+
+    return unpacked;
+}
+
+
+} // namespace porter::attr
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+
+namespace porter::attr {
+
+
+/// Defines a holder of immutable snapshots of a collection, shared between threads.
+/// Writers build a new collection and publish it atomically; old snapshots are released
+/// once the last reader referring to them moves on (reference counting).
+/// Occasional readers use load(); hot readers use a Reader, whose reads are wait-free
+/// while no new snapshot was published.
+/// @tparam C collection type, e.g. Collection<Holders...>.
+template<typename C>
+class Published
+{
+public:
+    /// Defines snapshot pointer type.
+    using pointer = std::shared_ptr<const C>;
+
+    /// Defines a per-thread reader of the published snapshots.
+    /// A reader caches the last snapshot it has seen and only touches the shared pointer when
+    /// a new snapshot is published, so that reads do not contend on reference counts.
+    /// A reader keeps its cached snapshot alive until its next read after publication.
+    class Reader
+    {
+        /// Stores source of snapshots.
+        const Published *d_source;
+
+        /// Stores cached snapshot.
+        pointer d_snapshot;
+
+        /// Stores version of cached snapshot.
+        uint64_t d_version;
+
+    public:
+        /// Construct a reader of published snapshots.
+        /// @param source source of snapshots, must outlive the reader.
+        explicit Reader(const Published &source);
+
+        /// Get the latest published snapshot.
+        /// @return reference to the snapshot, valid until the next call.
+        const C &get();
+
+        /// Get the latest published snapshot.
+        const C &operator*();
+
+        /// Get the latest published snapshot.
+        const C *operator->();
+    };
+
+private:
+    /// Stores the latest snapshot.
+#if __cpp_lib_atomic_shared_ptr
+    std::atomic<pointer> d_snapshot;
+#else
+    pointer d_snapshot;
+#endif
+
+    /// Stores snapshot version, incremented after each publication.
+    std::atomic<uint64_t> d_version {0};
+
+    /// Serializes writers, so that updates are not lost.
+    std::mutex d_writer;
+
+private:
+    /// Store a new snapshot and bump the version.
+    /// @param snapshot new snapshot.
+    void store(pointer snapshot);
+
+public:
+    /// Construct a holder with an initial snapshot.
+    /// @param initial initial collection.
+    explicit Published(C initial = {});
+
+    /// Not copyable: readers refer to the holder.
+    Published(const Published &) = delete;
+
+    /// Not copyable: readers refer to the holder.
+    Published &operator=(const Published &) = delete;
+
+    /// Get the latest published snapshot.
+    /// @return shared pointer to the snapshot.
+    pointer load() const;
+
+    /// Get version of the latest published snapshot.
+    uint64_t version() const;
+
+    /// Publish a new snapshot.
+    /// @param collection new collection.
+    void publish(C collection);
+
+    /// Publish a new snapshot, built from a copy of the latest one.
+    /// Concurrent updates are serialized, so none of them is lost.
+    /// @tparam F update function type, callable with C & (e.g. applying operator<<) or C && returning C (e.g. extend).
+    /// @param update update function.
+    template<typename F>
+    void update(F &&update);
+};
+
+
+
+template<typename C>
+Published<C>::Reader::Reader(const Published &source)
+    : d_source(&source)
+    , d_version(source.version())
+{
+    d_snapshot = source.load();
+}
+
+template<typename C>
+const C &Published<C>::Reader::get()
+{
+    if (uint64_t version = d_source->version(); version != d_version)
+    {
+        d_snapshot = d_source->load();
+        d_version = version;
+    }
+
+    return *d_snapshot;
+}
+
+template<typename C>
+const C &Published<C>::Reader::operator*()
+{
+    return get();
+}
+
+template<typename C>
+const C *Published<C>::Reader::operator->()
+{
+    return &get();
+}
+
+
+template<typename C>
+Published<C>::Published(C initial)
+    : d_snapshot(std::make_shared<const C>(std::move(initial)))
+{
+}
+
+template<typename C>
+void Published<C>::store(pointer snapshot)
+{
+#if __cpp_lib_atomic_shared_ptr
+    d_snapshot.store(std::move(snapshot));
+#else
+    std::atomic_store(&d_snapshot, std::move(snapshot));
+#endif
+
+    d_version.fetch_add(1, std::memory_order_release);
+}
+
+template<typename C>
+typename Published<C>::pointer Published<C>::load() const
+{
+#if __cpp_lib_atomic_shared_ptr
+    return d_snapshot.load();
+#else
+    return std::atomic_load(&d_snapshot);
+#endif
+}
+
+template<typename C>
+uint64_t Published<C>::version() const
+{
+    return d_version.load(std::memory_order_acquire);
+}
+
+template<typename C>
+void Published<C>::publish(C collection)
+{
+    std::lock_guard lock {d_writer};
+    store(std::make_shared<const C>(std::move(collection)));
+}
+
+template<typename C>
+template<typename F>
+void Published<C>::update(F &&update)
+{
+    std::lock_guard lock {d_writer};
+
+    C next {*load()};
+    if constexpr (std::is_invocable_v<F, C &>)
+    {
+        std::forward<F>(update)(next);
+        store(std::make_shared<const C>(std::move(next)));
+    }
+    else
+    {
+        store(std::make_shared<const C>(std::forward<F>(update)(std::move(next))));
+    }
+}
+
+
+} // namespace porter::attr
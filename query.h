@@ -0,0 +1,350 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "batch.h"
+#include "filter.h"
+#include "symbol.h"
+
+#include <functional>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+
+namespace porter::attr::query {
+
+
+/// Defines comparison operators of attribute value predicates.
+enum class Op { eq, ne, lt, le, gt, ge };
+
+
+/// Defines a predicate that compares an attribute value with a constant.
+/// Unset attribute values never match.
+/// @tparam Tag attribute tag type.
+/// @tparam O comparison operator.
+/// @tparam V constant type.
+template<typename Tag, Op O, typename V>
+struct Compare
+{
+    /// Compared constant.
+    V value;
+
+    /// Evaluate the predicate against a collection.
+    /// @tparam C collection type, e.g. Collection, PackedCollection or CollectionBatch row.
+    template<typename C>
+    bool operator()(const C &collection) const;
+
+    /// Evaluate the predicate against a batch.
+    template<typename... Holders>
+    Selection select(const CollectionBatch<Holders...> &batch) const;
+};
+
+/// Defines a predicate that checks whether an attribute value is set.
+/// @tparam Tag attribute tag type.
+template<typename Tag>
+struct Has
+{
+    /// Evaluate the predicate against a collection.
+    template<typename C>
+    bool operator()(const C &collection) const;
+
+    /// Evaluate the predicate against a batch.
+    template<typename... Holders>
+    Selection select(const CollectionBatch<Holders...> &batch) const;
+};
+
+/// Defines a predicate that checks whether a named attribute value of an associative attribute is set.
+/// @tparam Tag attribute tag type.
+/// @tparam K attribute name type.
+template<typename Tag, typename K>
+struct HasKey
+{
+    /// Attribute value name.
+    K key;
+
+    /// Evaluate the predicate against a collection.
+    template<typename C>
+    bool operator()(const C &collection) const;
+
+    /// Evaluate the predicate against a batch.
+    template<typename... Holders>
+    Selection select(const CollectionBatch<Holders...> &batch) const;
+};
+
+/// Defines a conjunction of predicates.
+template<typename L, typename R>
+struct And
+{
+    /// Left operand.
+    L lhs;
+
+    /// Right operand.
+    R rhs;
+
+    /// Evaluate the predicate against a collection.
+    template<typename C>
+    bool operator()(const C &collection) const { return lhs(collection) && rhs(collection); }
+
+    /// Evaluate the predicate against a batch.
+    template<typename... Holders>
+    Selection select(const CollectionBatch<Holders...> &batch) const { return lhs.select(batch) & rhs.select(batch); }
+};
+
+/// Defines a disjunction of predicates.
+template<typename L, typename R>
+struct Or
+{
+    /// Left operand.
+    L lhs;
+
+    /// Right operand.
+    R rhs;
+
+    /// Evaluate the predicate against a collection.
+    template<typename C>
+    bool operator()(const C &collection) const { return lhs(collection) || rhs(collection); }
+
+    /// Evaluate the predicate against a batch.
+    template<typename... Holders>
+    Selection select(const CollectionBatch<Holders...> &batch) const { return lhs.select(batch) | rhs.select(batch); }
+};
+
+/// Defines a negation of a predicate.
+template<typename E>
+struct Not
+{
+    /// Operand.
+    E operand;
+
+    /// Evaluate the predicate against a collection.
+    template<typename C>
+    bool operator()(const C &collection) const { return !operand(collection); }
+
+    /// Evaluate the predicate against a batch.
+    template<typename... Holders>
+    Selection select(const CollectionBatch<Holders...> &batch) const { return ~operand.select(batch); }
+};
+
+
+} // namespace porter::attr::query
+
+
+namespace porter::attr::traits {
+
+
+/// Template that checks whether a type is a query expression.
+template<typename T> struct is_expression : std::false_type {};
+
+template<typename Tag, query::Op O, typename V> struct is_expression<query::Compare<Tag, O, V>> : std::true_type {};
+template<typename Tag> struct is_expression<query::Has<Tag>> : std::true_type {};
+template<typename Tag, typename K> struct is_expression<query::HasKey<Tag, K>> : std::true_type {};
+template<typename L, typename R> struct is_expression<query::And<L, R>> : std::true_type {};
+template<typename L, typename R> struct is_expression<query::Or<L, R>> : std::true_type {};
+template<typename E> struct is_expression<query::Not<E>> : std::true_type {};
+
+/// Helper variable for checking whether a type is a query expression.
+template<typename T> inline constexpr bool is_expression_v = is_expression<std::decay_t<T>>::value;
+
+
+/// Template that defines constant type of a comparison against an attribute value, e.g. decays string literals.
+/// Interned strings are kept, so that they are compared by symbol identity.
+template<typename Tag, typename V>
+using compared_t = std::conditional_t<
+    is_interned_v<std::decay_t<V>>,
+    std::decay_t<V>,
+    std::conditional_t<
+        std::is_convertible_v<V, std::string_view> && std::is_convertible_v<typename Tag::type, std::string_view>,
+        std::string_view,
+        typename Tag::type>>;
+
+
+} // namespace porter::attr::traits
+
+
+namespace porter::attr::query {
+
+
+/// Unwrap an attribute value returned by collection accessors.
+/// @return pointer to attribute value or nullptr if not set.
+template<typename V>
+const V *get(const std::optional<V> &value) { return value ? &*value : nullptr; }
+
+/// Unwrap an attribute value returned by collection accessors.
+/// @return pointer to attribute value or nullptr if not set.
+template<typename V>
+const V *get(const std::optional<std::reference_wrapper<const V>> &value) { return value ? &value->get() : nullptr; }
+
+
+/// Define comparison of attribute values with constants, e.g. tag::service == "pisvc".
+/// Tag types are not declared in this namespace, so expressions need `using namespace porter::attr::query`.
+#define PORTER_ATTR_QUERY_COMPARE(op, name) \
+template<typename Tag, typename V, typename = std::enable_if_t<traits::is_tag_valid_v<Tag> && !traits::is_expression_v<V>>> \
+Compare<Tag, Op::name, traits::compared_t<Tag, V>> operator op(Tag, V &&value) \
+{ \
+    return {traits::compared_t<Tag, V>(std::forward<V>(value))}; \
+}
+
+PORTER_ATTR_QUERY_COMPARE(==, eq)
+PORTER_ATTR_QUERY_COMPARE(!=, ne)
+PORTER_ATTR_QUERY_COMPARE(<, lt)
+PORTER_ATTR_QUERY_COMPARE(<=, le)
+PORTER_ATTR_QUERY_COMPARE(>, gt)
+PORTER_ATTR_QUERY_COMPARE(>=, ge)
+
+#undef PORTER_ATTR_QUERY_COMPARE
+
+
+/// Create a predicate that checks whether an attribute value is set.
+template<typename Tag>
+Has<Tag> has(Tag) { return {}; }
+
+/// Create a predicate that checks whether a named attribute value of an associative attribute is set.
+template<typename Tag, typename K>
+HasKey<Tag, std::conditional_t<std::is_convertible_v<K, std::string_view>, std::string_view, std::decay_t<K>>>
+has(Tag, K &&key) { return {std::forward<K>(key)}; }
+
+/// Define conjunction of predicates.
+template<typename L, typename R, typename = std::enable_if_t<traits::is_expression_v<L> && traits::is_expression_v<R>>>
+And<std::decay_t<L>, std::decay_t<R>> operator&&(L &&lhs, R &&rhs) { return {std::forward<L>(lhs), std::forward<R>(rhs)}; }
+
+/// Define disjunction of predicates.
+template<typename L, typename R, typename = std::enable_if_t<traits::is_expression_v<L> && traits::is_expression_v<R>>>
+Or<std::decay_t<L>, std::decay_t<R>> operator||(L &&lhs, R &&rhs) { return {std::forward<L>(lhs), std::forward<R>(rhs)}; }
+
+/// Define negation of a predicate.
+template<typename E, typename = std::enable_if_t<traits::is_expression_v<E>>>
+Not<std::decay_t<E>> operator!(E &&operand) { return {std::forward<E>(operand)}; }
+
+
+/// Select batch rows by evaluating a predicate against each row.
+/// Used for predicates that have no columnar evaluation.
+/// @tparam Holders attribute holder types of the batch.
+/// @tparam P predicate type.
+/// @param batch batch of collections.
+/// @param predicate predicate.
+/// @return selected rows.
+template<typename... Holders, typename P>
+Selection select_rows(const CollectionBatch<Holders...> &batch, const P &predicate);
+
+
+
+template<typename Tag, Op O, typename V>
+template<typename C>
+bool Compare<Tag, O, V>::operator()(const C &collection) const
+{
+    const auto *actual = get(collection(Tag {}));
+    if (!actual)
+    {
+        return false;
+    }
+
+    if constexpr (O == Op::eq)
+    {
+        return *actual == value;
+    }
+    else if constexpr (O == Op::ne)
+    {
+        return *actual != value;
+    }
+    else if constexpr (O == Op::lt)
+    {
+        return *actual < value;
+    }
+    else if constexpr (O == Op::le)
+    {
+        return *actual <= value;
+    }
+    else if constexpr (O == Op::gt)
+    {
+        return *actual > value;
+    }
+    else
+    {
+        return *actual >= value;
+    }
+}
+
+template<typename Tag, Op O, typename V>
+template<typename... Holders>
+Selection Compare<Tag, O, V>::select(const CollectionBatch<Holders...> &batch) const
+{
+    using T = typename Tag::type;
+    using H = traits::by_tag_t<Tag, Holders...>;
+
+    if constexpr (traits::is_interned_v<typename H::value_type> && (O == Op::eq || O == Op::ne))
+    {
+        const Selection equal = attr::select(batch, filter::equal(Tag {}, value));
+        return O == Op::eq ? equal : ~equal & has(Tag {}).select(batch);
+    }
+    else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+    {
+        constexpr T min = std::numeric_limits<T>::min();
+        constexpr T max = std::numeric_limits<T>::max();
+
+        switch (O)
+        {
+            case Op::eq: return attr::select(batch, filter::equal(Tag {}, value));
+            case Op::ne: return ~attr::select(batch, filter::equal(Tag {}, value)) & has(Tag {}).select(batch);
+            case Op::lt: return value == min ? Selection {batch.size()} : attr::select(batch, filter::between(Tag {}, min, T(value - 1)));
+            case Op::le: return attr::select(batch, filter::between(Tag {}, min, value));
+            case Op::gt: return value == max ? Selection {batch.size()} : attr::select(batch, filter::between(Tag {}, T(value + 1), max));
+            case Op::ge: return attr::select(batch, filter::between(Tag {}, value, max));
+        }
+
+        return Selection {batch.size()};
+    }
+    else
+    {
+        return select_rows(batch, *this);
+    }
+}
+
+
+template<typename Tag>
+template<typename C>
+bool Has<Tag>::operator()(const C &collection) const
+{
+    return get(collection(Tag {})) != nullptr;
+}
+
+template<typename Tag>
+template<typename... Holders>
+Selection Has<Tag>::select(const CollectionBatch<Holders...> &batch) const
+{
+    return attr::select(batch, filter::present(Tag {}));
+}
+
+
+template<typename Tag, typename K>
+template<typename C>
+bool HasKey<Tag, K>::operator()(const C &collection) const
+{
+    return collection(Tag {}, key).has_value();
+}
+
+template<typename Tag, typename K>
+template<typename... Holders>
+Selection HasKey<Tag, K>::select(const CollectionBatch<Holders...> &batch) const
+{
+    return select_rows(batch, *this);
+}
+
+
+template<typename... Holders, typename P>
+Selection select_rows(const CollectionBatch<Holders...> &batch, const P &predicate)
+{
+    Selection selection {batch.size()};
+
+    for (size_t row = 0; row < batch.size(); ++row)
+    {
+        selection.words()[row / 64] |= uint64_t(predicate(batch[row])) << (row % 64);
+    }
+
+    return selection;
+}
+
+
+} // namespace porter::attr::query
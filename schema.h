@@ -0,0 +1,682 @@
+#pragma once
+
+#include "key.h"
+#include "storage.h"
+#include "memory.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace porter::attr {
+
+
+/// Defines a multiplicative hash of name hashes onto 2^bits slots.
+struct PerfectHash
+{
+    /// Odd multiplier.
+    uint64_t multiplier = 0;
+
+    /// Number of slot bits.
+    uint32_t bits = 0;
+
+    /// Checks whether the hash maps all names onto distinct slots.
+    bool found = false;
+
+    /// Get slot of a name hash.
+    constexpr size_t slot(size_t hash) const
+    {
+        return bits == 0 ? 0 : size_t((uint64_t(hash) * multiplier) >> (64 - bits));
+    }
+};
+
+
+/// Search for a perfect hash of keys, using at most four times as many slots as the least power of two
+/// not below the number of keys, i.e. fewer than eight slots per key (e.g. up to 16 slots for 3 keys).
+/// @tparam N number of keys.
+/// @param keys keys with precomputed hashes.
+/// @return perfect hash, not found if keys are not unique.
+template<size_t N>
+constexpr PerfectHash perfect_hash(const std::array<Key, N> &keys);
+
+
+/// Defines a compile-time schema: a fixed set of attribute names addressed by a perfect hash.
+/// @tparam Keys type with a static constexpr array of std::string_view names `values`, e.g.
+///     struct ContextKeys { static constexpr std::string_view values[] = {"LID", "DFPATH"}; };
+template<typename Keys>
+struct Schema
+{
+    /// Defines number of names.
+    static constexpr size_t size = std::size(Keys::values);
+
+    /// Defines position of names that are not in the schema.
+    static constexpr size_t npos = size;
+
+    /// Defines names with precomputed hashes.
+    static constexpr std::array<Key, size> keys = [] {
+        std::array<Key, size> keys {};
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+            keys[idx] = Key {Keys::values[idx]};
+        }
+        return keys;
+    }();
+
+    /// Defines perfect hash of names.
+    static constexpr PerfectHash hash = perfect_hash(keys);
+
+    static_assert(size > 0, "Schema must define at least one name");
+    static_assert(hash.found, "Schema names must be unique");
+
+    /// Defines name positions by slot, npos for unused slots.
+    static constexpr std::array<size_t, size_t(1) << hash.bits> slots = [] {
+        std::array<size_t, size_t(1) << hash.bits> slots {};
+        for (size_t &slot : slots)
+        {
+            slot = npos;
+        }
+        for (size_t idx = 0; idx < size; ++idx)
+        {
+            slots[hash.slot(keys[idx].hash())] = idx;
+        }
+        return slots;
+    }();
+
+    /// Find position of a name. Constant keys, e.g. "LID"_akey, are resolved at compile time.
+    /// @param key name with precomputed hash.
+    /// @return name position or npos, if the name is not in the schema.
+    static constexpr size_t index(const Key &key);
+
+    /// Find position of a name, hashing it.
+    /// @param name attribute name.
+    /// @return name position or npos, if the name is not in the schema.
+    static constexpr size_t index(std::string_view name);
+};
+
+
+/// Defines an associative container for a fixed set of names: values of schema names are kept in slots
+/// addressed by their perfect hash, other names are kept in an overflow buffer and looked up linearly.
+/// Iteration visits set schema slots in schema order, then overflow entries in insertion order.
+/// @tparam V entry value type.
+/// @tparam Keys schema names, see Schema.
+/// @tparam Alloc allocator type for the overflow buffer.
+template<typename V, typename Keys, typename Alloc = std::allocator<std::pair<Key, V>>>
+class SchemaMap
+{
+public:
+    /// Defines schema type.
+    using schema_type = Schema<Keys>;
+
+    /// Defines entry key type.
+    using key_type = Key;
+
+    /// Defines entry value type.
+    using mapped_type = V;
+
+    /// Defines entry type.
+    using value_type = std::pair<Key, V>;
+
+    /// Defines size type.
+    using size_type = size_t;
+
+    /// Defines allocator type.
+    using allocator_type = Alloc;
+
+private:
+    /// Defines iterator over schema slots and overflow entries.
+    template<bool Const>
+    class Iterator
+    {
+        friend class SchemaMap;
+
+        template<bool> friend class Iterator;
+
+        /// Defines iterated container type.
+        using map_type = std::conditional_t<Const, const SchemaMap, SchemaMap>;
+
+        /// Stores iterated container.
+        map_type *d_map = nullptr;
+
+        /// Stores position: schema slots first, then overflow entries.
+        size_type d_pos = 0;
+
+    private:
+        /// Construct an iterator at the first set entry starting from a position.
+        Iterator(map_type *map, size_type pos);
+
+        /// Skip unset schema slots.
+        void skip();
+
+    public:
+        /// Defines iterator category.
+        using iterator_category = std::forward_iterator_tag;
+
+        /// Defines entry type.
+        using value_type = typename SchemaMap::value_type;
+
+        /// Defines distance type.
+        using difference_type = ptrdiff_t;
+
+        /// Defines entry pointer type.
+        using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+        /// Defines entry reference type.
+        using reference = std::conditional_t<Const, const value_type &, value_type &>;
+
+        /// Default ctor.
+        Iterator() = default;
+
+        /// Convert a mutable iterator.
+        template<bool Other, typename = std::enable_if_t<Const && !Other>>
+        Iterator(const Iterator<Other> &other);
+
+        /// Get entry.
+        reference operator*() const;
+
+        /// Get entry.
+        pointer operator->() const;
+
+        /// Advance to the next entry.
+        Iterator &operator++();
+
+        /// Advance to the next entry.
+        Iterator operator++(int);
+
+        /// Compare positions.
+        template<bool Other>
+        bool operator==(const Iterator<Other> &other) const { return d_pos == other.d_pos; }
+
+        /// Compare positions.
+        template<bool Other>
+        bool operator!=(const Iterator<Other> &other) const { return d_pos != other.d_pos; }
+    };
+
+public:
+    /// Defines mutable iterator type.
+    using iterator = Iterator<false>;
+
+    /// Defines const iterator type.
+    using const_iterator = Iterator<true>;
+
+private:
+    /// Stores values of schema names.
+    std::array<std::optional<value_type>, schema_type::size> d_slots;
+
+    /// Stores values of other names.
+    std::vector<value_type, Alloc> d_overflow;
+
+    /// Stores number of set schema slots.
+    size_type d_used = 0;
+
+private:
+    /// Find position of an overflow entry.
+    /// @param key entry key.
+    /// @return overflow position or number of overflow entries, if not found.
+    size_type find_overflow(const key_type &key) const;
+
+public:
+    /// Default ctor.
+    SchemaMap() = default;
+
+    /// Construct an empty container with provided allocator.
+    /// @param allocator allocator for the overflow buffer.
+    explicit SchemaMap(const allocator_type &allocator);
+
+    /// Default copy ctor.
+    SchemaMap(const SchemaMap &) = default;
+
+    /// Copy ctor with provided allocator.
+    SchemaMap(const SchemaMap &other, const allocator_type &allocator);
+
+    /// Default move ctor.
+    SchemaMap(SchemaMap &&) = default;
+
+    /// Move ctor with provided allocator.
+    SchemaMap(SchemaMap &&other, const allocator_type &allocator);
+
+    /// Default copy assignment.
+    SchemaMap &operator=(const SchemaMap &) = default;
+
+    /// Default move assignment.
+    SchemaMap &operator=(SchemaMap &&) = default;
+
+    /// Get allocator.
+    allocator_type get_allocator() const;
+
+    /// Get iterator to the first entry.
+    iterator begin();
+
+    /// Get iterator past the last entry.
+    iterator end();
+
+    /// Get iterator to the first entry.
+    const_iterator begin() const;
+
+    /// Get iterator past the last entry.
+    const_iterator end() const;
+
+    /// Get number of entries.
+    size_type size() const;
+
+    /// Checks whether there are no entries.
+    bool empty() const;
+
+    /// Get number of entries that can be stored without reallocation: schema slots and overflow capacity.
+    size_type capacity() const;
+
+    /// Get number of overflow entries, i.e. of names that are not in the schema.
+    size_type overflow() const;
+
+    /// Reserve storage for entries. Schema slots need no reservation, so the overflow buffer is reserved
+    /// for entries beyond the set schema slots, as if all of them were names out of the schema.
+    /// @param capacity number of entries.
+    void reserve(size_type capacity);
+
+    /// Remove an entry.
+    /// @param pos iterator to the entry.
+    /// @return iterator to the entry following the removed one.
+    iterator erase(const_iterator pos);
+
+    /// Find entry by key.
+    /// @param key entry key.
+    /// @return iterator to found entry or end().
+    iterator find(const key_type &key);
+
+    /// Find entry by key.
+    /// @param key entry key.
+    /// @return iterator to found entry or end().
+    const_iterator find(const key_type &key) const;
+
+    /// Get value by key, inserting default constructed value if not found.
+    /// @param key entry key.
+    /// @return reference to entry value.
+    mapped_type &operator[](const key_type &key);
+
+    /// Get value by key, inserting default constructed value if not found.
+    /// @param key entry key.
+    /// @return reference to entry value.
+    mapped_type &operator[](key_type &&key);
+
+    /// Get value by schema position, see Schema::index().
+    /// @tparam Idx name position.
+    /// @return stored value pointer or nullptr, if the value is not set.
+    template<size_t Idx>
+    const mapped_type *slot() const;
+};
+
+
+namespace storage {
+
+
+/// Storage policy that keeps values of a fixed set of names in slots addressed by a compile-time perfect hash.
+/// Names out of the schema are still accepted and kept in an overflow buffer.
+/// @tparam Keys schema names, see Schema.
+/// @tparam Alloc allocator template for the overflow buffer.
+template<typename Keys, template<typename> typename Alloc>
+struct BasicFixed
+{
+    /// Defines storage key type.
+    using key_type = Key;
+
+    /// Defines value storage type.
+    template<typename K, typename V> using type = SchemaMap<V, Keys, Alloc<std::pair<Key, V>>>;
+
+    /// Translate attribute name into storage key, hashing it.
+    static key_type key(std::string_view key) { return Key {key}; }
+
+    /// Translate attribute name into storage key.
+    static key_type key(const Key &key) { return key; }
+
+    /// Look up a value by attribute name, hashing it.
+    template<typename C>
+    static typename C::const_iterator find(const C &values, std::string_view key) { return values.find(Key {key}); }
+
+    /// Look up a value by attribute name with precomputed hash.
+    template<typename C>
+    static typename C::const_iterator find(const C &values, const Key &key) { return values.find(key); }
+};
+
+
+/// Storage policy that keeps values of a fixed set of names in schema slots.
+template<typename Keys> using Fixed = BasicFixed<Keys, std::allocator>;
+
+
+namespace pmr {
+
+
+/// Storage policy that keeps values of a fixed set of names in schema slots, with overflow on a memory resource.
+template<typename Keys> using Fixed = BasicFixed<Keys, std::pmr::polymorphic_allocator>;
+
+
+} // namespace pmr
+} // namespace storage
+
+
+/// Defines heap memory owned by a schema map: overflow buffer and entries' own heap memory.
+template<typename V, typename Keys, typename A>
+struct HeapSize<SchemaMap<V, Keys, A>>
+{
+    /// Checks whether values may own heap memory.
+    static constexpr bool dynamic = true;
+
+    /// Get heap bytes owned by a value.
+    static size_t bytes(const SchemaMap<V, Keys, A> &values);
+};
+
+
+
+template<size_t N>
+constexpr PerfectHash perfect_hash(const std::array<Key, N> &keys)
+{
+    uint32_t bits = 0;
+    while ((size_t(1) << bits) < N)
+    {
+        ++bits;
+    }
+
+    for (const uint32_t max_bits = bits + 2; bits <= max_bits; ++bits)
+    {
+        for (uint64_t attempt = 1; attempt <= 1024; ++attempt)
+        {
+            const PerfectHash hash {0x9E3779B97F4A7C15ull * attempt | 1, bits, true};
+
+            // At most 2^(log2(N) + 2) < 8N slots are used
+            std::array<bool, 8 * N> used {};
+            bool distinct = true;
+            for (size_t idx = 0; idx < N && distinct; ++idx)
+            {
+                const size_t slot = hash.slot(keys[idx].hash());
+                distinct = !used[slot];
+                used[slot] = true;
+            }
+
+            if (distinct)
+            {
+                return hash;
+            }
+        }
+    }
+
+    return {};
+}
+
+
+template<typename Keys>
+constexpr size_t Schema<Keys>::index(const Key &key)
+{
+    const size_t idx = slots[hash.slot(key.hash())];
+    return idx != npos && keys[idx] == key ? idx : npos;
+}
+
+template<typename Keys>
+constexpr size_t Schema<Keys>::index(std::string_view name)
+{
+    return index(Key {name});
+}
+
+
+template<typename V, typename Keys, typename Alloc>
+template<bool Const>
+SchemaMap<V, Keys, Alloc>::Iterator<Const>::Iterator(map_type *map, size_type pos)
+    : d_map(map)
+    , d_pos(pos)
+{
+    skip();
+}
+
+template<typename V, typename Keys, typename Alloc>
+template<bool Const>
+void SchemaMap<V, Keys, Alloc>::Iterator<Const>::skip()
+{
+    while (d_pos < schema_type::size && !d_map->d_slots[d_pos])
+    {
+        ++d_pos;
+    }
+}
+
+template<typename V, typename Keys, typename Alloc>
+template<bool Const>
+template<bool Other, typename>
+SchemaMap<V, Keys, Alloc>::Iterator<Const>::Iterator(const Iterator<Other> &other)
+    : d_map(other.d_map)
+    , d_pos(other.d_pos)
+{
+}
+
+template<typename V, typename Keys, typename Alloc>
+template<bool Const>
+typename SchemaMap<V, Keys, Alloc>::template Iterator<Const>::reference SchemaMap<V, Keys, Alloc>::Iterator<Const>::operator*() const
+{
+    if (d_pos < schema_type::size)
+    {
+        return *d_map->d_slots[d_pos];
+    }
+
+    return d_map->d_overflow[d_pos - schema_type::size];
+}
+
+template<typename V, typename Keys, typename Alloc>
+template<bool Const>
+typename SchemaMap<V, Keys, Alloc>::template Iterator<Const>::pointer SchemaMap<V, Keys, Alloc>::Iterator<Const>::operator->() const
+{
+    return &**this;
+}
+
+template<typename V, typename Keys, typename Alloc>
+template<bool Const>
+typename SchemaMap<V, Keys, Alloc>::template Iterator<Const> &SchemaMap<V, Keys, Alloc>::Iterator<Const>::operator++()
+{
+    ++d_pos;
+    skip();
+
+    return *this;
+}
+
+template<typename V, typename Keys, typename Alloc>
+template<bool Const>
+typename SchemaMap<V, Keys, Alloc>::template Iterator<Const> SchemaMap<V, Keys, Alloc>::Iterator<Const>::operator++(int)
+{
+    Iterator current = *this;
+    ++*this;
+
+    return current;
+}
+
+
+template<typename V, typename Keys, typename Alloc>
+SchemaMap<V, Keys, Alloc>::SchemaMap(const allocator_type &allocator)
+    : d_overflow(allocator)
+{
+}
+
+template<typename V, typename Keys, typename Alloc>
+SchemaMap<V, Keys, Alloc>::SchemaMap(const SchemaMap &other, const allocator_type &allocator)
+    : d_slots(other.d_slots)
+    , d_overflow(other.d_overflow, allocator)
+    , d_used(other.d_used)
+{
+}
+
+template<typename V, typename Keys, typename Alloc>
+SchemaMap<V, Keys, Alloc>::SchemaMap(SchemaMap &&other, const allocator_type &allocator)
+    : d_slots(std::move(other.d_slots))
+    , d_overflow(std::move(other.d_overflow), allocator)
+    , d_used(other.d_used)
+{
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::allocator_type SchemaMap<V, Keys, Alloc>::get_allocator() const
+{
+    return d_overflow.get_allocator();
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::iterator SchemaMap<V, Keys, Alloc>::begin()
+{
+    return iterator {this, 0};
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::iterator SchemaMap<V, Keys, Alloc>::end()
+{
+    return iterator {this, schema_type::size + d_overflow.size()};
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::const_iterator SchemaMap<V, Keys, Alloc>::begin() const
+{
+    return const_iterator {this, 0};
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::const_iterator SchemaMap<V, Keys, Alloc>::end() const
+{
+    return const_iterator {this, schema_type::size + d_overflow.size()};
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::size_type SchemaMap<V, Keys, Alloc>::size() const
+{
+    return d_used + d_overflow.size();
+}
+
+template<typename V, typename Keys, typename Alloc>
+bool SchemaMap<V, Keys, Alloc>::empty() const
+{
+    return size() == 0;
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::size_type SchemaMap<V, Keys, Alloc>::capacity() const
+{
+    return schema_type::size + d_overflow.capacity();
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::size_type SchemaMap<V, Keys, Alloc>::overflow() const
+{
+    return d_overflow.size();
+}
+
+template<typename V, typename Keys, typename Alloc>
+void SchemaMap<V, Keys, Alloc>::reserve(size_type capacity)
+{
+    if (capacity > d_used)
+    {
+        d_overflow.reserve(capacity - d_used);
+    }
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::iterator SchemaMap<V, Keys, Alloc>::erase(const_iterator pos)
+{
+    if (pos.d_pos < schema_type::size)
+    {
+        d_slots[pos.d_pos].reset();
+        --d_used;
+        return iterator {this, pos.d_pos + 1};
+    }
+
+    d_overflow.erase(d_overflow.begin() + (pos.d_pos - schema_type::size));
+    return iterator {this, pos.d_pos};
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::iterator SchemaMap<V, Keys, Alloc>::find(const key_type &key)
+{
+    return iterator {this, std::as_const(*this).find(key).d_pos};
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::const_iterator SchemaMap<V, Keys, Alloc>::find(const key_type &key) const
+{
+    if (const size_t idx = schema_type::index(key); idx != schema_type::npos)
+    {
+        return d_slots[idx] ? const_iterator {this, idx} : end();
+    }
+
+    return const_iterator {this, schema_type::size + find_overflow(key)};
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::size_type SchemaMap<V, Keys, Alloc>::find_overflow(const key_type &key) const
+{
+    size_type idx = 0;
+    while (idx < d_overflow.size() && d_overflow[idx].first != key)
+    {
+        ++idx;
+    }
+
+    return idx;
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::mapped_type &SchemaMap<V, Keys, Alloc>::operator[](const key_type &key)
+{
+    return (*this)[key_type {key}];
+}
+
+template<typename V, typename Keys, typename Alloc>
+typename SchemaMap<V, Keys, Alloc>::mapped_type &SchemaMap<V, Keys, Alloc>::operator[](key_type &&key)
+{
+    if (const size_t idx = schema_type::index(key); idx != schema_type::npos)
+    {
+        std::optional<value_type> &slot = d_slots[idx];
+        if (!slot)
+        {
+            // Schema keys have static names, so stored names never dangle
+            slot.emplace(schema_type::keys[idx], V {});
+            ++d_used;
+        }
+
+        return slot->second;
+    }
+
+    if (const size_type idx = find_overflow(key); idx < d_overflow.size())
+    {
+        return d_overflow[idx].second;
+    }
+
+    return d_overflow.emplace_back(std::move(key), V {}).second;
+}
+
+template<typename V, typename Keys, typename Alloc>
+template<size_t Idx>
+const typename SchemaMap<V, Keys, Alloc>::mapped_type *SchemaMap<V, Keys, Alloc>::slot() const
+{
+    static_assert(Idx < schema_type::size, "Schema position is out of range");
+
+    return d_slots[Idx] ? &d_slots[Idx]->second : nullptr;
+}
+
+
+template<typename V, typename Keys, typename A>
+size_t HeapSize<SchemaMap<V, Keys, A>>::bytes(const SchemaMap<V, Keys, A> &values)
+{
+    using value_type = typename SchemaMap<V, Keys, A>::value_type;
+
+    size_t bytes = (values.capacity() - Schema<Keys>::size) * sizeof(value_type);
+
+    if constexpr (traits::is_dynamic_v<value_type>)
+    {
+        for (const auto &entry : values)
+        {
+            bytes += HeapSize<value_type>::bytes(entry);
+        }
+    }
+
+    return bytes;
+}
+
+
+} // namespace porter::attr
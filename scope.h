@@ -0,0 +1,206 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+
+namespace porter::attr {
+
+
+/// Defines a frame of a thread-local stack of attribute values.
+/// Frames are scope guards: constructing one pushes it on top of calling thread's stack, destroying it pops it.
+/// Pushing does not copy outer frames, each frame only stores attribute values set on it.
+/// Reads resolve the innermost set value of an attribute.
+/// Frames must be destroyed in reverse order of construction, on the thread that constructed them.
+/// @tparam Holders pack of attribute holder types (stack schema).
+template<typename... Holders>
+class Scope
+{
+    /// Stores innermost frame of calling thread's stack.
+    static inline thread_local const Scope *t_top = nullptr;
+
+    /// Stores attribute values set on this frame.
+    Collection<Holders...> d_frame;
+
+    /// Stores enclosing frame.
+    const Scope *d_parent;
+
+public:
+    /// Push an empty frame.
+    Scope();
+
+    /// Push a frame with attribute values.
+    /// @tparam Attrs pack of attribute value containers.
+    /// @param attributes pack of attribute value containers.
+    template<typename... Attrs, typename = std::enable_if_t<(sizeof...(Attrs) > 0)>>
+    explicit Scope(Attrs &&...attributes);
+
+    /// Not copyable: frames are linked by address.
+    Scope(const Scope &) = delete;
+
+    /// Not copyable: frames are linked by address.
+    Scope &operator=(const Scope &) = delete;
+
+    /// Pop the frame.
+    ~Scope();
+
+    /// Set (copy or move) an attribute value on this frame.
+    /// @tparam Attr attribute value container type (Value or KeyValue).
+    /// @param attribute attribute value container.
+    /// @return reference to self.
+    template<typename Attr>
+    Scope &operator<<(Attr &&attribute);
+
+    /// Get attribute values set on this frame.
+    const Collection<Holders...> &frame() const;
+
+    /// Get innermost frame of calling thread's stack.
+    /// @return innermost frame or nullptr if the stack is empty.
+    static const Scope *top();
+
+    /// Get innermost set attribute value of calling thread's stack.
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @return attribute value or std::nullopt, if not set on any frame.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    static const typename H::type &get(Tag);
+
+    /// Get innermost set named attribute value for associative attributes (i.e. Multiple holder).
+    /// @tparam Tag attribute tag type.
+    /// @tparam K attribute name type, anything the holder can look up by.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param key attribute value name.
+    /// @return attribute value reference or std::nullopt, if not set on any frame.
+    template<
+        typename Tag,
+        typename K,
+        typename H = traits::by_tag_t<Tag, Holders...>,
+        typename = std::void_t<typename H::key_type>>
+    static typename H::mapped_type get(Tag, const K &key);
+
+    /// Checks whether all attribute values are properly set on calling thread's stack.
+    /// @return true if all required attribute values are set on some frame.
+    static bool ready();
+
+    /// Build a collection of effective attribute values of calling thread's stack.
+    /// @return collection of innermost set attribute values.
+    static Collection<Holders...> collection();
+};
+
+
+
+template<typename... Holders>
+Scope<Holders...>::Scope()
+    : d_parent(t_top)
+{
+    t_top = this;
+}
+
+template<typename... Holders>
+template<typename... Attrs, typename>
+Scope<Holders...>::Scope(Attrs &&...attributes)
+    : Scope()
+{
+    (d_frame << ... << std::forward<Attrs>(attributes));
+}
+
+template<typename... Holders>
+Scope<Holders...>::~Scope()
+{
+    t_top = d_parent;
+}
+
+template<typename... Holders>
+template<typename Attr>
+Scope<Holders...> &Scope<Holders...>::operator<<(Attr &&attribute)
+{
+    d_frame << std::forward<Attr>(attribute);
+    return *this;
+}
+
+template<typename... Holders>
+const Collection<Holders...> &Scope<Holders...>::frame() const
+{
+    return d_frame;
+}
+
+template<typename... Holders>
+const Scope<Holders...> *Scope<Holders...>::top()
+{
+    return t_top;
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+const typename H::type &Scope<Holders...>::get(Tag)
+{
+    static_assert(!traits::is_multiple_v<H>, "Associative attributes are only accessible by name");
+
+    static const typename H::type empty;
+
+    for (const Scope *scope = t_top; scope; scope = scope->d_parent)
+    {
+        if (const typename H::type &value = *scope->d_frame.template holder<H>())
+        {
+            return value;
+        }
+    }
+
+    return empty;
+}
+
+template<typename... Holders>
+template<typename Tag, typename K, typename H, typename>
+typename H::mapped_type Scope<Holders...>::get(Tag, const K &key)
+{
+    for (const Scope *scope = t_top; scope; scope = scope->d_parent)
+    {
+        if (typename H::mapped_type value = scope->d_frame.template holder<H>()(key))
+        {
+            return value;
+        }
+    }
+
+    return std::nullopt;
+}
+
+template<typename... Holders>
+bool Scope<Holders...>::ready()
+{
+    auto is_ready = [](auto tag) {
+        using H = traits::by_tag_t<decltype(tag), Holders...>;
+
+        if constexpr (traits::is_required_v<H>)
+        {
+            return get(tag).has_value();
+        }
+        else
+        {
+            return true;
+        }
+    };
+
+    return (true && ... && is_ready(traits::tag_of_t<Holders> {}));
+}
+
+template<typename... Holders>
+Collection<Holders...> Scope<Holders...>::collection()
+{
+    Collection<Holders...> effective;
+
+    // Inner frames are visited first, so their values are kept
+    for (const Scope *scope = t_top; scope; scope = scope->d_parent)
+    {
+        effective.merge(scope->d_frame, KeepLeft {});
+    }
+
+    return effective;
+}
+
+
+} // namespace porter::attr
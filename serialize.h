@@ -0,0 +1,869 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "key.h"
+#include "lazy.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+namespace porter::attr {
+
+
+/// Defines binary encoding of an attribute value type.
+/// Specializations provide:
+/// - view_type, type the value is read as from an encoded buffer;
+/// - encode(out, value), that appends encoded value to a buffer;
+/// - valid(payload), that checks whether an encoded value is well-formed;
+/// - decode(payload), that reads a well-formed encoded value.
+/// Encoded value size is stored by the container, so encoded values carry no length.
+/// @tparam V attribute value type.
+template<typename V, typename = void> struct Codec;
+
+/// Defines binary encoding of arithmetic and enumeration values: fixed-width little-endian.
+template<typename V>
+struct Codec<V, std::enable_if_t<std::is_arithmetic_v<V> || std::is_enum_v<V>>>
+{
+    /// Defines decoded value type.
+    using view_type = V;
+
+    /// Append encoded value to a buffer.
+    static void encode(std::string &out, V value);
+
+    /// Check whether an encoded value is well-formed.
+    static bool valid(std::string_view payload);
+
+    /// Read an encoded value.
+    static V decode(std::string_view payload);
+};
+
+/// Defines binary encoding of string values: raw characters.
+/// Strings are read as views into the encoded buffer.
+template<typename V>
+struct Codec<V, std::enable_if_t<std::is_convertible_v<const V &, std::string_view> && !std::is_arithmetic_v<V>>>
+{
+    /// Defines decoded value type.
+    using view_type = std::string_view;
+
+    /// Append encoded value to a buffer.
+    static void encode(std::string &out, std::string_view value);
+
+    /// Check whether an encoded value is well-formed.
+    static bool valid(std::string_view payload);
+
+    /// Read an encoded value.
+    static std::string_view decode(std::string_view payload);
+};
+
+/// Defines binary encoding of deferred values: encoding of the computed value, which is forced.
+template<typename V>
+struct Codec<Lazy<V>>
+{
+    /// Defines decoded value type.
+    using view_type = typename Codec<V>::view_type;
+
+    /// Append encoded value to a buffer.
+    static void encode(std::string &out, const Lazy<V> &value);
+
+    /// Check whether an encoded value is well-formed.
+    static bool valid(std::string_view payload);
+
+    /// Read an encoded value.
+    static view_type decode(std::string_view payload);
+};
+
+
+namespace traits {
+
+
+/// Helper alias for the type an attribute value is read as from an encoded buffer.
+template<typename V> using view_t = typename Codec<V>::view_type;
+
+
+} // namespace traits
+
+
+namespace wire {
+
+
+/// Defines encoded attribute id of a tag: truncated hash of the tag name.
+/// @tparam Tag attribute tag type.
+template<typename Tag> inline constexpr uint32_t tag_id = uint32_t(hash_name(Tag::value));
+
+/// Append a little-endian unsigned integer to a buffer.
+/// @tparam U unsigned integer type.
+/// @param out output buffer.
+/// @param value integer to append.
+template<typename U>
+void put(std::string &out, U value);
+
+/// Overwrite a little-endian unsigned integer previously appended to a buffer.
+/// @tparam U unsigned integer type.
+/// @param out output buffer.
+/// @param pos integer position in the buffer.
+/// @param value integer to write.
+template<typename U>
+void put(std::string &out, size_t pos, U value);
+
+/// Read a little-endian unsigned integer from the front of a buffer, advancing it.
+/// @tparam U unsigned integer type.
+/// @param in input buffer.
+/// @return integer or std::nullopt if the buffer is too short.
+template<typename U>
+std::optional<U> get(std::string_view &in);
+
+/// Read a length-prefixed block from the front of a buffer, advancing it.
+/// @param in input buffer.
+/// @return block or std::nullopt if the buffer is too short.
+std::optional<std::string_view> block(std::string_view &in);
+
+
+} // namespace wire
+
+
+/// Defines a read-only view of an encoded associative attribute (i.e. Multiple holder).
+/// Keys and string values point into the encoded buffer.
+/// @tparam V attribute value type.
+template<typename V>
+class MultipleView
+{
+public:
+    /// Defines decoded value type.
+    using mapped_type = traits::view_t<V>;
+
+    /// Defines decoded name/value pair type.
+    using value_type = std::pair<std::string_view, mapped_type>;
+
+    /// Defines forward iterator over decoded name/value pairs.
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, mapped_type>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = const value_type &;
+
+    private:
+        /// Stores rest of the encoded pairs.
+        std::string_view d_rest;
+
+        /// Stores number of the remaining pairs.
+        uint32_t d_remaining = 0;
+
+        /// Stores current pair.
+        value_type d_current {};
+
+    private:
+        /// Decode the current pair.
+        void load();
+
+    public:
+
+        /// Construct an end iterator.
+        iterator() = default;
+
+        /// Construct an iterator over encoded pairs.
+        /// @param pairs encoded pairs.
+        /// @param count number of encoded pairs.
+        iterator(std::string_view pairs, uint32_t count);
+
+        /// Get current pair.
+        reference operator*() const;
+
+        /// Get current pair.
+        pointer operator->() const;
+
+        /// Advance to the next pair.
+        iterator &operator++();
+
+        /// Advance to the next pair.
+        iterator operator++(int);
+
+        /// Compare iterators by remaining pairs.
+        friend bool operator==(const iterator &lhs, const iterator &rhs) { return lhs.d_remaining == rhs.d_remaining; }
+
+        /// Compare iterators by remaining pairs.
+        friend bool operator!=(const iterator &lhs, const iterator &rhs) { return !(lhs == rhs); }
+    };
+
+    /// Defines forward iterator over decoded name/value pairs.
+    using const_iterator = iterator;
+
+private:
+    /// Stores encoded pairs.
+    std::string_view d_pairs;
+
+    /// Stores number of the encoded pairs.
+    uint32_t d_size = 0;
+
+public:
+    /// Construct an empty view.
+    MultipleView() = default;
+
+    /// Construct a view over an encoded block. The block must be well-formed (see valid()).
+    /// @param payload encoded block.
+    explicit MultipleView(std::string_view payload);
+
+    /// Check whether an encoded block is well-formed.
+    /// @param payload encoded block.
+    /// @return true if the block can be viewed.
+    static bool valid(std::string_view payload);
+
+    /// Get number of name/value pairs.
+    size_t size() const;
+
+    /// Check whether there are no name/value pairs.
+    bool empty() const;
+
+    /// Get iterator to the first name/value pair.
+    iterator begin() const;
+
+    /// Get end iterator.
+    iterator end() const;
+
+    /// Look up a value by name.
+    /// @param key attribute value name.
+    /// @return decoded value or std::nullopt, if not found.
+    std::optional<mapped_type> operator()(std::string_view key) const;
+};
+
+
+/// Defines binary encoding of associative attributes: pair count, followed by
+/// length-prefixed names and length-prefixed encoded values.
+template<typename Tag, typename V, typename Storage>
+struct Codec<Multiple<Tag, V, Storage>>
+{
+    /// Defines decoded value type.
+    using view_type = MultipleView<V>;
+
+    /// Append encoded value storage to a buffer.
+    static void encode(std::string &out, const Multiple<Tag, V, Storage> &values);
+
+    /// Check whether encoded value storage is well-formed.
+    static bool valid(std::string_view payload);
+
+    /// Read encoded value storage.
+    static MultipleView<V> decode(std::string_view payload);
+};
+
+
+namespace traits {
+
+
+/// Template that defines the type a holder value is read as from an encoded buffer.
+/// Single holders are read as optional values.
+template<typename H> struct view_of { using type = std::optional<view_t<typename H::value_type>>; };
+
+/// Template that defines the type a holder value is read as from an encoded buffer.
+/// Associative holders are read as value storage views.
+template<typename Tag, typename V, typename Storage>
+struct view_of<Multiple<Tag, V, Storage>> { using type = MultipleView<V>; };
+
+/// Helper alias for the type a holder value is read as from an encoded buffer.
+template<typename H> using view_of_t = typename view_of<H>::type;
+
+
+} // namespace traits
+
+
+/// Encode a collection, appending it to a buffer.
+/// Layout (integers are little-endian):
+/// - u16 holder count N;
+/// - N u32 tag ids (see wire::tag_id), in holder declaration order;
+/// - presence bitmap of ceil(N / 8) bytes, bit i set if holder i has a value;
+/// - u32 length-prefixed encoded value of every present holder, in holder order.
+/// Empty associative attributes are encoded as absent.
+/// @tparam Holders attribute holder types of the collection.
+/// @param collection collection to encode.
+/// @param out output buffer.
+template<typename... Holders>
+void encode(const Collection<Holders...> &collection, std::string &out);
+
+/// Encode a collection.
+/// @tparam Holders attribute holder types of the collection.
+/// @param collection collection to encode.
+/// @return encoded collection.
+template<typename... Holders>
+std::string encode(const Collection<Holders...> &collection);
+
+
+/// Defines a read-only view of an encoded collection.
+/// The view does not own the buffer; string values and names point into it, so the buffer must outlive the view.
+/// Encoded holders are matched by tag id, so buffers encoded from different holder sets can be viewed:
+/// unknown attributes are skipped, missing ones read as absent.
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class CollectionView
+{
+    static_assert(traits::are_holders_valid_v<Holders...>, "One or more holder types are not valid");
+
+public:
+    /// Defines decoded value type for a holder.
+    /// Single holders are read as optional values, other holders as value storage views.
+    template<typename H>
+    using access_t = traits::view_of_t<H>;
+
+private:
+    /// Stores encoded values of holders, absent ones are empty.
+    std::array<std::optional<std::string_view>, sizeof...(Holders)> d_payloads;
+
+private:
+    /// Construct an empty view.
+    CollectionView() = default;
+
+    /// Check whether an encoded holder value is well-formed.
+    /// @tparam H attribute holder type.
+    /// @param payload encoded value.
+    template<typename H>
+    static bool valid(std::string_view payload);
+
+public:
+    /// Parse an encoded collection. Holder values are validated, but not decoded.
+    /// @param buffer encoded collection.
+    /// @return collection view or std::nullopt if the buffer is malformed.
+    static std::optional<CollectionView<Holders...>> parse(std::string_view buffer);
+
+    /// Checks whether all required attribute values are present.
+    /// @return true if all required attribute values are present.
+    operator bool() const;
+
+    /// Get attribute value or value storage view.
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @return attribute value (std::nullopt if absent) or value storage view.
+    template<typename Tag, typename H = traits::by_tag_t<Tag, Holders...>>
+    access_t<H> operator()(Tag) const;
+
+    /// Get named attribute value for associative attributes (i.e. Multiple holder).
+    /// @tparam Tag attribute tag type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param key attribute value name.
+    /// @return attribute value or std::nullopt, if not found.
+    template<
+        typename Tag,
+        typename H = traits::by_tag_t<Tag, Holders...>,
+        typename = std::void_t<typename H::key_type>>
+    std::optional<traits::view_t<typename H::value_type>> operator()(Tag, std::string_view key) const;
+
+    /// Decode into a regular collection.
+    /// String values of non-owning types (e.g. std::string_view) keep pointing into the buffer.
+    /// @return decoded collection.
+    Collection<Holders...> collection() const;
+};
+
+
+
+template<typename V>
+void Codec<V, std::enable_if_t<std::is_arithmetic_v<V> || std::is_enum_v<V>>>::encode(std::string &out, V value)
+{
+    if constexpr (std::is_enum_v<V>)
+    {
+        Codec<std::underlying_type_t<V>>::encode(out, static_cast<std::underlying_type_t<V>>(value));
+    }
+    else if constexpr (std::is_same_v<V, bool>)
+    {
+        out.push_back(value ? 1 : 0);
+    }
+    else
+    {
+        using U = std::conditional_t<sizeof(V) == 1, uint8_t,
+            std::conditional_t<sizeof(V) == 2, uint16_t,
+            std::conditional_t<sizeof(V) == 4, uint32_t, uint64_t>>>;
+
+        static_assert(sizeof(U) == sizeof(V), "Unsupported arithmetic value size");
+
+        U bits;
+        std::memcpy(&bits, &value, sizeof(V));
+        wire::put(out, bits);
+    }
+}
+
+template<typename V>
+bool Codec<V, std::enable_if_t<std::is_arithmetic_v<V> || std::is_enum_v<V>>>::valid(std::string_view payload)
+{
+    return payload.size() == sizeof(V);
+}
+
+template<typename V>
+V Codec<V, std::enable_if_t<std::is_arithmetic_v<V> || std::is_enum_v<V>>>::decode(std::string_view payload)
+{
+    if constexpr (std::is_enum_v<V>)
+    {
+        return static_cast<V>(Codec<std::underlying_type_t<V>>::decode(payload));
+    }
+    else if constexpr (std::is_same_v<V, bool>)
+    {
+        return payload[0] != 0;
+    }
+    else
+    {
+        using U = std::conditional_t<sizeof(V) == 1, uint8_t,
+            std::conditional_t<sizeof(V) == 2, uint16_t,
+            std::conditional_t<sizeof(V) == 4, uint32_t, uint64_t>>>;
+
+        U bits = *wire::get<U>(payload);
+
+        V value;
+        std::memcpy(&value, &bits, sizeof(V));
+        return value;
+    }
+}
+
+
+template<typename V>
+void Codec<V, std::enable_if_t<std::is_convertible_v<const V &, std::string_view> && !std::is_arithmetic_v<V>>>::encode(
+    std::string &out, std::string_view value)
+{
+    out.append(value);
+}
+
+template<typename V>
+bool Codec<V, std::enable_if_t<std::is_convertible_v<const V &, std::string_view> && !std::is_arithmetic_v<V>>>::valid(
+    std::string_view)
+{
+    return true;
+}
+
+template<typename V>
+std::string_view Codec<V, std::enable_if_t<std::is_convertible_v<const V &, std::string_view> && !std::is_arithmetic_v<V>>>::decode(
+    std::string_view payload)
+{
+    return payload;
+}
+
+
+template<typename V>
+void Codec<Lazy<V>>::encode(std::string &out, const Lazy<V> &value)
+{
+    Codec<V>::encode(out, value.get());
+}
+
+template<typename V>
+bool Codec<Lazy<V>>::valid(std::string_view payload)
+{
+    return Codec<V>::valid(payload);
+}
+
+template<typename V>
+typename Codec<Lazy<V>>::view_type Codec<Lazy<V>>::decode(std::string_view payload)
+{
+    return Codec<V>::decode(payload);
+}
+
+
+template<typename U>
+void wire::put(std::string &out, U value)
+{
+    static_assert(std::is_unsigned_v<U>, "Only unsigned integers can be put on the wire");
+
+    for (size_t idx = 0; idx < sizeof(U); ++idx)
+    {
+        out.push_back(char(uint8_t(value >> (8 * idx))));
+    }
+}
+
+template<typename U>
+void wire::put(std::string &out, size_t pos, U value)
+{
+    static_assert(std::is_unsigned_v<U>, "Only unsigned integers can be put on the wire");
+
+    for (size_t idx = 0; idx < sizeof(U); ++idx)
+    {
+        out[pos + idx] = char(uint8_t(value >> (8 * idx)));
+    }
+}
+
+template<typename U>
+std::optional<U> wire::get(std::string_view &in)
+{
+    static_assert(std::is_unsigned_v<U>, "Only unsigned integers can be read from the wire");
+
+    if (in.size() < sizeof(U))
+    {
+        return std::nullopt;
+    }
+
+    U value = 0;
+    for (size_t idx = 0; idx < sizeof(U); ++idx)
+    {
+        value |= U(uint8_t(in[idx])) << (8 * idx);
+    }
+
+    in.remove_prefix(sizeof(U));
+    return value;
+}
+
+inline std::optional<std::string_view> wire::block(std::string_view &in)
+{
+    std::optional<uint32_t> size = get<uint32_t>(in);
+    if (!size || in.size() < *size)
+    {
+        return std::nullopt;
+    }
+
+    std::string_view block = in.substr(0, *size);
+    in.remove_prefix(*size);
+
+    return block;
+}
+
+
+template<typename V>
+MultipleView<V>::iterator::iterator(std::string_view pairs, uint32_t count)
+    : d_rest(pairs)
+    , d_remaining(count)
+{
+    load();
+}
+
+template<typename V>
+void MultipleView<V>::iterator::load()
+{
+    if (d_remaining)
+    {
+        std::string_view key = *wire::block(d_rest);
+        std::string_view value = *wire::block(d_rest);
+        d_current = {key, Codec<V>::decode(value)};
+    }
+}
+
+template<typename V>
+typename MultipleView<V>::iterator::reference MultipleView<V>::iterator::operator*() const
+{
+    return d_current;
+}
+
+template<typename V>
+typename MultipleView<V>::iterator::pointer MultipleView<V>::iterator::operator->() const
+{
+    return &d_current;
+}
+
+template<typename V>
+typename MultipleView<V>::iterator &MultipleView<V>::iterator::operator++()
+{
+    --d_remaining;
+    load();
+    return *this;
+}
+
+template<typename V>
+typename MultipleView<V>::iterator MultipleView<V>::iterator::operator++(int)
+{
+    iterator current = *this;
+    ++*this;
+    return current;
+}
+
+
+template<typename V>
+MultipleView<V>::MultipleView(std::string_view payload)
+    : d_size(*wire::get<uint32_t>(payload))
+{
+    d_pairs = payload;
+}
+
+template<typename V>
+bool MultipleView<V>::valid(std::string_view payload)
+{
+    std::optional<uint32_t> size = wire::get<uint32_t>(payload);
+    if (!size)
+    {
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < *size; ++idx)
+    {
+        std::optional<std::string_view> key = wire::block(payload);
+        std::optional<std::string_view> value = key ? wire::block(payload) : std::nullopt;
+
+        if (!value || !Codec<V>::valid(*value))
+        {
+            return false;
+        }
+    }
+
+    return payload.empty();
+}
+
+template<typename V>
+size_t MultipleView<V>::size() const
+{
+    return d_size;
+}
+
+template<typename V>
+bool MultipleView<V>::empty() const
+{
+    return d_size == 0;
+}
+
+template<typename V>
+typename MultipleView<V>::iterator MultipleView<V>::begin() const
+{
+    return iterator {d_pairs, d_size};
+}
+
+template<typename V>
+typename MultipleView<V>::iterator MultipleView<V>::end() const
+{
+    return iterator {};
+}
+
+template<typename V>
+std::optional<typename MultipleView<V>::mapped_type> MultipleView<V>::operator()(std::string_view key) const
+{
+    for (const auto &[name, value] : *this)
+    {
+        if (name == key)
+        {
+            return value;
+        }
+    }
+
+    return std::nullopt;
+}
+
+
+template<typename Tag, typename V, typename Storage>
+void Codec<Multiple<Tag, V, Storage>>::encode(std::string &out, const Multiple<Tag, V, Storage> &values)
+{
+    wire::put(out, uint32_t((*values).size()));
+
+    for (const auto &[key, value] : *values)
+    {
+        std::string_view name = key;
+        wire::put(out, uint32_t(name.size()));
+        out.append(name);
+
+        const size_t prefix = out.size();
+        wire::put(out, uint32_t(0));
+        Codec<V>::encode(out, value);
+        wire::put(out, prefix, uint32_t(out.size() - prefix - sizeof(uint32_t)));
+    }
+}
+
+template<typename Tag, typename V, typename Storage>
+bool Codec<Multiple<Tag, V, Storage>>::valid(std::string_view payload)
+{
+    return MultipleView<V>::valid(payload);
+}
+
+template<typename Tag, typename V, typename Storage>
+MultipleView<V> Codec<Multiple<Tag, V, Storage>>::decode(std::string_view payload)
+{
+    return MultipleView<V> {payload};
+}
+
+
+template<typename... Holders>
+void encode(const Collection<Holders...> &collection, std::string &out)
+{
+    static_assert(sizeof...(Holders) <= std::numeric_limits<uint16_t>::max(), "Too many holders to encode");
+
+    constexpr size_t N = sizeof...(Holders);
+
+    const bool present[] = {
+        [&] {
+            if constexpr (traits::is_multiple_v<Holders>)
+            {
+                return !(*collection.template holder<Holders>()).empty();
+            }
+            else
+            {
+                return (*collection.template holder<Holders>()).has_value();
+            }
+        }()...,
+        false};
+
+    wire::put(out, uint16_t(N));
+    (wire::put(out, wire::tag_id<traits::tag_of_t<Holders>>), ...);
+
+    for (size_t byte = 0; byte < (N + 7) / 8; ++byte)
+    {
+        uint8_t bits = 0;
+        for (size_t idx = byte * 8; idx < N && idx < byte * 8 + 8; ++idx)
+        {
+            bits |= uint8_t(present[idx] << (idx % 8));
+        }
+        wire::put(out, bits);
+    }
+
+    size_t idx = 0;
+    auto put = [&](const auto &holder) {
+        using H = std::decay_t<decltype(holder)>;
+
+        if (present[idx++])
+        {
+            const size_t prefix = out.size();
+            wire::put(out, uint32_t(0));
+
+            if constexpr (traits::is_multiple_v<H>)
+            {
+                Codec<H>::encode(out, holder);
+            }
+            else
+            {
+                Codec<typename H::value_type>::encode(out, **holder);
+            }
+
+            wire::put(out, prefix, uint32_t(out.size() - prefix - sizeof(uint32_t)));
+        }
+    };
+    (put(collection.template holder<Holders>()), ...);
+}
+
+template<typename... Holders>
+std::string encode(const Collection<Holders...> &collection)
+{
+    std::string out;
+    encode(collection, out);
+    return out;
+}
+
+
+template<typename... Holders>
+template<typename H>
+bool CollectionView<Holders...>::valid(std::string_view payload)
+{
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        return Codec<H>::valid(payload);
+    }
+    else
+    {
+        return Codec<typename H::value_type>::valid(payload);
+    }
+}
+
+template<typename... Holders>
+std::optional<CollectionView<Holders...>> CollectionView<Holders...>::parse(std::string_view buffer)
+{
+    constexpr uint32_t ids[] = {wire::tag_id<traits::tag_of_t<Holders>>..., 0};
+    constexpr bool (*validators[])(std::string_view) = {&valid<Holders>..., nullptr};
+
+    std::optional<uint16_t> count = wire::get<uint16_t>(buffer);
+    if (!count)
+    {
+        return std::nullopt;
+    }
+
+    std::string_view encoded = buffer.substr(0, std::min(buffer.size(), size_t(*count) * sizeof(uint32_t)));
+    std::string_view bitmap = buffer.substr(encoded.size(), std::min(buffer.size() - encoded.size(), size_t(*count + 7) / 8));
+    if (encoded.size() != size_t(*count) * sizeof(uint32_t) || bitmap.size() != size_t(*count + 7) / 8)
+    {
+        return std::nullopt;
+    }
+
+    buffer.remove_prefix(encoded.size() + bitmap.size());
+
+    CollectionView<Holders...> view;
+    for (uint16_t entry = 0; entry < *count; ++entry)
+    {
+        const uint32_t id = *wire::get<uint32_t>(encoded);
+        if (!(uint8_t(bitmap[entry / 8]) & (1u << (entry % 8))))
+        {
+            continue;
+        }
+
+        std::optional<std::string_view> payload = wire::block(buffer);
+        if (!payload)
+        {
+            return std::nullopt;
+        }
+
+        for (size_t idx = 0; idx < sizeof...(Holders); ++idx)
+        {
+            if (ids[idx] == id && !view.d_payloads[idx])
+            {
+                if (!validators[idx](*payload))
+                {
+                    return std::nullopt;
+                }
+
+                view.d_payloads[idx] = payload;
+                break;
+            }
+        }
+    }
+
+    if (!buffer.empty())
+    {
+        return std::nullopt;
+    }
+
+    return view;
+}
+
+template<typename... Holders>
+CollectionView<Holders...>::operator bool() const
+{
+    return (true && ... && (!traits::is_required_v<Holders> || d_payloads[traits::index_of_v<Holders, Holders...>]));
+}
+
+template<typename... Holders>
+template<typename Tag, typename H>
+typename CollectionView<Holders...>::template access_t<H> CollectionView<Holders...>::operator()(Tag) const
+{
+    const std::optional<std::string_view> &payload = d_payloads[traits::index_of_v<H, Holders...>];
+
+    if constexpr (traits::is_multiple_v<H>)
+    {
+        return payload ? Codec<H>::decode(*payload) : access_t<H> {};
+    }
+    else
+    {
+        return payload ? std::make_optional(Codec<typename H::value_type>::decode(*payload)) : std::nullopt;
+    }
+}
+
+template<typename... Holders>
+template<typename Tag, typename H, typename>
+std::optional<traits::view_t<typename H::value_type>> CollectionView<Holders...>::operator()(
+    Tag, std::string_view key) const
+{
+    return (*this)(Tag {})(key);
+}
+
+template<typename... Holders>
+Collection<Holders...> CollectionView<Holders...>::collection() const
+{
+    Collection<Holders...> decoded;
+
+    auto take = [&](auto tag) {
+        using Tag = decltype(tag);
+        using H = traits::by_tag_t<Tag, Holders...>;
+        using V = typename H::value_type;
+
+        if constexpr (traits::is_multiple_v<H>)
+        {
+            for (const auto &[key, value] : (*this)(tag))
+            {
+                decoded << KeyValue<Tag, std::pair<std::string_view, V>> {key, V(value)};
+            }
+        }
+        else if (auto value = (*this)(tag))
+        {
+            decoded << Value<Tag, V> {V(*value)};
+        }
+    };
+    (take(traits::tag_of_t<Holders> {}), ...);
+
+    return decoded;
+}
+
+
+} // namespace porter::attr
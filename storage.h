@@ -0,0 +1,800 @@
+#pragma once
+
+#include "key.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+
+namespace porter::attr {
+namespace traits {
+
+
+/// Template that checks whether a value type carries a stateful allocator.
+template<typename V, typename = void> struct is_allocator_aware : std::false_type {};
+
+/// Template that checks whether a value type carries a stateful allocator.
+/// Values with always-equal allocators (e.g. std::allocator) are not treated as allocator-aware.
+template<typename V>
+struct is_allocator_aware<V, std::void_t<typename V::allocator_type>>
+    : std::bool_constant<!std::allocator_traits<typename V::allocator_type>::is_always_equal::value> {};
+
+/// Helper variable for checking whether a value type carries a stateful allocator.
+template<typename V> inline constexpr bool is_allocator_aware_v = is_allocator_aware<V>::value;
+
+
+/// Template that checks whether a storage policy can translate an attribute name type into its key.
+template<typename Storage, typename K, typename = void> struct is_key_of : std::false_type {};
+
+/// Template that checks whether a storage policy can translate an attribute name type into its key.
+template<typename Storage, typename K>
+struct is_key_of<Storage, K, std::void_t<decltype(Storage::key(std::declval<K>()))>> : std::true_type {};
+
+/// Helper variable for checking whether a storage policy can translate an attribute name type into its key.
+template<typename Storage, typename K> inline constexpr bool is_key_of_v = is_key_of<Storage, K>::value;
+
+
+} // namespace traits
+
+
+/// Construct an object using uses-allocator construction convention.
+/// Allocator is ignored if the object type does not use it.
+/// @tparam T object type.
+/// @tparam Alloc allocator type.
+/// @tparam Args object constructor argument types.
+/// @param allocator allocator to pass to the object.
+/// @param args object constructor arguments.
+/// @return constructed object.
+template<typename T, typename Alloc, typename... Args>
+T make_using_allocator(const Alloc &allocator, Args &&...args);
+
+
+/// Defines an optional value that keeps its value on its own allocator.
+/// Regular std::optional copies allocator-aware values with their copy constructors,
+/// which moves polymorphic values out of their memory resource.
+/// @tparam V allocator-aware value type.
+template<typename V>
+class AllocatedOptional : public std::optional<V>
+{
+    static_assert(traits::is_allocator_aware_v<V>, "Value type is not allocator-aware");
+
+public:
+    /// Defines allocator type.
+    using allocator_type = typename V::allocator_type;
+
+private:
+    /// Stores allocator for constructing values.
+    allocator_type d_allocator;
+
+public:
+    /// Default ctor.
+    AllocatedOptional() = default;
+
+    /// Construct an empty instance with provided allocator.
+    /// @param allocator allocator for future values.
+    explicit AllocatedOptional(const allocator_type &allocator);
+
+    /// Copy ctor, selects allocator as the value's copy ctor does.
+    AllocatedOptional(const AllocatedOptional &other);
+
+    /// Copy ctor with provided allocator.
+    AllocatedOptional(const AllocatedOptional &other, const allocator_type &allocator);
+
+    /// Default move ctor.
+    AllocatedOptional(AllocatedOptional &&) = default;
+
+    /// Move ctor with provided allocator.
+    AllocatedOptional(AllocatedOptional &&other, const allocator_type &allocator);
+
+    /// Copy assignment, keeps current allocator.
+    AllocatedOptional &operator=(const AllocatedOptional &other);
+
+    /// Move assignment, keeps current allocator.
+    AllocatedOptional &operator=(AllocatedOptional &&other);
+
+    /// Copy-assign from optional value, keeps current allocator.
+    AllocatedOptional &operator=(const std::optional<V> &other);
+
+    /// Move-assign from optional value, keeps current allocator.
+    AllocatedOptional &operator=(std::optional<V> &&other);
+
+    /// Get allocator.
+    allocator_type get_allocator() const;
+};
+
+
+namespace traits {
+
+
+/// Helper alias for the optional storage of an attribute value type.
+template<typename V> using optional_t = std::conditional_t<is_allocator_aware_v<V>, AllocatedOptional<V>, std::optional<V>>;
+
+
+} // namespace traits
+
+
+/// Defines an associative container that keeps up to N entries inline.
+/// Entries are stored in insertion order and looked up linearly;
+/// once inline capacity is exhausted, all entries are moved to a heap buffer.
+/// @tparam K entry key type.
+/// @tparam V entry value type.
+/// @tparam N inline capacity.
+/// @tparam Alloc allocator type for heap buffer and entries.
+template<typename K, typename V, size_t N, typename Alloc = std::allocator<std::pair<K, V>>>
+class FlatMap : private Alloc
+{
+    static_assert(N > 0, "Inline capacity must be positive");
+
+public:
+    /// Defines entry key type.
+    using key_type = K;
+
+    /// Defines entry value type.
+    using mapped_type = V;
+
+    /// Defines entry type.
+    using value_type = std::pair<K, V>;
+
+    /// Defines size type.
+    using size_type = size_t;
+
+    /// Defines mutable iterator type.
+    using iterator = value_type *;
+
+    /// Defines const iterator type.
+    using const_iterator = const value_type *;
+
+    /// Defines allocator type.
+    using allocator_type = Alloc;
+
+private:
+    /// Defines allocator traits.
+    using alloc_traits = std::allocator_traits<Alloc>;
+
+    /// Stores inline entries.
+    alignas(value_type) unsigned char d_inline[N * sizeof(value_type)];
+
+    /// Stores heap buffer, if inline capacity was exceeded.
+    value_type *d_heap = nullptr;
+
+    /// Stores number of entries.
+    size_type d_size = 0;
+
+    /// Stores current capacity.
+    size_type d_capacity = N;
+
+private:
+    /// Get entry storage.
+    /// @return pointer to the first entry.
+    value_type *data();
+
+    /// Get entry storage.
+    /// @return pointer to the first entry.
+    const value_type *data() const;
+
+    /// Move entries to a bigger heap buffer.
+    /// Entries are kept if a transfer throws: values with throwing move constructors are copied.
+    /// @param capacity new capacity.
+    void grow(size_type capacity);
+
+    /// Get allocator.
+    allocator_type &allocator();
+
+    /// Take over entries of another container, leaving it empty.
+    /// Heap buffer is taken over only if allocators are equal.
+    /// @param other source container.
+    void steal(FlatMap &&other);
+
+    /// Destroy all entries and release heap buffer.
+    void release();
+
+public:
+    /// Default ctor.
+    FlatMap() = default;
+
+    /// Construct an empty container with provided allocator.
+    /// @param allocator allocator for heap buffer and entries.
+    explicit FlatMap(const allocator_type &allocator);
+
+    /// Copy ctor.
+    FlatMap(const FlatMap &other);
+
+    /// Copy ctor with provided allocator.
+    FlatMap(const FlatMap &other, const allocator_type &allocator);
+
+    /// Move ctor.
+    FlatMap(FlatMap &&other) noexcept;
+
+    /// Move ctor with provided allocator.
+    FlatMap(FlatMap &&other, const allocator_type &allocator);
+
+    /// Copy assignment.
+    FlatMap &operator=(const FlatMap &other);
+
+    /// Move assignment.
+    FlatMap &operator=(FlatMap &&other);
+
+    /// Destroy entries.
+    ~FlatMap();
+
+    /// Get allocator.
+    allocator_type get_allocator() const;
+
+    /// Get iterator to the first entry.
+    iterator begin();
+
+    /// Get iterator past the last entry.
+    iterator end();
+
+    /// Get iterator to the first entry.
+    const_iterator begin() const;
+
+    /// Get iterator past the last entry.
+    const_iterator end() const;
+
+    /// Get number of entries.
+    size_type size() const;
+
+    /// Checks whether there are no entries.
+    bool empty() const;
+
+    /// Get number of entries that can be stored without reallocation.
+    size_type capacity() const;
+
+    /// Reserve storage for entries.
+    /// @param capacity number of entries.
+    void reserve(size_type capacity);
+
+    /// Remove an entry, keeping insertion order of the others.
+    /// @param pos iterator to the entry.
+    /// @return iterator to the entry following the removed one.
+    iterator erase(const_iterator pos);
+
+    /// Find entry by key.
+    /// @param key entry key.
+    /// @return iterator to found entry or end().
+    iterator find(const key_type &key);
+
+    /// Find entry by key.
+    /// @param key entry key.
+    /// @return iterator to found entry or end().
+    const_iterator find(const key_type &key) const;
+
+    /// Get value by key, inserting default constructed value if not found.
+    /// @param key entry key.
+    /// @return reference to entry value.
+    mapped_type &operator[](const key_type &key);
+
+    /// Get value by key, inserting default constructed value if not found.
+    /// @param key entry key.
+    /// @return reference to entry value.
+    mapped_type &operator[](key_type &&key);
+};
+
+
+namespace storage {
+
+
+/// Base for storage policies that key attribute values on their names.
+/// Storage policies define storage key type, value storage type and key translation for insertions and lookups.
+struct Named
+{
+    /// Defines storage key type.
+    using key_type = std::string_view;
+
+    /// Translate attribute name into storage key.
+    static key_type key(std::string_view key) { return key; }
+
+    /// Look up a value by attribute name.
+    template<typename C>
+    static typename C::const_iterator find(const C &values, std::string_view key) { return values.find(key); }
+};
+
+/// Storage policy that keeps attribute values in a hash map.
+/// @tparam Alloc allocator template.
+template<template<typename> typename Alloc>
+struct BasicHashed : Named
+{
+    /// Defines value storage type.
+    template<typename K, typename V>
+    using type = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, Alloc<std::pair<const K, V>>>;
+};
+
+/// Storage policy that keeps attribute values in a hash map keyed on names with cached hashes.
+/// Lookups and updates by Key (e.g. "LID"_akey) skip hashing, stored keys are exposed as Key.
+/// @tparam Alloc allocator template.
+template<template<typename> typename Alloc>
+struct BasicKeyed
+{
+    /// Defines storage key type.
+    using key_type = Key;
+
+    /// Defines value storage type.
+    template<typename K, typename V>
+    using type = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, Alloc<std::pair<const K, V>>>;
+
+    /// Translate attribute name into storage key, hashing it.
+    static key_type key(std::string_view key) { return Key {key}; }
+
+    /// Translate attribute name into storage key.
+    static key_type key(const Key &key) { return key; }
+
+    /// Look up a value by attribute name, hashing it.
+    template<typename C>
+    static typename C::const_iterator find(const C &values, std::string_view key) { return values.find(Key {key}); }
+
+    /// Look up a value by attribute name with precomputed hash.
+    template<typename C>
+    static typename C::const_iterator find(const C &values, const Key &key) { return values.find(key); }
+};
+
+/// Storage policy that keeps up to N attribute values inline, spilling to the heap past N.
+/// @tparam N inline capacity.
+/// @tparam Alloc allocator template.
+template<size_t N, template<typename> typename Alloc>
+struct BasicFlat : Named
+{
+    /// Defines value storage type.
+    template<typename K, typename V> using type = FlatMap<K, V, N, Alloc<std::pair<K, V>>>;
+};
+
+
+/// Storage policy that keeps attribute values in a hash map.
+using Hashed = BasicHashed<std::allocator>;
+
+/// Storage policy that keeps attribute values in a hash map keyed on names with cached hashes.
+using Keyed = BasicKeyed<std::allocator>;
+
+/// Storage policy that keeps up to N attribute values inline, spilling to the heap past N.
+template<size_t N> using Flat = BasicFlat<N, std::allocator>;
+
+
+namespace pmr {
+
+
+/// Storage policy that keeps attribute values in a hash map on a memory resource.
+using Hashed = BasicHashed<std::pmr::polymorphic_allocator>;
+
+/// Storage policy that keeps attribute values in a hash map keyed on names with cached hashes, on a memory resource.
+using Keyed = BasicKeyed<std::pmr::polymorphic_allocator>;
+
+/// Storage policy that keeps up to N attribute values inline, spilling to a memory resource past N.
+template<size_t N> using Flat = BasicFlat<N, std::pmr::polymorphic_allocator>;
+
+
+} // namespace pmr
+} // namespace storage
+
+
+
+template<typename T, typename Alloc, typename... Args>
+T make_using_allocator(const Alloc &allocator, Args &&...args)
+{
+    if constexpr (!std::uses_allocator_v<T, Alloc>)
+    {
+        return T(std::forward<Args>(args)...);
+    }
+    else if constexpr (std::is_constructible_v<T, std::allocator_arg_t, const Alloc &, Args...>)
+    {
+        return T(std::allocator_arg, allocator, std::forward<Args>(args)...);
+    }
+    else
+    {
+        return T(std::forward<Args>(args)..., allocator);
+    }
+}
+
+
+template<typename V>
+AllocatedOptional<V>::AllocatedOptional(const allocator_type &allocator)
+    : d_allocator(allocator)
+{
+}
+
+template<typename V>
+AllocatedOptional<V>::AllocatedOptional(const AllocatedOptional &other)
+    : AllocatedOptional(
+        other,
+        std::allocator_traits<allocator_type>::select_on_container_copy_construction(other.d_allocator))
+{
+}
+
+template<typename V>
+AllocatedOptional<V>::AllocatedOptional(const AllocatedOptional &other, const allocator_type &allocator)
+    : d_allocator(allocator)
+{
+    *this = static_cast<const std::optional<V> &>(other);
+}
+
+template<typename V>
+AllocatedOptional<V>::AllocatedOptional(AllocatedOptional &&other, const allocator_type &allocator)
+    : d_allocator(allocator)
+{
+    *this = static_cast<std::optional<V> &&>(other);
+}
+
+template<typename V>
+AllocatedOptional<V> &AllocatedOptional<V>::operator=(const AllocatedOptional &other)
+{
+    return *this = static_cast<const std::optional<V> &>(other);
+}
+
+template<typename V>
+AllocatedOptional<V> &AllocatedOptional<V>::operator=(AllocatedOptional &&other)
+{
+    return *this = static_cast<std::optional<V> &&>(other);
+}
+
+template<typename V>
+AllocatedOptional<V> &AllocatedOptional<V>::operator=(const std::optional<V> &other)
+{
+    if (!other)
+    {
+        this->reset();
+    }
+    else if (this->has_value())
+    {
+        **this = *other;
+    }
+    else
+    {
+        this->emplace(make_using_allocator<V>(d_allocator, *other));
+    }
+
+    return *this;
+}
+
+template<typename V>
+AllocatedOptional<V> &AllocatedOptional<V>::operator=(std::optional<V> &&other)
+{
+    if (!other)
+    {
+        this->reset();
+    }
+    else if (this->has_value())
+    {
+        **this = std::move(*other);
+    }
+    else
+    {
+        this->emplace(make_using_allocator<V>(d_allocator, std::move(*other)));
+    }
+
+    return *this;
+}
+
+template<typename V>
+typename AllocatedOptional<V>::allocator_type AllocatedOptional<V>::get_allocator() const
+{
+    return d_allocator;
+}
+
+
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::value_type *FlatMap<K, V, N, Alloc>::data()
+{
+    return d_heap ? d_heap : std::launder(reinterpret_cast<value_type *>(d_inline));
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+const typename FlatMap<K, V, N, Alloc>::value_type *FlatMap<K, V, N, Alloc>::data() const
+{
+    return d_heap ? d_heap : std::launder(reinterpret_cast<const value_type *>(d_inline));
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::allocator_type &FlatMap<K, V, N, Alloc>::allocator()
+{
+    return *this;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+void FlatMap<K, V, N, Alloc>::grow(size_type capacity)
+{
+    // Releases the new buffer if an entry fails to transfer, leaving current entries intact
+    struct Guard
+    {
+        FlatMap &map;
+        value_type *buffer;
+        size_type capacity;
+        size_type size = 0;
+
+        ~Guard()
+        {
+            if (!buffer)
+            {
+                return;
+            }
+
+            for (size_type idx = 0; idx < size; ++idx)
+            {
+                alloc_traits::destroy(map.allocator(), buffer + idx);
+            }
+            alloc_traits::deallocate(map.allocator(), buffer, capacity);
+        }
+    };
+
+    Guard guard {*this, alloc_traits::allocate(allocator(), capacity), capacity};
+
+    // Entries with throwing moves are copied, so the source stays valid until all of them are transferred
+    value_type *current = data();
+    for (; guard.size < d_size; ++guard.size)
+    {
+        alloc_traits::construct(allocator(), guard.buffer + guard.size, std::move_if_noexcept(current[guard.size]));
+    }
+
+    value_type *buffer = std::exchange(guard.buffer, nullptr);
+    for (size_type idx = 0; idx < d_size; ++idx)
+    {
+        alloc_traits::destroy(allocator(), current + idx);
+    }
+
+    if (d_heap)
+    {
+        alloc_traits::deallocate(allocator(), d_heap, d_capacity);
+    }
+
+    d_heap = buffer;
+    d_capacity = capacity;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+void FlatMap<K, V, N, Alloc>::release()
+{
+    value_type *current = data();
+    for (size_type idx = 0; idx < d_size; ++idx)
+    {
+        alloc_traits::destroy(allocator(), current + idx);
+    }
+
+    if (d_heap)
+    {
+        alloc_traits::deallocate(allocator(), d_heap, d_capacity);
+    }
+
+    d_heap = nullptr;
+    d_size = 0;
+    d_capacity = N;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+void FlatMap<K, V, N, Alloc>::steal(FlatMap &&other)
+{
+    if (other.d_heap && allocator() == other.allocator())
+    {
+        std::swap(d_heap, other.d_heap);
+        std::swap(d_size, other.d_size);
+        std::swap(d_capacity, other.d_capacity);
+        return;
+    }
+
+    if (other.d_size > d_capacity)
+    {
+        grow(other.d_size);
+    }
+
+    for (value_type &entry : other)
+    {
+        alloc_traits::construct(allocator(), data() + d_size, std::move(entry));
+        ++d_size;
+    }
+
+    other.release();
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+FlatMap<K, V, N, Alloc>::FlatMap(const allocator_type &allocator)
+    : Alloc(allocator)
+{
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+FlatMap<K, V, N, Alloc>::FlatMap(const FlatMap &other)
+    : FlatMap(other, alloc_traits::select_on_container_copy_construction(other.get_allocator()))
+{
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+FlatMap<K, V, N, Alloc>::FlatMap(const FlatMap &other, const allocator_type &allocator)
+    : Alloc(allocator)
+{
+    if (other.d_size > N)
+    {
+        grow(other.d_size);
+    }
+
+    for (const value_type &entry : other)
+    {
+        alloc_traits::construct(this->allocator(), data() + d_size, entry);
+        ++d_size;
+    }
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+FlatMap<K, V, N, Alloc>::FlatMap(FlatMap &&other) noexcept
+    : Alloc(std::move(other.allocator()))
+{
+    steal(std::move(other));
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+FlatMap<K, V, N, Alloc>::FlatMap(FlatMap &&other, const allocator_type &allocator)
+    : Alloc(allocator)
+{
+    steal(std::move(other));
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+FlatMap<K, V, N, Alloc> &FlatMap<K, V, N, Alloc>::operator=(const FlatMap &other)
+{
+    if (this != &other)
+    {
+        if constexpr (alloc_traits::propagate_on_container_copy_assignment::value)
+        {
+            release();
+            allocator() = other.allocator();
+        }
+
+        FlatMap copy {other, allocator()};
+        *this = std::move(copy);
+    }
+
+    return *this;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+FlatMap<K, V, N, Alloc> &FlatMap<K, V, N, Alloc>::operator=(FlatMap &&other)
+{
+    if (this != &other)
+    {
+        release();
+
+        if constexpr (alloc_traits::propagate_on_container_move_assignment::value)
+        {
+            allocator() = std::move(other.allocator());
+        }
+
+        steal(std::move(other));
+    }
+
+    return *this;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+FlatMap<K, V, N, Alloc>::~FlatMap()
+{
+    release();
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::allocator_type FlatMap<K, V, N, Alloc>::get_allocator() const
+{
+    return *this;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::iterator FlatMap<K, V, N, Alloc>::begin()
+{
+    return data();
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::iterator FlatMap<K, V, N, Alloc>::end()
+{
+    return data() + d_size;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::const_iterator FlatMap<K, V, N, Alloc>::begin() const
+{
+    return data();
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::const_iterator FlatMap<K, V, N, Alloc>::end() const
+{
+    return data() + d_size;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::size_type FlatMap<K, V, N, Alloc>::size() const
+{
+    return d_size;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+bool FlatMap<K, V, N, Alloc>::empty() const
+{
+    return d_size == 0;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::size_type FlatMap<K, V, N, Alloc>::capacity() const
+{
+    return d_capacity;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+void FlatMap<K, V, N, Alloc>::reserve(size_type capacity)
+{
+    if (capacity > d_capacity)
+    {
+        grow(capacity);
+    }
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::iterator FlatMap<K, V, N, Alloc>::erase(const_iterator pos)
+{
+    iterator it = begin() + (pos - begin());
+    std::move(it + 1, end(), it);
+
+    alloc_traits::destroy(allocator(), data() + d_size - 1);
+    --d_size;
+
+    return it;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::iterator FlatMap<K, V, N, Alloc>::find(const key_type &key)
+{
+    iterator it = begin();
+    while (it != end() && !(it->first == key))
+    {
+        ++it;
+    }
+
+    return it;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::const_iterator FlatMap<K, V, N, Alloc>::find(const key_type &key) const
+{
+    const_iterator it = begin();
+    while (it != end() && !(it->first == key))
+    {
+        ++it;
+    }
+
+    return it;
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::mapped_type &FlatMap<K, V, N, Alloc>::operator[](const key_type &key)
+{
+    return (*this)[key_type {key}];
+}
+
+template<typename K, typename V, size_t N, typename Alloc>
+typename FlatMap<K, V, N, Alloc>::mapped_type &FlatMap<K, V, N, Alloc>::operator[](key_type &&key)
+{
+    if (iterator it = find(key); it != end())
+    {
+        return it->second;
+    }
+
+    if (d_size == d_capacity)
+    {
+        grow(d_capacity * 2);
+    }
+
+    value_type *entry = data() + d_size;
+    alloc_traits::construct(
+        allocator(), entry, std::piecewise_construct, std::forward_as_tuple(std::move(key)), std::forward_as_tuple());
+    ++d_size;
+
+    return entry->second;
+}
+
+
+} // namespace porter::attr
@@ -0,0 +1,637 @@
+#pragma once
+
+#include "attribute.h"
+#include "holder.h"
+#include "collection.h"
+#include "serialize.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace porter::attr {
+
+
+/// Defines a memory-mapped segment file of a collection store.
+/// Layout (integers are little-endian):
+/// - u32 magic, u32 version;
+/// - u64 committed size, the end of the last complete record;
+/// - records, each a u32 length-prefixed encoded collection (see encode()).
+/// Space past the committed size is preallocated and not yet written.
+class Segment
+{
+    /// Stores file descriptor.
+    int d_fd = -1;
+
+    /// Stores mapped file contents.
+    char *d_data = nullptr;
+
+    /// Stores mapped size.
+    size_t d_size = 0;
+
+public:
+    /// Defines segment file magic ("PASG").
+    static constexpr uint32_t magic = 0x47534150;
+
+    /// Defines segment file layout version.
+    static constexpr uint32_t version = 1;
+
+    /// Defines header size, the offset of the first record.
+    static constexpr size_t header_size = 16;
+
+    /// Defines size preallocated for a new segment.
+    static constexpr size_t initial_size = 64 * 1024;
+
+private:
+    /// Construct an unmapped segment of an open file.
+    /// @param fd file descriptor.
+    explicit Segment(int fd);
+
+    /// Replace mapping by one of a given size.
+    /// @param size mapped size, not more than file size.
+    /// @param writable whether mapping is writable.
+    /// @return false on failure, in which case the current mapping is kept.
+    bool map(size_t size, bool writable);
+
+public:
+    /// Not copyable: owns the file descriptor and the mapping.
+    Segment(const Segment &) = delete;
+
+    /// Take over file descriptor and mapping of another segment.
+    Segment(Segment &&other) noexcept;
+
+    /// Not copyable: owns the file descriptor and the mapping.
+    Segment &operator=(const Segment &) = delete;
+
+    /// Take over file descriptor and mapping of another segment.
+    Segment &operator=(Segment &&other) noexcept;
+
+    /// Unmap and close the file.
+    ~Segment();
+
+    /// Open a segment file for appending, creating it if missing.
+    /// The file is locked exclusively (see flock(2)) until the segment is closed.
+    /// @param path file path.
+    /// @return segment or std::nullopt if the file can't be opened, is locked by another writer or is not a segment.
+    static std::optional<Segment> create(const std::string &path);
+
+    /// Open a segment file for reading.
+    /// @param path file path.
+    /// @return segment or std::nullopt if the file can't be opened or is not a segment.
+    static std::optional<Segment> open(const std::string &path);
+
+    /// Grow a writable segment, preallocating and mapping at least a given size.
+    /// @param size required size.
+    /// @return false on failure, in which case the current mapping and its records stay readable.
+    bool reserve(size_t size);
+
+    /// Map the whole file of a read-only segment, picking up space preallocated by the writer.
+    /// @return false on failure.
+    bool remap();
+
+    /// Write mapped contents back to the file.
+    /// @return false on failure.
+    bool sync() const;
+
+    /// Get committed size, shared by the writer and readers of the file.
+    std::atomic<uint64_t> &committed() const;
+
+    /// Get mapped contents.
+    char *data() const;
+
+    /// Get mapped size.
+    size_t size() const;
+};
+
+
+/// Defines appender of collections to a segment file.
+/// Records become visible to readers once complete. A segment can have only one writer at a time:
+/// writers lock the file, so opening a second writer fails while the first one is open.
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class StoreWriter
+{
+    /// Stores segment.
+    Segment d_segment;
+
+    /// Stores record encoding buffer, reused between records.
+    std::string d_buffer;
+
+private:
+    /// Construct a writer of an open segment.
+    explicit StoreWriter(Segment segment);
+
+public:
+    /// Open a segment file for appending, creating it if missing.
+    /// Existing records are kept, new records are appended after them.
+    /// @param path file path.
+    /// @return writer or std::nullopt if the file can't be opened, has another writer or is not a segment.
+    static std::optional<StoreWriter<Holders...>> open(const std::string &path);
+
+    /// Append a collection.
+    /// @param collection collection to append.
+    /// @return record offset or std::nullopt if the segment can't grow, in which case nothing is appended.
+    std::optional<uint64_t> append(const Collection<Holders...> &collection);
+
+    /// Get committed size of the segment.
+    uint64_t size() const;
+
+    /// Write appended records back to the file.
+    /// @return false on failure.
+    bool sync() const;
+};
+
+
+/// Defines reader of collections from a segment file, that indexes records by attribute values.
+/// Every Single attribute is indexed by value, every Multiple attribute by name and value.
+/// Records are read as views into the mapping: views and string values stay valid until the next refresh().
+/// @tparam Holders pack of attribute holder types.
+template<typename... Holders>
+class StoreReader
+{
+public:
+    /// Defines record offsets, in append order.
+    using offsets_type = std::vector<uint64_t>;
+
+private:
+    /// Defines index of a holder: encoded values (prefixed by encoded names for associative attributes) to offsets.
+    using index_type = std::unordered_map<std::string, offsets_type>;
+
+    /// Stores segment.
+    Segment d_segment;
+
+    /// Stores end of the last indexed record.
+    uint64_t d_end = Segment::header_size;
+
+    /// Stores offsets of indexed records.
+    offsets_type d_offsets;
+
+    /// Stores indexes of holders.
+    std::array<index_type, sizeof...(Holders)> d_indexes;
+
+    /// Stores encoding buffer of index lookups.
+    mutable std::string d_buffer;
+
+private:
+    /// Construct a reader of an open segment.
+    explicit StoreReader(Segment segment);
+
+    /// Add a record to indexes.
+    /// @param offset record offset.
+    /// @param view record view.
+    void index(uint64_t offset, const CollectionView<Holders...> &view);
+
+    /// Look up a holder index.
+    /// @param index holder index.
+    /// @param key encoded value.
+    static const offsets_type &lookup(const index_type &index, const std::string &key);
+
+public:
+    /// Open a segment file for reading and index its records.
+    /// @param path file path.
+    /// @return reader or std::nullopt if the file can't be opened or is not a segment.
+    static std::optional<StoreReader<Holders...>> open(const std::string &path);
+
+    /// Index records committed since the last refresh.
+    /// @return number of new records.
+    size_t refresh();
+
+    /// Get offsets of all indexed records.
+    const offsets_type &offsets() const;
+
+    /// Read a record.
+    /// @param offset record offset.
+    /// @return record view or std::nullopt if there's no valid record at the offset.
+    std::optional<CollectionView<Holders...>> view(uint64_t offset) const;
+
+    /// Find records by attribute value.
+    /// @tparam Tag attribute tag type.
+    /// @tparam Vt value type, convertible to the attribute value type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param value attribute value.
+    /// @return offsets of records with the value, in append order.
+    template<typename Tag, typename Vt, typename H = traits::by_tag_t<Tag, Holders...>>
+    const offsets_type &find(Tag, const Vt &value) const;
+
+    /// Find records by named attribute value of associative attributes (i.e. Multiple holder).
+    /// @tparam Tag attribute tag type.
+    /// @tparam Vt value type, convertible to the attribute value type.
+    /// @tparam H attribute holder type, auto-deduced.
+    /// @param key attribute value name.
+    /// @param value attribute value.
+    /// @return offsets of records with the named value, in append order.
+    template<
+        typename Tag,
+        typename Vt,
+        typename H = traits::by_tag_t<Tag, Holders...>,
+        typename = std::void_t<typename H::key_type>>
+    const offsets_type &find(Tag, std::string_view key, const Vt &value) const;
+
+    /// Call a function for every indexed record.
+    /// @tparam F function type, called with record offset and view.
+    /// @param func function to call.
+    template<typename F>
+    void for_each(F &&func) const;
+};
+
+
+
+inline Segment::Segment(int fd)
+    : d_fd(fd)
+{
+}
+
+inline Segment::Segment(Segment &&other) noexcept
+    : d_fd(std::exchange(other.d_fd, -1))
+    , d_data(std::exchange(other.d_data, nullptr))
+    , d_size(std::exchange(other.d_size, 0))
+{
+}
+
+inline Segment &Segment::operator=(Segment &&other) noexcept
+{
+    if (this != &other)
+    {
+        this->~Segment();
+        d_fd = std::exchange(other.d_fd, -1);
+        d_data = std::exchange(other.d_data, nullptr);
+        d_size = std::exchange(other.d_size, 0);
+    }
+
+    return *this;
+}
+
+inline Segment::~Segment()
+{
+    if (d_data)
+    {
+        ::munmap(d_data, d_size);
+    }
+
+    if (d_fd >= 0)
+    {
+        ::close(d_fd);
+    }
+}
+
+inline bool Segment::map(size_t size, bool writable)
+{
+    // The new region is mapped before the old one is dropped, so records stay readable on failure
+    void *data = ::mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, d_fd, 0);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    if (d_data)
+    {
+        ::munmap(d_data, d_size);
+    }
+
+    d_data = static_cast<char *>(data);
+    d_size = size;
+    return true;
+}
+
+inline std::optional<Segment> Segment::create(const std::string &path)
+{
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Committed size must be shared lock-free");
+
+    std::optional<Segment> segment;
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return segment;
+    }
+
+    segment.emplace(Segment {fd});
+
+    // Two writers would append over each other's records
+    if (::flock(fd, LOCK_EX | LOCK_NB) != 0)
+    {
+        return std::nullopt;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        return std::nullopt;
+    }
+
+    if (info.st_size == 0)
+    {
+        if (::ftruncate(fd, initial_size) != 0 || !segment->map(initial_size, true))
+        {
+            return std::nullopt;
+        }
+
+        std::memcpy(segment->d_data, &magic, sizeof(magic));
+        std::memcpy(segment->d_data + sizeof(magic), &version, sizeof(version));
+        segment->committed().store(header_size, std::memory_order_release);
+    }
+    else if (size_t(info.st_size) < header_size || !segment->map(size_t(info.st_size), true))
+    {
+        return std::nullopt;
+    }
+
+    uint32_t header[2];
+    std::memcpy(header, segment->d_data, sizeof(header));
+    if (header[0] != magic || header[1] != version || segment->committed().load() > segment->d_size)
+    {
+        return std::nullopt;
+    }
+
+    return segment;
+}
+
+inline std::optional<Segment> Segment::open(const std::string &path)
+{
+    std::optional<Segment> segment;
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return segment;
+    }
+
+    segment.emplace(Segment {fd});
+    if (!segment->remap() || segment->d_size < header_size)
+    {
+        return std::nullopt;
+    }
+
+    uint32_t header[2];
+    std::memcpy(header, segment->d_data, sizeof(header));
+    if (header[0] != magic || header[1] != version)
+    {
+        return std::nullopt;
+    }
+
+    return segment;
+}
+
+inline bool Segment::reserve(size_t size)
+{
+    if (size <= d_size)
+    {
+        return true;
+    }
+
+    size_t capacity = std::max(d_size, initial_size);
+    while (capacity < size)
+    {
+        capacity *= 2;
+    }
+
+    return ::ftruncate(d_fd, off_t(capacity)) == 0 && map(capacity, true);
+}
+
+inline bool Segment::remap()
+{
+    struct stat info;
+    if (::fstat(d_fd, &info) != 0)
+    {
+        return false;
+    }
+
+    return size_t(info.st_size) == d_size || map(size_t(info.st_size), false);
+}
+
+inline bool Segment::sync() const
+{
+    return ::msync(d_data, d_size, MS_SYNC) == 0;
+}
+
+inline std::atomic<uint64_t> &Segment::committed() const
+{
+    return *reinterpret_cast<std::atomic<uint64_t> *>(d_data + 2 * sizeof(uint32_t));
+}
+
+inline char *Segment::data() const
+{
+    return d_data;
+}
+
+inline size_t Segment::size() const
+{
+    return d_size;
+}
+
+
+template<typename... Holders>
+StoreWriter<Holders...>::StoreWriter(Segment segment)
+    : d_segment(std::move(segment))
+{
+}
+
+template<typename... Holders>
+std::optional<StoreWriter<Holders...>> StoreWriter<Holders...>::open(const std::string &path)
+{
+    std::optional<Segment> segment = Segment::create(path);
+    if (!segment)
+    {
+        return std::nullopt;
+    }
+
+    return StoreWriter<Holders...> {std::move(*segment)};
+}
+
+template<typename... Holders>
+std::optional<uint64_t> StoreWriter<Holders...>::append(const Collection<Holders...> &collection)
+{
+    d_buffer.clear();
+    wire::put(d_buffer, uint32_t(0));
+    encode(collection, d_buffer);
+    wire::put(d_buffer, 0, uint32_t(d_buffer.size() - sizeof(uint32_t)));
+
+    const uint64_t offset = d_segment.committed().load(std::memory_order_relaxed);
+    if (!d_segment.reserve(offset + d_buffer.size()))
+    {
+        return std::nullopt;
+    }
+
+    std::memcpy(d_segment.data() + offset, d_buffer.data(), d_buffer.size());
+    d_segment.committed().store(offset + d_buffer.size(), std::memory_order_release);
+
+    return offset;
+}
+
+template<typename... Holders>
+uint64_t StoreWriter<Holders...>::size() const
+{
+    return d_segment.committed().load(std::memory_order_relaxed);
+}
+
+template<typename... Holders>
+bool StoreWriter<Holders...>::sync() const
+{
+    return d_segment.sync();
+}
+
+
+template<typename... Holders>
+StoreReader<Holders...>::StoreReader(Segment segment)
+    : d_segment(std::move(segment))
+{
+}
+
+template<typename... Holders>
+std::optional<StoreReader<Holders...>> StoreReader<Holders...>::open(const std::string &path)
+{
+    std::optional<Segment> segment = Segment::open(path);
+    if (!segment)
+    {
+        return std::nullopt;
+    }
+
+    std::optional<StoreReader<Holders...>> reader {StoreReader<Holders...> {std::move(*segment)}};
+    reader->refresh();
+
+    return reader;
+}
+
+template<typename... Holders>
+void StoreReader<Holders...>::index(uint64_t offset, const CollectionView<Holders...> &view)
+{
+    auto add = [&](auto tag) {
+        using Tag = decltype(tag);
+        using H = traits::by_tag_t<Tag, Holders...>;
+
+        index_type &index = d_indexes[traits::index_of_v<H, Holders...>];
+
+        if constexpr (traits::is_multiple_v<H>)
+        {
+            for (const auto &[key, value] : view(tag))
+            {
+                d_buffer.clear();
+                wire::put(d_buffer, uint32_t(key.size()));
+                d_buffer.append(key);
+                Codec<typename H::value_type>::encode(d_buffer, value);
+
+                index[d_buffer].push_back(offset);
+            }
+        }
+        else if (const auto value = view(tag))
+        {
+            d_buffer.clear();
+            Codec<typename H::value_type>::encode(d_buffer, *value);
+
+            index[d_buffer].push_back(offset);
+        }
+    };
+    (add(traits::tag_of_t<Holders> {}), ...);
+}
+
+template<typename... Holders>
+const typename StoreReader<Holders...>::offsets_type &StoreReader<Holders...>::lookup(
+    const index_type &index, const std::string &key)
+{
+    static const offsets_type none;
+
+    auto it = index.find(key);
+    return it == index.end() ? none : it->second;
+}
+
+template<typename... Holders>
+size_t StoreReader<Holders...>::refresh()
+{
+    const uint64_t end = d_segment.committed().load(std::memory_order_acquire);
+    if (end > d_segment.size() && (!d_segment.remap() || end > d_segment.size()))
+    {
+        return 0;
+    }
+
+    const size_t indexed = d_offsets.size();
+    while (d_end < end)
+    {
+        std::string_view rest {d_segment.data() + d_end, size_t(end - d_end)};
+        std::optional<std::string_view> record = wire::block(rest);
+        std::optional<CollectionView<Holders...>> view = record ? CollectionView<Holders...>::parse(*record) : std::nullopt;
+
+        if (!view)
+        {
+            break;
+        }
+
+        index(d_end, *view);
+        d_offsets.push_back(d_end);
+        d_end = end - rest.size();
+    }
+
+    return d_offsets.size() - indexed;
+}
+
+template<typename... Holders>
+const typename StoreReader<Holders...>::offsets_type &StoreReader<Holders...>::offsets() const
+{
+    return d_offsets;
+}
+
+template<typename... Holders>
+std::optional<CollectionView<Holders...>> StoreReader<Holders...>::view(uint64_t offset) const
+{
+    if (offset < Segment::header_size || offset >= d_end)
+    {
+        return std::nullopt;
+    }
+
+    std::string_view rest {d_segment.data() + offset, size_t(d_end - offset)};
+    std::optional<std::string_view> record = wire::block(rest);
+
+    return record ? CollectionView<Holders...>::parse(*record) : std::nullopt;
+}
+
+template<typename... Holders>
+template<typename Tag, typename Vt, typename H>
+const typename StoreReader<Holders...>::offsets_type &StoreReader<Holders...>::find(Tag, const Vt &value) const
+{
+    static_assert(!traits::is_multiple_v<H>, "Associative attributes are looked up by name and value");
+
+    d_buffer.clear();
+    Codec<typename H::value_type>::encode(d_buffer, value);
+
+    return lookup(d_indexes[traits::index_of_v<H, Holders...>], d_buffer);
+}
+
+template<typename... Holders>
+template<typename Tag, typename Vt, typename H, typename>
+const typename StoreReader<Holders...>::offsets_type &StoreReader<Holders...>::find(
+    Tag, std::string_view key, const Vt &value) const
+{
+    d_buffer.clear();
+    wire::put(d_buffer, uint32_t(key.size()));
+    d_buffer.append(key);
+    Codec<typename H::value_type>::encode(d_buffer, value);
+
+    return lookup(d_indexes[traits::index_of_v<H, Holders...>], d_buffer);
+}
+
+template<typename... Holders>
+template<typename F>
+void StoreReader<Holders...>::for_each(F &&func) const
+{
+    for (uint64_t offset : d_offsets)
+    {
+        func(offset, *view(offset));
+    }
+}
+
+
+} // namespace porter::attr
@@ -0,0 +1,342 @@
+#pragma once
+
+#include "storage.h"
+
+#include <cstring>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+
+namespace porter::attr {
+
+
+class SymbolTable;
+
+
+/// Defines a handle to a string interned in a symbol table.
+/// Handles are compared and hashed by identity and stay valid for as long as the table lives.
+class Symbol
+{
+    friend class SymbolTable;
+
+    /// Defines interned string record.
+    struct Entry
+    {
+        /// Interned string, owned by the table.
+        std::string_view text;
+
+        /// Dense symbol id, unique within the table.
+        uint32_t id;
+    };
+
+    /// Stores interned string record, null for empty symbols.
+    const Entry *d_entry = nullptr;
+
+private:
+    /// Construct a handle to interned string record.
+    /// @param entry interned string record.
+    explicit Symbol(const Entry *entry);
+
+public:
+    /// Defines id of an empty symbol.
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    /// Construct an empty symbol.
+    Symbol() = default;
+
+    /// Get interned string.
+    /// @return interned string or an empty string_view for empty symbols.
+    std::string_view view() const;
+
+    /// Get symbol id.
+    /// @return dense symbol id within its table or npos for empty symbols.
+    uint32_t id() const;
+
+    /// Get interned string.
+    operator std::string_view() const;
+
+    /// Compare symbols by identity.
+    friend bool operator==(Symbol lhs, Symbol rhs) { return lhs.d_entry == rhs.d_entry; }
+
+    /// Compare symbols by identity.
+    friend bool operator!=(Symbol lhs, Symbol rhs) { return lhs.d_entry != rhs.d_entry; }
+};
+
+
+/// Defines a deduplicating table of interned strings.
+/// Interning and lookups are thread-safe. Interned strings are never released before the table itself.
+class SymbolTable
+{
+    /// Guards table state.
+    mutable std::shared_mutex d_mutex;
+
+    /// Stores memory resource for table state and interned strings.
+    std::pmr::memory_resource *d_resource;
+
+    /// Stores interned string records (deque keeps their addresses stable).
+    std::pmr::deque<Symbol::Entry> d_entries;
+
+    /// Stores interned string index.
+    std::pmr::unordered_map<std::string_view, const Symbol::Entry *> d_index;
+
+public:
+    /// Construct an empty table.
+    /// @param resource memory resource for table state and interned strings.
+    explicit SymbolTable(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    /// Not copyable: symbols refer to table records.
+    SymbolTable(const SymbolTable &) = delete;
+
+    /// Not copyable: symbols refer to table records.
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    /// Release interned strings.
+    ~SymbolTable();
+
+    /// Intern a string, reusing an existing record if the string was already interned.
+    /// @param text string to intern.
+    /// @return symbol for interned string.
+    Symbol intern(std::string_view text);
+
+    /// Look up an interned string without interning it.
+    /// @param text string to look up.
+    /// @return symbol for interned string or std::nullopt if the string was never interned.
+    std::optional<Symbol> find(std::string_view text) const;
+
+    /// Get number of interned strings.
+    size_t size() const;
+
+    /// Get process-wide symbol table.
+    static SymbolTable &global();
+};
+
+
+/// Defines an interned string attribute value, e.g. Value<tag::service_t, Interned<>>.
+/// Values are interned once on construction; afterwards they are compared and hashed by symbol identity,
+/// and still read as strings through the std::string_view conversion.
+/// @tparam Table function that returns a symbol table to intern values into.
+template<SymbolTable &(*Table)() = &SymbolTable::global>
+class Interned : public Symbol
+{
+public:
+    /// Construct an empty value.
+    Interned() = default;
+
+    /// Construct a value from a symbol of the same table.
+    /// @param symbol interned string.
+    explicit Interned(Symbol symbol);
+
+    /// Construct a value by interning a string.
+    /// @param text string to intern.
+    explicit Interned(std::string_view text);
+
+    /// Get symbol table of the values.
+    static SymbolTable &table();
+};
+
+
+namespace traits {
+
+
+/// Template that checks whether a value type is an interned string.
+template<typename V> struct is_interned : std::is_base_of<Symbol, V> {};
+
+/// Helper variable for checking whether a value type is an interned string.
+template<typename V> inline constexpr bool is_interned_v = is_interned<V>::value;
+
+
+} // namespace traits
+
+
+namespace storage {
+
+
+/// Storage policy that keys attribute values on interned symbols.
+/// Names are interned once on insertion; afterwards values are hashed and compared by symbol identity.
+/// @tparam Base underlying storage policy, e.g. Hashed or Flat<N>.
+/// @tparam Table function that returns a symbol table to intern names into.
+template<typename Base = Hashed, SymbolTable &(*Table)() = &SymbolTable::global>
+struct Interned
+{
+    /// Defines storage key type.
+    using key_type = Symbol;
+
+    /// Defines value storage type.
+    template<typename K, typename V> using type = typename Base::template type<K, V>;
+
+    /// Translate attribute name into storage key, interning it.
+    static key_type key(std::string_view key) { return Table().intern(key); }
+
+    /// Translate attribute name into storage key.
+    static key_type key(Symbol key) { return key; }
+
+    /// Look up a value by interned attribute name.
+    template<typename C>
+    static typename C::const_iterator find(const C &values, Symbol key) { return values.find(key); }
+
+    /// Look up a value by attribute name. Names that were never interned are not interned by lookups.
+    template<typename C>
+    static typename C::const_iterator find(const C &values, std::string_view key)
+    {
+        std::optional<Symbol> symbol = Table().find(key);
+        return symbol ? values.find(*symbol) : values.end();
+    }
+};
+
+
+} // namespace storage
+
+
+
+inline Symbol::Symbol(const Entry *entry)
+    : d_entry(entry)
+{
+}
+
+inline std::string_view Symbol::view() const
+{
+    return d_entry ? d_entry->text : std::string_view {};
+}
+
+inline uint32_t Symbol::id() const
+{
+    return d_entry ? d_entry->id : npos;
+}
+
+inline Symbol::operator std::string_view() const
+{
+    return view();
+}
+
+
+template<SymbolTable &(*Table)()>
+Interned<Table>::Interned(Symbol symbol)
+    : Symbol(symbol)
+{
+}
+
+template<SymbolTable &(*Table)()>
+Interned<Table>::Interned(std::string_view text)
+    : Symbol(Table().intern(text))
+{
+}
+
+template<SymbolTable &(*Table)()>
+SymbolTable &Interned<Table>::table()
+{
+    return Table();
+}
+
+
+inline SymbolTable::SymbolTable(std::pmr::memory_resource *resource)
+    : d_resource(resource)
+    , d_entries(resource)
+    , d_index(resource)
+{
+}
+
+inline SymbolTable::~SymbolTable()
+{
+    for (const Symbol::Entry &entry : d_entries)
+    {
+        d_resource->deallocate(const_cast<char *>(entry.text.data()), entry.text.size(), alignof(char));
+    }
+}
+
+inline Symbol SymbolTable::intern(std::string_view text)
+{
+    if (std::optional<Symbol> found = find(text))
+    {
+        return *found;
+    }
+
+    std::unique_lock lock {d_mutex};
+
+    if (auto it = d_index.find(text); it != d_index.end())
+    {
+        return Symbol {it->second};
+    }
+
+    // Releases the string and its record unless both are indexed, so a failed insertion leaks neither
+    struct Pending
+    {
+        SymbolTable &table;
+        char *buffer;
+        size_t size;
+        bool recorded = false;
+        bool indexed = false;
+
+        ~Pending()
+        {
+            if (!indexed)
+            {
+                if (recorded)
+                {
+                    table.d_entries.pop_back();
+                }
+
+                table.d_resource->deallocate(buffer, size, alignof(char));
+            }
+        }
+    } pending {*this, static_cast<char *>(d_resource->allocate(text.size(), alignof(char))), text.size()};
+
+    std::memcpy(pending.buffer, text.data(), text.size());
+
+    const Symbol::Entry &entry = d_entries.emplace_back(
+        Symbol::Entry {std::string_view {pending.buffer, text.size()}, static_cast<uint32_t>(d_entries.size())});
+    pending.recorded = true;
+
+    d_index.emplace(entry.text, &entry);
+    pending.indexed = true;
+
+    return Symbol {&entry};
+}
+
+inline std::optional<Symbol> SymbolTable::find(std::string_view text) const
+{
+    std::shared_lock lock {d_mutex};
+
+    auto it = d_index.find(text);
+    return it == d_index.end() ? std::optional<Symbol> {} : Symbol {it->second};
+}
+
+inline size_t SymbolTable::size() const
+{
+    std::shared_lock lock {d_mutex};
+    return d_entries.size();
+}
+
+inline SymbolTable &SymbolTable::global()
+{
+    static SymbolTable table {std::pmr::new_delete_resource()};
+    return table;
+}
+
+
+} // namespace porter::attr
+
+
+namespace std {
+
+
+/// Symbols are hashed by their dense id.
+template<>
+struct hash<porter::attr::Symbol>
+{
+    size_t operator()(porter::attr::Symbol symbol) const noexcept { return symbol.id(); }
+};
+
+/// Interned values are hashed by their dense symbol id.
+template<porter::attr::SymbolTable &(*Table)()>
+struct hash<porter::attr::Interned<Table>> : hash<porter::attr::Symbol> {};
+
+
+} // namespace std
@@ -1,11 +1,38 @@
 #include <iostream>
 #include <sstream>
 #include <string_view>
+#include <memory_resource>
 #include <cassert>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <limits>
 
 #include "attribute.h"
 #include "holder.h"
 #include "collection.h"
+#include "symbol.h"
+#include "key.h"
+#include "packed.h"
+#include "serialize.h"
+#include "format.h"
+#include "scope.h"
+#include "layered.h"
+#include "published.h"
+#include "batch.h"
+#include "filter.h"
+#include "query.h"
+#include "any.h"
+#include "fingerprint.h"
+#include "delta.h"
+#include "store.h"
+#include "aggregate.h"
+#include "async.h"
+#include "lazy.h"
+#include "instrument.h"
+#include "memory.h"
+#include "schema.h"
 #include"tags.h"
 
 
@@ -63,6 +90,2002 @@ void test_attribute()
     assert( sum2(tag::service) == "pisvc" );
     assert( sum2(tag::subsystem) == "adc" );
     assert( sum2(tag::label) == 4242 );
+
+    auto sum3 = Service("pisvc") + Context("LID", "FIINDEX:LUATTRUU");
+    assert( sum3(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+}
+
+
+void test_flat_storage()
+{
+    using Flat = attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Flat<2>>;
+
+    // Inline storage
+    Flat context;
+    context = Context("LID", "FIINDEX:LUATTRUU");
+    context = Context("DFPATH", "anton-test.1");
+    assert( (*context).size() == 2 );
+    assert( (*context).capacity() == 2 );
+    assert( context("LID")->get() == "FIINDEX:LUATTRUU" );
+    assert( context("NONE") == std::nullopt );
+
+    // Overwrite keeps a single entry
+    context = Context("LID", "FIINDEX:OTHER");
+    assert( (*context).size() == 2 );
+    assert( context("LID")->get() == "FIINDEX:OTHER" );
+
+    // Spill to the heap
+    context = Context("HOST", "localhost");
+    assert( (*context).size() == 3 );
+    assert( (*context).capacity() > 2 );
+    assert( context("DFPATH")->get() == "anton-test.1" );
+    assert( context("HOST")->get() == "localhost" );
+
+    // Copy and move
+    Flat copy {context};
+    Flat moved {std::move(context)};
+    assert( copy("HOST")->get() == "localhost" );
+    assert( moved("LID")->get() == "FIINDEX:OTHER" );
+
+    // Collection access
+    using Coll = attr::Collection<attr::Single<tag::service_t, true>, Flat>;
+
+    Coll coll;
+    coll << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU");
+    assert( coll(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+    assert( coll(tag::context).size() == 1 );
+
+    // Extension with an attribute of a present tag keeps its holder and entries
+    auto extended = std::move(coll).extend(Context("DFPATH", "anton-test.1"));
+    static_assert( std::is_same_v<attr::traits::find_tag_t<tag::context_t, decltype(extended)>, Flat> );
+    assert( extended(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+    assert( extended(tag::context, "DFPATH")->get() == "anton-test.1" );
+    assert( extended(tag::context).capacity() == 2 );
+
+    // Holders of the same tag are rejected
+    static_assert( !attr::traits::are_holders_valid_v<attr::Single<tag::service_t, true>, Flat, attr::Multiple<tag::context_t>> );
+
+    // Failed growth keeps entries: values with throwing moves are copied, and a throwing copy rolls back
+    static bool fail = false;
+    struct Fragile
+    {
+        std::string value = "FIINDEX:BEYOND-SMALL-STRING-BUFFER";
+
+        Fragile() = default;
+        Fragile(const Fragile &other) : value(other.value) { if (fail) { throw std::bad_alloc {}; } }
+        Fragile(Fragile &&other) : value(std::move(other.value)) {}
+        Fragile &operator=(const Fragile &) = default;
+        Fragile &operator=(Fragile &&) = default;
+    };
+
+    attr::FlatMap<int, Fragile, 1> fragile;
+    fragile[1];
+    fail = true;
+
+    bool thrown = false;
+    try
+    {
+        fragile[2];
+    }
+    catch (const std::bad_alloc &)
+    {
+        thrown = true;
+    }
+
+    fail = false;
+    assert( thrown );
+    assert( fragile.size() == 1 && fragile.capacity() == 1 );
+    assert( fragile.find(1)->second.value == "FIINDEX:BEYOND-SMALL-STRING-BUFFER" );
+}
+
+
+
+/// Defines a memory resource counting allocations passed to its upstream resource.
+/// Optionally fails once a given number of allocations is made.
+struct CountingResource : std::pmr::memory_resource
+{
+    std::pmr::memory_resource *upstream;
+
+    size_t allocations = 0;
+    size_t outstanding = 0;
+    size_t limit = std::numeric_limits<size_t>::max();
+
+    explicit CountingResource(std::pmr::memory_resource *upstream) : upstream(upstream) {}
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        if (allocations == limit)
+        {
+            throw std::bad_alloc {};
+        }
+
+        ++allocations;
+        ++outstanding;
+        return upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override
+    {
+        --outstanding;
+        upstream->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+
+void test_allocator()
+{
+    using PmrContext = attr::KeyValue<tag::context_t, std::pair<std::string_view, std::pmr::string>>;
+    using PmrId = attr::Value<tag::id_t, std::pmr::string>;
+
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t, std::pmr::string, attr::storage::pmr::Hashed>
+    >;
+
+    static_assert( sizeof(attr::Single<tag::label_t, true>) == sizeof(std::optional<uint32_t>) );
+
+    // Any allocation outside of the arena throws
+    std::pmr::memory_resource *global = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+
+    {
+        char buffer[16384];
+        std::pmr::monotonic_buffer_resource arena {buffer, sizeof buffer, std::pmr::null_memory_resource()};
+        std::pmr::polymorphic_allocator<std::byte> allocator {&arena};
+
+        const std::string_view lid = "FIINDEX:LUATTRUU:BEYOND-SMALL-STRING-BUFFER";
+
+        Coll coll {std::allocator_arg, allocator};
+        coll << Service("pisvc");
+        coll << PmrContext(std::allocator_arg, allocator, "LID", lid);
+        assert( coll(tag::context, "LID")->get() == lid );
+        assert( coll(tag::context).get_allocator().resource() == &arena );
+
+        Coll copy {std::allocator_arg, allocator, coll};
+        assert( copy(tag::context, "LID")->get() == lid );
+
+        auto extended = std::move(copy).extend(
+            std::allocator_arg, allocator,
+            PmrId(std::allocator_arg, allocator, "ID:BEYOND-SMALL-STRING-BUFFER"),
+            Label(42));
+        assert( extended(tag::id) == "ID:BEYOND-SMALL-STRING-BUFFER" );
+        assert( extended(tag::id)->get_allocator().resource() == &arena );
+        assert( extended(tag::context, "LID")->get() == lid );
+        assert( extended(tag::label) == 42u );
+
+        using Flat = attr::Multiple<tag::context_t, std::pmr::string, attr::storage::pmr::Flat<1>>;
+        Flat flat {allocator};
+        flat = PmrContext(std::allocator_arg, allocator, "LID", lid);
+        flat = PmrContext(std::allocator_arg, allocator, "DFPATH", lid);
+        assert( flat("DFPATH")->get() == lid );
+        assert( (*flat).get_allocator().resource() == &arena );
+
+        // Extension with a KeyValue keeps the arena-backed holder, so new entries are allocated on the arena
+        CountingResource counting {&arena};
+        std::pmr::polymorphic_allocator<std::byte> counted {&counting};
+
+        Coll source {std::allocator_arg, counted};
+        source << Service("pisvc") << PmrContext(std::allocator_arg, counted, "LID", lid);
+        PmrContext dfpath {std::allocator_arg, counted, "DFPATH", lid};
+        const size_t allocations = counting.allocations;
+
+        auto keyed = std::move(source).extend(std::move(dfpath));
+        static_assert( std::is_same_v<decltype(keyed), attr::traits::canonical_t<Coll>> );
+        assert( keyed(tag::context).get_allocator().resource() == &counting );
+        assert( keyed(tag::context, "LID")->get() == lid && keyed(tag::context, "DFPATH")->get() == lid );
+        assert( counting.allocations > allocations );
+    }
+
+    std::pmr::set_default_resource(global);
+}
+
+
+
+void test_symbols()
+{
+    // Deduplication
+    attr::SymbolTable table;
+    attr::Symbol lid = table.intern("LID");
+    assert( table.intern(std::string {"LID"}) == lid );
+    assert( table.intern("DFPATH") != lid );
+    assert( lid.view() == "LID" );
+    assert( lid.id() == 0 );
+    assert( table.size() == 2 );
+    assert( table.find("NONE") == std::nullopt );
+    assert( table.size() == 2 );
+
+    // Failed insertions release their strings and records
+    bool interned = false;
+    for (size_t limit = 0; !interned; ++limit)
+    {
+        CountingResource counting {std::pmr::new_delete_resource()};
+        {
+            attr::SymbolTable failing {&counting};
+            failing.intern("LID");
+            counting.limit = counting.allocations + limit;
+
+            try
+            {
+                failing.intern("DFPATH:BEYOND-SMALL-STRING-BUFFER");
+                interned = true;
+            }
+            catch (const std::bad_alloc &)
+            {
+            }
+
+            assert( failing.size() == (interned ? 2 : 1) );
+            assert( failing.find("DFPATH:BEYOND-SMALL-STRING-BUFFER").has_value() == interned );
+            assert( failing.find("LID")->view() == "LID" );
+
+            counting.limit = std::numeric_limits<size_t>::max();
+            assert( failing.intern("DFPATH:BEYOND-SMALL-STRING-BUFFER").id() == 1 );
+        }
+        assert( counting.outstanding == 0 );
+    }
+
+    // Interned Multiple keys outlive their source strings
+    using Interned = attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Interned<>>;
+    using Coll = attr::Collection<attr::Single<tag::service_t, true>, Interned>;
+
+    Coll coll;
+    {
+        std::string key = "LID";
+        coll << Context(key, "FIINDEX:LUATTRUU");
+        key = "XXX";
+    }
+
+    attr::Symbol key = attr::SymbolTable::global().intern("LID");
+    assert( coll(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+    assert( coll(tag::context, key)->get() == "FIINDEX:LUATTRUU" );
+    assert( coll(tag::context, "XXX") == std::nullopt );
+    assert( !attr::SymbolTable::global().find("XXX") );
+
+    // Symbol keys
+    coll << attr::KeyValue<tag::context_t, std::pair<attr::Symbol, std::string>>(key, "FIINDEX:OTHER");
+    assert( coll(tag::context).size() == 1 );
+    assert( coll(tag::context, "LID")->get() == "FIINDEX:OTHER" );
+
+    // Flat storage with interned keys
+    attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Interned<attr::storage::Flat<4>>> flat;
+    flat = Context("LID", "FIINDEX:LUATTRUU");
+    assert( flat(key)->get() == "FIINDEX:LUATTRUU" );
+}
+
+
+
+void test_keys()
+{
+    using namespace attr::literals;
+
+    // Compile-time hashing
+    constexpr attr::Key lid = "LID"_akey;
+    static_assert( lid.hash() == attr::hash_name("LID") );
+    static_assert( lid == attr::Key {"LID"} );
+    static_assert( lid != "DFPATH"_akey );
+    static_assert( lid.view() == "LID" );
+
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Keyed>,
+        attr::Multiple<tag::id_t, tag::id_t::type, attr::storage::Flat<2>>
+    >;
+
+    // Default storage keeps plain names
+    static_assert( std::is_same_v<attr::Multiple<tag::context_t>::key_type, std::string_view> );
+
+    attr::Multiple<tag::context_t> plain;
+    plain = attr::KeyValue<tag::context_t, std::pair<attr::Key, std::string>>("LID"_akey, "FIINDEX:LUATTRUU");
+    for (const auto &[key, value] : *plain)
+    {
+        assert( key == "LID" && value == "FIINDEX:LUATTRUU" );
+    }
+    assert( plain(lid)->get() == "FIINDEX:LUATTRUU" );
+
+    Coll coll;
+    coll << Context("LID", "FIINDEX:LUATTRUU");
+    coll << attr::KeyValue<tag::context_t, std::pair<attr::Key, std::string>>("DFPATH"_akey, "anton-test.1");
+    coll << attr::KeyValue<tag::id_t, std::pair<attr::Key, std::string_view>>("LID"_akey, "id");
+
+    // Lookups by precomputed and runtime keys
+    assert( coll(tag::context, lid)->get() == "FIINDEX:LUATTRUU" );
+    assert( coll(tag::context, "DFPATH")->get() == "anton-test.1" );
+    assert( coll(tag::context, std::string {"DFPATH"})->get() == "anton-test.1" );
+    assert( coll(tag::context, "NONE"_akey) == std::nullopt );
+
+    // Precomputed keys work with other storage policies
+    assert( coll(tag::id, lid)->get() == "id" );
+
+    // Extension keeps keyed storage, so old keys are still found
+    auto extended = std::move(coll).extend(Context("HOST", "localhost"), Service("pisvc"));
+    static_assert( std::is_same_v<
+        attr::traits::find_tag_t<tag::context_t, decltype(extended)>,
+        attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Keyed>> );
+    assert( extended(tag::context, lid)->get() == "FIINDEX:LUATTRUU" );
+    assert( extended(tag::context, "HOST")->get() == "localhost" );
+}
+
+
+
+void test_packed()
+{
+    using Singles = attr::Collection<
+        attr::Single<tag::id_t, true>,
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::pwho_t, true>,
+        attr::Single<tag::label_t, false>
+    >;
+
+    using Packed = attr::PackedCollection<
+        attr::Single<tag::id_t, true>,
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::pwho_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    static_assert( std::is_same_v<Packed::mask_type, uint8_t> );
+    static_assert( Packed::required == 0b01011 );
+    static_assert( sizeof(attr::PackedCollection<attr::Single<tag::label_t, true>>) == 2 * sizeof(uint32_t) );
+    static_assert( sizeof(Packed) - sizeof(attr::Multiple<tag::context_t>) < sizeof(Singles) );
+
+    // Value assignment and presence tracking
+    Packed packed;
+    assert( !packed );
+    assert( packed(tag::service) == std::nullopt );
+
+    packed << Id("id") << Service("pisvc") << Pwho(1234);
+    assert( packed );
+    assert( packed.present() == 0b01011 );
+    assert( packed(tag::service)->get() == "pisvc" );
+    assert( packed(tag::pwho)->get() == 1234 );
+    assert( packed(tag::label) == std::nullopt );
+
+    packed << Context("LID", "FIINDEX:LUATTRUU");
+    assert( packed(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+    assert( packed(tag::context).size() == 1 );
+
+    // Conversion from and to regular collections
+    Singles singles;
+    singles << Service("integsvc") << Label(42);
+
+    Packed converted {singles};
+    assert( !converted );
+    assert( converted(tag::service)->get() == "integsvc" );
+    assert( converted(tag::label)->get() == 42 );
+    assert( converted(tag::id) == std::nullopt );
+
+    auto unpacked = packed.unpack();
+    assert( unpacked );
+    assert( unpacked(tag::id) == "id" );
+    assert( unpacked(tag::label) == std::nullopt );
+    assert( unpacked(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+}
+
+
+namespace tag {
+
+
+/// Defines narrow tags for layout checks.
+struct small_t { using type = uint8_t; static constexpr std::string_view value = "small"; };
+struct tiny_t { using type = uint8_t; static constexpr std::string_view value = "tiny"; };
+
+inline constexpr small_t small;
+inline constexpr tiny_t tiny;
+
+
+} // namespace tag
+
+
+void test_layout()
+{
+    using SmallHolder = attr::Single<tag::small_t, false>;
+    using TinyHolder = attr::Single<tag::tiny_t, false>;
+    using ServiceHolder = attr::Single<tag::service_t, true>;
+    using LabelHolder = attr::Single<tag::label_t, false>;
+
+    // Storage is sorted by alignment and size, regardless of declaration order
+    using Interleaved = attr::Collection<SmallHolder, ServiceHolder, TinyHolder>;
+    using Sorted = attr::traits::slots<ServiceHolder, SmallHolder, TinyHolder>;
+
+    static_assert( std::is_same_v<attr::traits::layout_t<SmallHolder, ServiceHolder, TinyHolder>, Sorted> );
+    static_assert( std::is_same_v<attr::traits::layout_t<TinyHolder, SmallHolder, ServiceHolder>, Sorted> );
+    static_assert( sizeof(Interleaved) == sizeof(Sorted) );
+    static_assert( sizeof(Interleaved) < sizeof(std::tuple<SmallHolder, ServiceHolder, TinyHolder>) );
+
+    Interleaved interleaved;
+    interleaved << attr::Value<tag::small_t> {1} << Service("pisvc");
+    assert( interleaved(tag::small) == 1 );
+    assert( interleaved(tag::service) == "pisvc" );
+    assert( !interleaved(tag::tiny) );
+    assert( interleaved );
+
+    // Same holder set yields the same canonical type
+    static_assert( std::is_same_v<
+        attr::traits::canonical_t<attr::Collection<LabelHolder, ServiceHolder>>,
+        attr::traits::canonical_t<attr::Collection<ServiceHolder, LabelHolder, ServiceHolder>>> );
+
+    auto lhs = Service("pisvc") + Label(42) + Pwho(1234);
+    auto rhs = Pwho(1234) + Label(42) + Service("pisvc");
+    static_assert( std::is_same_v<decltype(lhs)::type, decltype(rhs)::type> );
+
+    auto extended = std::move(lhs).extend(Subsystem("adc"), Service("integsvc"));
+    static_assert( std::is_same_v<decltype(extended), decltype(std::move(rhs).extend(Subsystem("adc")))> );
+    assert( extended(tag::service) == "integsvc" );
+    assert( extended(tag::subsystem) == "adc" );
+    assert( extended(tag::label) == 42 );
+
+    // Extending with a value of a present tag stores it in the existing holder
+    using Optional = attr::Collection<attr::Single<tag::service_t, true>, attr::Single<tag::label_t, false>>;
+
+    Optional optional;
+    optional << Service("pisvc");
+    auto labelled = std::move(optional).extend(Label(42));
+    static_assert( std::is_same_v<decltype(labelled), attr::traits::canonical_t<Optional>> );
+    assert( labelled(tag::label) == 42u );
+    static_assert( sizeof(labelled) == sizeof(Optional) );
+
+    // Declared orders are distinct types, implicitly convertible only between permutations of the same holders
+    static_assert( !std::is_same_v<Optional, attr::traits::canonical_t<Optional>> );
+    static_assert( attr::traits::is_permutation_v<Optional, decltype(labelled)> );
+    static_assert( !attr::traits::is_permutation_v<Optional, attr::Collection<ServiceHolder>> );
+    static_assert( !std::is_convertible_v<attr::Collection<ServiceHolder>, Optional> );
+
+    Optional declared = labelled;
+    assert( declared(tag::service) == "pisvc" && declared(tag::label) == 42u );
+
+    // Sums convert to any declared order of their holders, but not to other holder sets
+    using Required = attr::Collection<attr::Single<tag::service_t, true>, attr::Single<tag::label_t, true>>;
+    static_assert( !std::is_convertible_v<decltype(Service("integsvc") + Label(7)), Optional> );
+
+    Required added = Service("integsvc") + Label(7);
+    assert( added(tag::service) == "integsvc" && added(tag::label) == 7u );
+}
+
+
+void test_concat()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    // Chains stay lazy and resolve to the canonical collection type
+    auto chain = Service("a") + Subsystem("b") + Label(1) + Pwho(2) + Label(3);
+    static_assert( std::is_same_v<decltype(chain), attr::Concat<attr::Collection<>,
+        Service, Subsystem, Label, Pwho, Label>> );
+    static_assert( std::is_same_v<decltype(chain)::type, decltype(Pwho(2) + Label(1) + Subsystem("b") + Service("a"))::type> );
+
+    // Reads are served without materialization, later values take priority
+    assert( chain );
+    assert( chain(tag::service) == "a" );
+    assert( chain(tag::label) == 3 );
+    assert( chain(tag::pwho) == 2 );
+
+    // Base collection values are visible and overridden by added values
+    Coll base;
+    base << Service("base") << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+    assert( !(Coll {} + Label(4)) );
+
+    auto added = std::move(base) + Context("LID", "FIINDEX:OVERRIDE") + Subsystem("adc");
+    assert( added );
+    assert( added(tag::service) == "base" );
+    assert( added(tag::context, "LID")->get() == "FIINDEX:OVERRIDE" );
+    assert( added(tag::context, "DFPATH")->get() == "anton-test.1" );
+    assert( added(tag::context, "NONE") == std::nullopt );
+
+    // Materialization constructs the final collection once
+    decltype(added)::type materialized = added;
+    assert( materialized(tag::subsystem) == "adc" );
+    assert( materialized(tag::context, "LID")->get() == "FIINDEX:OVERRIDE" );
+    assert( materialized(tag::context).size() == 2 );
+
+    auto collection = std::move(added).collection();
+    assert( collection(tag::service) == "base" );
+    assert( collection(tag::context, "LID")->get() == "FIINDEX:OVERRIDE" );
+
+    // Chains store only their parts, nested one node per addition
+    static_assert( sizeof(decltype(chain)) == sizeof(attr::traits::chain_t<attr::Collection<>,
+        Service, Subsystem, Label, Pwho, Label>) );
+    static_assert( sizeof(decltype(Coll {} + Label(4))) == sizeof(attr::traits::link<Coll, Label>) );
+
+    // Updates and holder access consume the chain, materializing the resulting collection
+    auto updated = (Service("x") + Subsystem("y")) << Service("z");
+    static_assert( std::is_same_v<decltype(updated), decltype(Service("x") + Subsystem("y"))::type> );
+    updated << Subsystem("w");
+    assert( updated(tag::service) == "z" );
+    assert( (*(Service("x") + Subsystem("w")).holder<attr::Single<tag::subsystem_t, true>>() == "w") );
+    assert( updated );
+
+    auto appended = std::move(updated) + Label(5);
+    assert( appended(tag::service) == "z" );
+    assert( appended(tag::label) == 5 );
+    assert( std::move(appended).collection()(tag::subsystem) == "w" );
+}
+
+
+void test_serialize()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    Coll coll;
+    coll << Service("pisvc") << Label(42)
+         << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+
+    const std::string buffer = attr::encode(coll);
+
+    // Values are read straight from the buffer
+    auto view = attr::CollectionView<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >::parse(buffer);
+
+    assert( view );
+    assert( *view );
+    assert( (*view)(tag::service) == "pisvc" );
+    assert( (*view)(tag::service)->data() >= buffer.data() );
+    assert( (*view)(tag::service)->data() < buffer.data() + buffer.size() );
+    assert( (*view)(tag::subsystem) == std::nullopt );
+    assert( (*view)(tag::label) == 42u );
+    assert( (*view)(tag::context).size() == 2 );
+    assert( (*view)(tag::context, "LID") == "FIINDEX:LUATTRUU" );
+    assert( (*view)(tag::context, "NONE") == std::nullopt );
+
+    size_t pairs = 0;
+    for (const auto &[key, value] : (*view)(tag::context))
+    {
+        assert( coll(tag::context, key)->get() == value );
+        ++pairs;
+    }
+    assert( pairs == 2 );
+
+    // Views of other holder sets match attributes by tag
+    auto partial = attr::CollectionView<
+        attr::Single<tag::label_t, false>,
+        attr::Single<tag::pwho_t, true>
+    >::parse(buffer);
+
+    assert( partial );
+    assert( !*partial );
+    assert( (*partial)(tag::label) == 42u );
+    assert( (*partial)(tag::pwho) == std::nullopt );
+
+    // Decoding into a collection
+    Coll decoded = view->collection();
+    assert( decoded(tag::service) == "pisvc" );
+    assert( decoded(tag::label) == 42u );
+    assert( decoded(tag::context, "DFPATH")->get() == "anton-test.1" );
+
+    // Malformed buffers are rejected
+    assert( !decltype(view)::value_type::parse({}) );
+    assert( !decltype(view)::value_type::parse(std::string_view {buffer}.substr(0, buffer.size() - 1)) );
+    assert( !decltype(view)::value_type::parse(buffer + "x") );
+}
+
+
+void test_format()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Flat<2>>
+    >;
+
+    Coll coll;
+    coll << Service("pisvc") << Label(42)
+         << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+
+    char buffer[128];
+    std::to_chars_result result = attr::format(std::begin(buffer), std::end(buffer), coll);
+    assert( result.ec == std::errc {} );
+    assert( std::string_view(buffer, result.ptr - buffer)
+        == "service=pisvc label=42 context.LID=FIINDEX:LUATTRUU context.DFPATH=anton-test.1" );
+
+    // Short buffers are reported
+    result = attr::format(std::begin(buffer), std::begin(buffer) + 20, coll);
+    assert( result.ec == std::errc::value_too_large );
+    assert( result.ptr == std::begin(buffer) + 20 );
+
+    // Fixed-width collections can be formatted into buffers sized at compile time
+    using Fixed = attr::Collection<attr::Single<tag::pwho_t, true>, attr::Single<tag::label_t, false>>;
+    static_assert( attr::traits::prefix_v<tag::pwho_t> == "pwho=" );
+    static_assert( attr::traits::prefix_v<tag::context_t, '.'> == "context." );
+    static_assert( attr::traits::max_formatted_size_v<Fixed> == 5 + 10 + 1 + 6 + 10 );
+
+    Fixed fixed;
+    fixed << Pwho(4294967295u) << Label(4294967295u);
+
+    std::array<char, attr::traits::max_formatted_size_v<Fixed>> stack;
+    assert( attr::format(stack, fixed) == "pwho=4294967295 label=4294967295" );
+    assert( attr::format(stack, Fixed {}) == "" );
+}
+
+
+void test_scope()
+{
+    using Scope = attr::Scope<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    assert( !Scope::top() );
+    assert( Scope::get(tag::service) == std::nullopt );
+    assert( !Scope::ready() );
+
+    {
+        Scope outer {Service("pisvc"), Context("LID", "FIINDEX:LUATTRUU")};
+        assert( Scope::top() == &outer );
+        assert( Scope::ready() );
+
+        {
+            Scope inner;
+            inner << Subsystem("adc") << Context("LID", "FIINDEX:INNER") << Context("DFPATH", "anton-test.1");
+
+            // Innermost values win, outer values are visible
+            assert( Scope::get(tag::service) == "pisvc" );
+            assert( Scope::get(tag::subsystem) == "adc" );
+            assert( Scope::get(tag::context, "LID")->get() == "FIINDEX:INNER" );
+            assert( Scope::get(tag::context, "DFPATH")->get() == "anton-test.1" );
+            assert( inner.frame()(tag::service) == std::nullopt );
+
+            auto effective = Scope::collection();
+            assert( effective(tag::service) == "pisvc" );
+            assert( effective(tag::context, "LID")->get() == "FIINDEX:INNER" );
+            assert( effective(tag::context).size() == 2 );
+        }
+
+        // Popped frames are no longer visible
+        assert( Scope::top() == &outer );
+        assert( Scope::get(tag::subsystem) == std::nullopt );
+        assert( Scope::get(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+    }
+
+    assert( !Scope::top() );
+}
+
+
+void test_layered()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+    using Layered = attr::Layered<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    Coll base;
+    base << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+
+    const Layered process {std::move(base)};
+    assert( process );
+    assert( process.depth() == 1 );
+
+    // Derived collections share base layers
+    Layered request = process.derive();
+    assert( request.depth() == 1 );
+    assert( &request(tag::context, "LID")->get() == &process(tag::context, "LID")->get() );
+
+    // Overlay values take priority and are not visible to the base
+    request << Subsystem("adc") << Context("LID", "FIINDEX:REQUEST");
+    assert( request(tag::service) == "pisvc" );
+    assert( request(tag::subsystem) == "adc" );
+    assert( request(tag::context, "LID")->get() == "FIINDEX:REQUEST" );
+    assert( request(tag::context, "DFPATH")->get() == "anton-test.1" );
+    assert( process(tag::subsystem) == std::nullopt );
+    assert( process(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+
+    // Deriving from a dirty overlay freezes it into a new shared layer
+    Layered nested = request.derive();
+    assert( nested.depth() == 2 );
+    assert( &nested(tag::context, "DFPATH")->get() == &process(tag::context, "DFPATH")->get() );
+    nested << Service("integsvc");
+    assert( nested(tag::service) == "integsvc" );
+    assert( request(tag::service) == "pisvc" );
+
+    Coll flat = nested.collection();
+    assert( flat(tag::service) == "integsvc" );
+    assert( flat(tag::subsystem) == "adc" );
+    assert( flat(tag::context, "LID")->get() == "FIINDEX:REQUEST" );
+    assert( flat(tag::context).size() == 2 );
+
+    assert( !Layered {} );
+}
+
+
+void test_published()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::pwho_t, false>,
+        attr::Single<tag::label_t, false>
+    >;
+
+    Coll initial;
+    initial << Service("pisvc") << Pwho(0) << Label(0);
+
+    attr::Published<Coll> published {initial};
+    attr::Published<Coll>::Reader reader {published};
+    assert( (*reader)(tag::service) == "pisvc" );
+
+    // Snapshots stay immutable for their holders
+    auto snapshot = published.load();
+    published.update([](Coll &next) { next << Service("integsvc"); });
+    assert( (*snapshot)(tag::service) == "pisvc" );
+    assert( (*reader)(tag::service) == "integsvc" );
+    assert( published.version() == 1 );
+
+    // Readers always observe consistent snapshots
+    constexpr uint32_t updates = 1000;
+
+    std::vector<std::thread> readers;
+    for (size_t idx = 0; idx < 4; ++idx)
+    {
+        readers.emplace_back([&] {
+            attr::Published<Coll>::Reader reader {published};
+            for (uint32_t last = 0; last < updates;)
+            {
+                const Coll &current = reader.get();
+                assert( current(tag::pwho) == current(tag::label) );
+                assert( *current(tag::pwho) >= last );
+                last = *current(tag::pwho);
+            }
+        });
+    }
+
+    for (uint32_t idx = 1; idx <= updates; ++idx)
+    {
+        published.update([&](Coll &next) { next << Pwho(idx) << Label(idx); });
+    }
+
+    for (std::thread &thread : readers)
+    {
+        thread.join();
+    }
+
+    assert( published.version() == updates + 1 );
+}
+
+
+void test_batch()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+    using Batch = attr::CollectionBatch<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    Batch batch;
+    batch.reserve(100);
+
+    for (uint32_t idx = 0; idx < 100; ++idx)
+    {
+        Coll coll;
+        coll << Context("LID", "FIINDEX:LUATTRUU");
+        if (idx % 3)
+        {
+            coll << Service("pisvc");
+        }
+        if (idx % 2)
+        {
+            coll << Label(idx % 5);
+        }
+        batch.push_back(std::move(coll));
+    }
+
+    assert( batch.size() == 100 );
+
+    // Row views behave like collections
+    assert( !batch[0] );
+    assert( batch[0](tag::service) == std::nullopt );
+    assert( batch[1] );
+    assert( batch[1](tag::service)->get() == "pisvc" );
+    assert( batch[1](tag::label)->get() == 1 );
+    assert( batch[99](tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+    assert( batch[99](tag::context).size() == 1 );
+
+    Coll row = batch[7].collection();
+    assert( row(tag::service) == "pisvc" );
+    assert( row(tag::label) == 2u );
+    assert( row(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+
+    // Columns are contiguous and carry presence bitmaps
+    attr::Column<uint32_t> labels = batch.column(tag::label);
+    assert( labels.size() == 100 );
+    assert( labels.data() + 1 == &labels[1] );
+
+    size_t counts[5] = {};
+    for (size_t idx = 0; idx < labels.size(); ++idx)
+    {
+        if (labels.present(idx))
+        {
+            ++counts[labels[idx]];
+        }
+    }
+    assert( counts[0] + counts[1] + counts[2] + counts[3] + counts[4] == 50 );
+    assert( counts[1] == 10 );
+    assert( labels.bitmap()[0] == 0xAAAAAAAAAAAAAAAAull );
+
+    batch.clear();
+    assert( batch.empty() );
+}
+
+
+void test_filter()
+{
+    using Batch = attr::CollectionBatch<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::pwho_t, true>,
+        attr::Single<tag::label_t, false>
+    >;
+
+    Batch batch;
+    for (uint32_t idx = 0; idx < 1000; ++idx)
+    {
+        attr::Collection<
+            attr::Single<tag::service_t, true>,
+            attr::Single<tag::pwho_t, true>,
+            attr::Single<tag::label_t, false>
+        > coll;
+
+        coll << Service("pisvc") << Pwho(idx % 7);
+        if (idx % 4)
+        {
+            coll << Label(idx % 10);
+        }
+        batch.push_back(std::move(coll));
+    }
+
+    // Filters match row-by-row evaluation, unset values never match value predicates
+    auto expect = [&](auto &&matches) {
+        attr::Selection expected {batch.size()};
+        for (size_t row = 0; row < batch.size(); ++row)
+        {
+            if (matches(batch[row]))
+            {
+                expected.words()[row / 64] |= uint64_t(1) << (row % 64);
+            }
+        }
+        return expected;
+    };
+
+    auto same = [](const attr::Selection &lhs, const attr::Selection &rhs) {
+        for (size_t row = 0; row < lhs.size(); ++row)
+        {
+            if (lhs.test(row) != rhs.test(row))
+            {
+                return false;
+            }
+        }
+        return lhs.size() == rhs.size() && lhs.count() == rhs.count();
+    };
+
+    attr::Selection pwho = attr::select(batch, attr::filter::equal(tag::pwho, 3));
+    assert( same(pwho, expect([](auto row) { return row(tag::pwho)->get() == 3; })) );
+
+    attr::Selection labels = attr::select(batch, attr::filter::in(tag::label, {1, 2, 9}));
+    assert( same(labels, expect([](auto row) {
+        auto label = row(tag::label);
+        return label && (label->get() == 1 || label->get() == 2 || label->get() == 9);
+    })) );
+
+    attr::Selection range = attr::select(batch, attr::filter::between(tag::label, 0, 4), attr::filter::equal(tag::pwho, 0));
+    assert( same(range, expect([](auto row) {
+        auto label = row(tag::label);
+        return label && label->get() <= 4 && row(tag::pwho)->get() == 0;
+    })) );
+    assert( same(range, attr::select(batch, attr::filter::equal(tag::pwho, 0))
+        & attr::select(batch, attr::filter::between(tag::label, 0, 4))) );
+
+    attr::Selection missing = attr::select(batch, attr::filter::missing(tag::label));
+    assert( missing.count() == 250 );
+    assert( (missing | attr::select(batch, attr::filter::present(tag::label))).count() == batch.size() );
+    assert( (~missing).count() == 750 );
+
+    size_t visited = 0;
+    missing.for_each([&](size_t row) {
+        assert( row % 4 == 0 );
+        ++visited;
+    });
+    assert( visited == 250 );
+}
+
+
+void test_query()
+{
+    using namespace attr::query;
+
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    const auto pisvc = tag::service == "pisvc" && has(tag::context, "LID");
+    const auto labels = (tag::label >= 3u && !(tag::label == 5u)) || !has(tag::label);
+
+    Coll coll;
+    assert( !pisvc(coll) );
+    assert( labels(coll) );
+
+    coll << Service("pisvc") << Label(5);
+    assert( !pisvc(coll) );
+    assert( !labels(coll) );
+
+    coll << Context("LID", "FIINDEX:LUATTRUU") << Label(7);
+    assert( pisvc(coll) );
+    assert( labels(coll) );
+    assert( (tag::service != "other")(coll) );
+    assert( !(tag::label < 7u)(coll) && (tag::label <= 7u)(coll) && !(tag::label > 7u)(coll) );
+
+    // The same expressions evaluate against batch rows and whole batches
+    attr::CollectionBatch<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    > batch;
+
+    for (uint32_t idx = 0; idx < 300; ++idx)
+    {
+        Coll row;
+        row << Service(idx % 3 ? "pisvc" : "other");
+        if (idx % 2)
+        {
+            row << Label(idx % 10);
+        }
+        if (idx % 5 == 0)
+        {
+            row << Context("LID", "FIINDEX:LUATTRUU");
+        }
+        batch.push_back(std::move(row));
+    }
+
+    auto check = [&](const auto &expression) {
+        const attr::Selection selection = expression.select(batch);
+        for (size_t row = 0; row < batch.size(); ++row)
+        {
+            assert( selection.test(row) == expression(batch[row]) );
+            assert( selection.test(row) == expression(batch[row].collection()) );
+        }
+        return selection.count();
+    };
+
+    assert( check(pisvc) == 40 );
+    assert( check(labels) > 0 );
+    assert( check(tag::label < 0u) == 0 );
+    assert( check(tag::label > 4294967295u) == 0 );
+    assert( check(tag::label != 1u) == 120 );
+    assert( check(tag::service == "other" || has(tag::context, "LID")) == 140 );
+}
+
+
+void test_any()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    Coll coll;
+    coll << Service("pisvc") << Label(42) << Context("LID", "FIINDEX:LUATTRUU");
+
+    // Type identities are compared by name, so copies of a name from another shared object match
+    constexpr attr::traits::TypeKey key = attr::traits::type_key<Coll>::value;
+    static_assert( key == attr::traits::type_key<Coll>::value );
+    static_assert( key != attr::traits::type_key<attr::traits::canonical_t<Coll>>::value );
+    const std::string name {key.name};
+    assert( (attr::traits::TypeKey {name, key.hash} == key) );
+
+    attr::AnyCollection any {coll};
+    assert( any.has_value() && any );
+    assert( std::get<std::string_view>(*any("service")) == "pisvc" );
+    assert( std::get<uint64_t>(*any("label")) == 42 );
+    assert( std::get<std::string_view>(*any("context", "LID")) == "FIINDEX:LUATTRUU" );
+    assert( !any("pwho") && !any("context") && !any("context", "DFPATH") && !any("service", "LID") );
+
+    size_t visited = 0;
+    any.for_each([&](const attr::AnyAttribute &attribute) {
+        assert( attribute.name != "context" || attribute.key == "LID" );
+        ++visited;
+    });
+    assert( visited == 3 );
+
+    // Conversion back requires the same holders, in any order
+    using Reordered = attr::Collection<
+        attr::Multiple<tag::context_t>,
+        attr::Single<tag::label_t, false>,
+        attr::Single<tag::service_t, true>
+    >;
+
+    assert( any.get_if<Coll>() && !any.get_if<Reordered>() );
+    assert( (*any.collection<Reordered>()->holder<attr::Single<tag::label_t, false>>() == 42u) );
+    assert( (!any.collection<attr::Collection<attr::Single<tag::service_t, true>>>()) );
+
+    attr::AnyCollection copy = any;
+    attr::AnyCollection moved = std::move(any);
+    assert( !any.has_value() && !any );
+    assert( std::get<std::string_view>(*copy("context", "LID")) == "FIINDEX:LUATTRUU" );
+
+    std::optional<Coll> back = std::move(moved).collection<Coll>();
+    assert( back && (*back)(tag::context, "LID") );
+
+    // Collections larger than the inline storage are allocated on the heap
+    attr::BasicAnyCollection<8> small {coll};
+    attr::BasicAnyCollection<8> small_copy = small;
+    small = std::move(small_copy);
+    assert( std::get<uint64_t>(*small("label")) == 42 );
+    assert( std::move(small).collection<Reordered>() );
+}
+
+
+void test_merge()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    Coll session;
+    session << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+
+    Coll request;
+    request << Service("other") << Label(42) << Context("LID", "FIINDEX:OTHER") << Context("HOST", "localhost");
+
+    // Copies keep the source intact, unset values are always taken
+    Coll left = session;
+    left.merge(request, attr::KeepLeft {});
+    assert( left(tag::service) == "pisvc" && left(tag::label) == 42u );
+    assert( left(tag::context).size() == 3 );
+    assert( left(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+    assert( request(tag::context).size() == 2 );
+
+    Coll right = session;
+    right.merge(request);
+    assert( right(tag::service) == "other" );
+    assert( right(tag::context, "LID")->get() == "FIINDEX:OTHER" );
+    assert( right(tag::context, "HOST")->get() == "localhost" );
+
+    Coll joined = session;
+    joined.merge(request, [](auto &current, const auto &incoming) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(current)>, std::string>)
+        {
+            current += "+" + incoming;
+        }
+    });
+    assert( joined(tag::context, "LID")->get() == "FIINDEX:LUATTRUU+FIINDEX:OTHER" );
+    assert( joined(tag::context, "DFPATH")->get() == "anton-test.1" );
+
+    // Moves splice hash map nodes, so merged values stay in place
+    const std::string *host = &request(tag::context, "HOST")->get();
+    Coll spliced = session;
+    spliced.merge(std::move(request));
+    assert( &spliced(tag::context, "HOST")->get() == host );
+    assert( spliced(tag::context, "LID")->get() == "FIINDEX:OTHER" );
+    assert( spliced(tag::context).size() == 3 );
+
+    // Holders missing from the source are kept; self-merge is a no-op
+    attr::Collection<attr::Single<tag::label_t, false>> labels;
+    labels << Label(7);
+    spliced.merge(labels).merge(spliced);
+    assert( spliced(tag::label) == 7u && spliced(tag::service) == "other" );
+
+    // Flat storage merges by moving entries
+    using Flat = attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Flat<2>>;
+    Flat flat, other;
+    flat = Context("LID", "FIINDEX:LUATTRUU");
+    other = Context("LID", "FIINDEX:OTHER");
+    other = Context("HOST", "localhost");
+    flat.merge(std::move(other), attr::KeepLeft {});
+    assert( (*flat).size() == 2 && flat("LID")->get() == "FIINDEX:LUATTRUU" && flat("HOST") );
+
+    // Assignment from a different collection type returns self
+    attr::Collection<attr::Single<tag::label_t, false>> assigned;
+    assert( &(assigned = session) == &assigned );
+}
+
+
+void test_interned()
+{
+    using Svc = attr::Interned<>;
+
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true, Svc>,
+        attr::Single<tag::label_t, false>
+    >;
+
+    Coll coll;
+    coll << attr::Value<tag::service_t, Svc>("pisvc");
+
+    // Values are interned once and read back as strings
+    const Svc &service = *coll(tag::service);
+    assert( service.view() == "pisvc" );
+    assert( std::string_view(service) == "pisvc" );
+    assert( service == Svc("pisvc") && service != Svc("other") );
+    assert( std::hash<Svc> {}(service) == service.id() );
+    assert( attr::SymbolTable::global().find("pisvc")->id() == service.id() );
+
+    // Queries compare interned constants by identity
+    {
+        using namespace attr::query;
+        assert( (tag::service == Svc("pisvc"))(coll) );
+        assert( (tag::service != Svc("other"))(coll) );
+        assert( (tag::service == "pisvc")(coll) );
+    }
+
+    // Columnar filters match symbols, wide SIMD kernels are used where available
+    attr::CollectionBatch<attr::Single<tag::service_t, true, Svc>, attr::Single<tag::label_t, false>> batch;
+    for (uint32_t idx = 0; idx < 203; ++idx)
+    {
+        Coll row;
+        row << attr::Value<tag::service_t, Svc>(idx % 3 == 0 ? "pisvc" : idx % 3 == 1 ? "other" : "third");
+        batch.push_back(std::move(row));
+    }
+
+    const attr::Selection pisvc = attr::select(batch, attr::filter::equal(tag::service, "pisvc"));
+    assert( pisvc.count() == 68 );
+    pisvc.for_each([](size_t row) { assert( row % 3 == 0 ); });
+
+    assert( attr::select(batch, attr::filter::in(tag::service, {"other", "third"})).count() == 135 );
+    assert( attr::select(batch, attr::filter::equal(tag::service, "missing")).count() == 0 );
+
+    // Query constants are looked up without interning them
+    const size_t symbols = Svc::table().size();
+    assert( attr::select(batch, attr::filter::equal(tag::service, "never-interned")).count() == 0 );
+    assert( attr::select(batch, attr::filter::in(tag::service, {"other", "never-interned-either"})).count() == 68 );
+    assert( attr::select(batch, attr::filter::in(tag::service, {"never-interned"})).count() == 0 );
+    assert( Svc::table().size() == symbols && !Svc::table().find("never-interned") );
+
+    {
+        using namespace attr::query;
+        assert( (tag::service == Svc("other")).select(batch).count() == 68 );
+        assert( (tag::service != Svc("other")).select(batch).count() == 135 );
+    }
+
+    // Wide kernels also cover 64-bit integers
+    const int64_t wide[] = {1, 2, 3, 1, 5, 1, 7};
+    uint64_t bits = 0;
+    const int64_t ones[] = {1};
+    attr::filter::select_any(wide, 7, ones, 1, &bits);
+    assert( bits == 0b0101001 );
+}
+
+
+void test_fingerprint()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    // Hashes do not depend on insertion order of named values
+    Coll lhs, rhs;
+    lhs << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+    rhs << Context("DFPATH", "anton-test.1") << Context("LID", "FIINDEX:LUATTRUU") << Service("pisvc");
+    assert( attr::hash(lhs) == attr::hash(rhs) );
+    assert( std::hash<Coll> {}(lhs) == attr::hash(lhs) );
+
+    // Values of different attributes are seeded differently
+    attr::Collection<attr::Single<tag::service_t, false>, attr::Single<tag::id_t, false>> service, id;
+    service << Service("pisvc");
+    id << Id("pisvc");
+    assert( attr::hash(service) != attr::hash(id) );
+    assert( attr::hash(Coll {}) == 0 );
+
+    // Memoized hashes are updated incrementally and match full rehashing
+    attr::Fingerprinted<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    > fingerprinted;
+    assert( fingerprinted.fingerprint() == 0 );
+
+    fingerprinted << Service("other") << Context("LID", "FIINDEX:OTHER");
+    fingerprinted << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+    assert( fingerprinted.fingerprint() == attr::hash(lhs) );
+    assert( fingerprinted.fingerprint() == attr::hash(fingerprinted.collection()) );
+    assert( fingerprinted && fingerprinted(tag::service) == "pisvc" );
+    assert( fingerprinted(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+
+    fingerprinted << Label(42);
+    assert( fingerprinted.fingerprint() != attr::hash(lhs) );
+    assert( fingerprinted.fingerprint() == attr::hash(fingerprinted.collection()) );
+
+    decltype(fingerprinted) copy {fingerprinted.collection()};
+    assert( std::hash<decltype(copy)> {}(copy) == fingerprinted.fingerprint() );
+}
+
+
+void test_delta()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    Coll from, to;
+    from << Service("pisvc") << Label(42) << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.1");
+    to << Service("integsvc") << Context("LID", "FIINDEX:LUATTRUU") << Context("DFPATH", "anton-test.2") << Context("PID", "1234");
+
+    // Changed, removed and per-name changes
+    auto delta = attr::diff(from, to);
+    assert( !delta.empty() );
+    assert( delta.change(tag::service) == attr::Change::changed );
+    assert( delta.change(tag::label) == attr::Change::removed && delta.removed(tag::label) );
+    assert( delta.change(tag::context) == attr::Change::changed );
+    assert( delta.values()(tag::service) == "integsvc" );
+    assert( !delta.values()(tag::context, "LID") );
+    assert( delta.values()(tag::context, "DFPATH")->get() == "anton-test.2" );
+    assert( delta.values()(tag::context, "PID")->get() == "1234" );
+    assert( delta.removed(tag::context).empty() );
+
+    Coll applied = from;
+    delta.apply(applied);
+    assert( attr::hash(applied) == attr::hash(to) && !applied(tag::label) );
+
+    // Added values and removed names
+    auto reverse = attr::diff(to, from);
+    assert( reverse.change(tag::label) == attr::Change::added );
+    assert( reverse.removed(tag::context).size() == 1 && std::string_view(reverse.removed(tag::context)[0]) == "PID" );
+    reverse.apply(applied);
+    assert( attr::hash(applied) == attr::hash(from) && !applied(tag::context, "PID") );
+    assert( attr::diff(from, applied).empty() );
+
+    // Holders missing from the source are treated as unset
+    attr::Collection<attr::Single<tag::service_t, true>> partial;
+    partial << Service("integsvc");
+    auto extension = attr::diff(partial, to);
+    assert( extension.change(tag::service) == attr::Change::none );
+    assert( extension.change(tag::label) == attr::Change::none );
+    assert( extension.change(tag::context) == attr::Change::added );
+
+    // Streams send only changes against the previous collection
+    attr::DeltaEncoder<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    > encoder;
+    attr::DeltaDecoder<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    > decoder;
+
+    std::string frame;
+    encoder.encode(from, frame);
+    assert( decoder.decode(frame) );
+    assert( attr::hash(decoder.collection()) == attr::hash(from) );
+    assert( attr::hash(encoder.reference()) == attr::hash(from) );
+
+    Coll next = from;
+    next << Label(43);
+    frame.clear();
+    encoder.encode(next, frame);
+    assert( frame.size() < attr::encode(next).size() / 4 );
+    assert( decoder.decode(frame) && decoder.collection()(tag::label) == 43u );
+
+    frame.clear();
+    encoder.encode(to, frame);
+    assert( decoder.decode(frame) );
+    assert( attr::hash(decoder.collection()) == attr::hash(to) );
+    assert( decoder.collection()(tag::context, "DFPATH")->get() == "anton-test.2" );
+
+    frame.clear();
+    encoder.encode(to, frame);
+    assert( frame.size() == sizeof(uint32_t) && decoder.decode(frame) );
+
+    // Malformed frames leave the collection unchanged
+    frame.clear();
+    encoder.encode(from, frame);
+    assert( !decoder.decode(std::string_view(frame).substr(0, frame.size() - 1)) );
+    assert( attr::hash(decoder.collection()) == attr::hash(to) );
+    assert( decoder.decode(frame) && attr::hash(decoder.collection()) == attr::hash(from) );
+}
+
+
+void test_store()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+    using Writer = attr::StoreWriter<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+    using Reader = attr::StoreReader<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    const std::string path = "/tmp/porter_attr_store_" + std::to_string(::getpid());
+    std::remove(path.c_str());
+
+    assert( !Reader::open(path) );
+
+    auto writer = Writer::open(path);
+    assert( writer && writer->size() == attr::Segment::header_size );
+
+    // A segment has a single writer at a time
+    assert( !Writer::open(path) );
+
+    auto reader = Reader::open(path);
+    assert( reader && reader->offsets().empty() );
+
+    Coll first;
+    first << Service("pisvc") << Label(42) << Context("LID", "FIINDEX:LUATTRUU");
+    Coll second;
+    second << Service("integsvc") << Label(42) << Context("LID", "FIINDEX:OTHER");
+
+    const auto a = writer->append(first);
+    const auto b = writer->append(second);
+    assert( a && b && *a == attr::Segment::header_size && *b > *a );
+
+    // Readers pick up committed records and index them
+    assert( reader->refresh() == 2 && reader->refresh() == 0 );
+    assert( reader->offsets() == Reader::offsets_type({*a, *b}) );
+    assert( reader->find(tag::service, "pisvc") == Reader::offsets_type({*a}) );
+    assert( reader->find(tag::label, 42) == Reader::offsets_type({*a, *b}) );
+    assert( reader->find(tag::label, 43).empty() );
+    assert( reader->find(tag::context, "LID", "FIINDEX:OTHER") == Reader::offsets_type({*b}) );
+    assert( reader->find(tag::context, "DFPATH", "FIINDEX:OTHER").empty() );
+
+    auto view = reader->view(*b);
+    assert( view && (*view)(tag::service) == "integsvc" );
+    assert( (*view)(tag::context, "LID") == "FIINDEX:OTHER" );
+    assert( !reader->view(*a + 1) );
+
+    // Segments grow past the preallocated size
+    Coll large;
+    large << Service(std::string_view {path}) << Context("PAYLOAD", std::string(attr::Segment::initial_size, 'x'));
+    const auto c = writer->append(large);
+    assert( c && writer->size() > attr::Segment::initial_size );
+    assert( writer->sync() );
+
+    assert( reader->refresh() == 1 );
+    assert( reader->find(tag::service, path) == Reader::offsets_type({*c}) );
+    assert( reader->view(*c)->collection()(tag::context, "PAYLOAD")->get().size() == attr::Segment::initial_size );
+
+    size_t records = 0;
+    reader->for_each([&](uint64_t offset, const auto &record) {
+        assert( offset == reader->offsets()[records++] && record );
+    });
+    assert( records == 3 );
+
+    // Reopened segments keep their records
+    writer.reset();
+    writer = Writer::open(path);
+    const auto d = writer->append(first);
+    auto reopened = Reader::open(path);
+    assert( d && reopened->offsets().size() == 4 );
+    assert( reopened->find(tag::service, "pisvc") == Reader::offsets_type({*a, *d}) );
+
+    std::remove(path.c_str());
+}
+
+
+void test_aggregate()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    constexpr std::string_view services[] = {"pisvc", "integsvc", "adc"};
+    constexpr std::string_view keys[] = {"LID", "DFPATH", "HOST", "PID"};
+
+    std::vector<Coll> rows(10000);
+    attr::CollectionBatch<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, false>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    > batch;
+
+    for (size_t idx = 0; idx < rows.size(); ++idx)
+    {
+        rows[idx] << Service(services[idx % 3]) << Context(keys[idx % 4], "x") << Context("LID", "y");
+        if (idx % 2)
+        {
+            rows[idx] << Subsystem("adc") << Label(uint32_t(idx % 10));
+        }
+
+        batch.push_back(rows[idx]);
+    }
+
+    const attr::aggregate::Options parallel {4, 64};
+    const attr::aggregate::Options serial {1, 64};
+
+    // Whole-range aggregates match regardless of partitioning
+    assert( attr::aggregate::total(rows, attr::aggregate::Count {}, parallel).value == rows.size() );
+    const auto sum = attr::aggregate::total(rows, attr::aggregate::Sum<tag::label_t> {}, parallel);
+    assert( sum.value == attr::aggregate::total(rows, attr::aggregate::Sum<tag::label_t> {}, serial).value );
+    assert( sum.value == 5000 / 5 * (1 + 3 + 5 + 7 + 9) );
+    assert( attr::aggregate::total(batch, attr::aggregate::Distinct<tag::label_t> {}, parallel).size() == 5 );
+
+    // Group by one and several attributes, rows without a value are grouped under std::nullopt
+    auto by_service = attr::aggregate::group_by(rows, attr::aggregate::Count {}, parallel, tag::service);
+    assert( by_service.size() == 3 );
+    assert( (by_service[{std::string_view("pisvc")}].value == 3334) );
+
+    auto by_both = attr::aggregate::group_by(batch, attr::aggregate::Sum<tag::label_t> {}, parallel, tag::service, tag::subsystem);
+    assert( by_both.size() == 6 );
+    assert( (by_both[{std::string_view("adc"), std::nullopt}].value == 0) );
+    auto by_both_serial = attr::aggregate::group_by(rows, attr::aggregate::Sum<tag::label_t> {}, serial, tag::service, tag::subsystem);
+    for (const auto &[key, group] : by_both)
+    {
+        assert( by_both_serial.at(key).value == group.value );
+    }
+
+    uint64_t grouped = 0;
+    for (const auto &[key, group] : attr::aggregate::group_by(rows, attr::aggregate::Count {}, tag::service, tag::label))
+    {
+        grouped += group.value;
+    }
+    assert( grouped == rows.size() );
+
+    // Top names of associative attributes
+    const auto top = attr::aggregate::top_keys(batch, tag::context, 2, parallel);
+    assert( top.size() == 2 );
+    assert( top[0] == std::make_pair(std::string_view("LID"), uint64_t(rows.size())) );
+    assert( top[1] == std::make_pair(std::string_view("DFPATH"), uint64_t(2500)) );
+    assert( attr::aggregate::top_keys(rows, tag::context, 10, serial).size() == 4 );
+}
+
+
+using AsyncContext = attr::AsyncScope<
+    attr::Single<tag::service_t, true>,
+    attr::Single<tag::label_t, false>,
+    attr::Multiple<tag::context_t>
+>;
+
+/// Runs posted functions on a separate thread.
+struct ThreadExecutor
+{
+    void post(std::function<void()> func) { std::thread(std::move(func)).join(); }
+};
+
+#if __cpp_impl_coroutine
+
+/// Defines an eager coroutine with attribute context propagation.
+struct AsyncTask
+{
+    struct promise_type : attr::PropagatingPromise<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>>
+    {
+        AsyncTask get_return_object() { return {}; }
+        auto initial_suspend() { return start(std::suspend_never {}); }
+        auto final_suspend() noexcept { return finish(std::suspend_never {}); }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/// Defines a lazy coroutine with attribute context propagation, started and destroyed by its owner.
+struct LazyTask
+{
+    struct promise_type : attr::PropagatingPromise<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>>
+    {
+        LazyTask get_return_object() { return {std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        auto initial_suspend() { return start(std::suspend_always {}); }
+        auto final_suspend() noexcept { return finish(std::suspend_always {}); }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+/// Suspends the awaiting coroutine, to be resumed by its owner.
+struct Pause
+{
+    bool await_ready() { return false; }
+    void await_suspend(std::coroutine_handle<>) {}
+    void await_resume() {}
+};
+
+LazyTask deferred(std::optional<uint32_t> &label, bool complete)
+{
+    label = AsyncContext::get(tag::label);
+    if (!complete)
+    {
+        co_await Pause {};
+    }
+}
+
+/// Resumes the awaiting coroutine on a separate thread, checking what context that thread is left with.
+struct ThreadHop
+{
+    bool *left_clean;
+
+    bool await_ready() { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        std::thread([left_clean = left_clean, handle] {
+            handle.resume();
+            *left_clean = !AsyncContext::get(tag::service) && !AsyncContext::get(tag::label);
+        }).join();
+    }
+
+    void await_resume() {}
+};
+
+AsyncTask hop(
+    std::optional<std::string_view> &service,
+    std::optional<uint32_t> &label,
+    std::optional<std::string> &lid,
+    bool &left_clean)
+{
+    AsyncContext frame {Label(7)};
+
+    co_await ThreadHop {&left_clean};
+    service = AsyncContext::get(tag::service);
+    label = AsyncContext::get(tag::label);
+
+    co_await ThreadHop {&left_clean};
+    if (auto value = AsyncContext::get(tag::context, "LID"))
+    {
+        lid = value->get();
+    }
+}
+
+#endif
+
+void test_async()
+{
+    assert( !AsyncContext::get(tag::service) );
+
+    {
+        AsyncContext outer {Service("pisvc"), Context("LID", "FIINDEX:LUATTRUU")};
+        assert( AsyncContext::get(tag::service) == "pisvc" );
+        assert( AsyncContext::capture().depth() == 1 );
+
+        {
+            AsyncContext inner {Label(42)};
+            assert( AsyncContext::get(tag::label) == 42u && AsyncContext::get(tag::service) == "pisvc" );
+            assert( AsyncContext::collection()(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+        }
+        assert( !AsyncContext::get(tag::label) );
+
+        // Captured contexts share layers and are installed on other threads
+        auto captured = AsyncContext::capture();
+        std::optional<std::string_view> service;
+        std::thread([&] {
+            assert( !AsyncContext::get(tag::service) );
+            AsyncContext installed {captured};
+            service = AsyncContext::get(tag::service);
+        }).join();
+        assert( service == "pisvc" );
+
+        // Executors run posted functions in the context they were posted from
+        attr::PropagatingExecutor<
+            ThreadExecutor,
+            attr::Single<tag::service_t, true>,
+            attr::Single<tag::label_t, false>,
+            attr::Multiple<tag::context_t>
+        > executor {ThreadExecutor {}};
+
+        std::optional<uint32_t> label;
+        {
+            AsyncContext inner {Label(43)};
+            executor.post([&] { label = AsyncContext::get(tag::label); });
+        }
+        assert( label == 43u );
+
+#if __cpp_impl_coroutine
+        // Coroutines keep their context over thread hops, leaving resuming threads' context intact
+        std::optional<std::string> lid;
+        std::optional<uint32_t> service_label;
+        service.reset();
+        label.reset();
+        bool left_clean = false;
+
+        hop(service, label, lid, left_clean);
+        assert( service == "pisvc" && label == 7u && lid == "FIINDEX:LUATTRUU" );
+        assert( left_clean );
+        assert( AsyncContext::get(tag::service) == "pisvc" && !AsyncContext::get(tag::label) );
+
+        // Lazy coroutines start in the context they're created in, wherever they're resumed or destroyed
+        LazyTask suspended;
+        LazyTask completed;
+        {
+            AsyncContext created {Label(7)};
+            suspended = deferred(label, false);
+            completed = deferred(service_label, true);
+        }
+        assert( !AsyncContext::get(tag::label) );
+
+        label.reset();
+        suspended.handle.resume();
+        assert( label == 7u && !AsyncContext::get(tag::label) );
+
+        completed.handle.resume();
+        assert( completed.handle.done() && service_label == 7u && !AsyncContext::get(tag::label) );
+
+        suspended.handle.destroy();
+        completed.handle.destroy();
+        assert( AsyncContext::get(tag::service) == "pisvc" && !AsyncContext::get(tag::label) );
+#endif
+    }
+
+    assert( !AsyncContext::get(tag::service) && AsyncContext::capture().depth() == 0 );
+}
+
+
+void test_lazy()
+{
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, true, attr::Lazy<std::string>>,
+        attr::Single<tag::label_t, false, attr::Lazy<uint32_t>>,
+        attr::Multiple<tag::context_t, attr::Lazy<std::string>>
+    >;
+    using Subsystem = attr::Value<tag::subsystem_t, attr::Lazy<std::string>>;
+    using LazyLabel = attr::Value<tag::label_t, attr::Lazy<uint32_t>>;
+    using LazyContext = attr::KeyValue<tag::context_t, std::pair<std::string_view, attr::Lazy<std::string>>>;
+
+    size_t calls = 0;
+    auto host = [&calls] { ++calls; return std::string("localhost"); };
+
+    Coll coll;
+    coll << Service("pisvc") << Subsystem(host) << LazyLabel(42u) << LazyContext("HOST", host);
+
+    // Pending values count as set and are not forced by readiness checks
+    assert( coll && calls == 0 );
+    assert( coll(tag::subsystem)->pending() && !coll(tag::label)->pending() );
+
+    // Values are computed once, on first read
+    assert( coll(tag::subsystem) == "localhost" && calls == 1 );
+    assert( coll(tag::subsystem)->get() == "localhost" && calls == 1 );
+    assert( coll(tag::context, "HOST")->get() == "localhost" && calls == 2 );
+    assert( !coll(tag::subsystem)->pending() && coll(tag::label) == 42u );
+
+    // Formatting and serialization force pending values
+    Coll copy;
+    copy << Service("pisvc") << Subsystem(host) << LazyContext("HOST", host);
+    char buffer[128];
+    const auto formatted = attr::format(std::begin(buffer), std::end(buffer), copy);
+    assert( std::string_view(buffer, formatted.ptr - buffer) == "service=pisvc subsystem=localhost context.HOST=localhost" );
+    assert( calls == 4 );
+
+    copy << Subsystem([&calls] { ++calls; return std::string("remotehost"); });
+    const std::string encoded = attr::encode(copy);
+    assert( calls == 5 );
+
+    auto view = attr::CollectionView<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::subsystem_t, true, attr::Lazy<std::string>>,
+        attr::Single<tag::label_t, false, attr::Lazy<uint32_t>>,
+        attr::Multiple<tag::context_t, attr::Lazy<std::string>>
+    >::parse(encoded);
+    assert( view && (*view)(tag::subsystem) == "remotehost" );
+    assert( view->collection()(tag::context, "HOST")->get() == "localhost" );
+
+    // A throwing computation leaves the value pending and is retried on the next read
+    size_t attempts = 0;
+    Coll flaky;
+    flaky << Service("pisvc") << Subsystem([&attempts] {
+        if (++attempts == 1)
+        {
+            throw std::runtime_error("unavailable");
+        }
+        return std::string("localhost");
+    });
+
+    bool thrown = false;
+    try
+    {
+        flaky(tag::subsystem)->get();
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert( thrown && flaky(tag::subsystem)->pending() && attempts == 1 );
+    assert( flaky(tag::subsystem) == "localhost" && attempts == 2 && !flaky(tag::subsystem)->pending() );
+
+    // Hashes are computed from values
+    Coll eager;
+    eager << Service("pisvc") << Subsystem(std::string("remotehost")) << LazyContext("HOST", std::string("localhost"));
+    assert( attr::hash(eager) == attr::hash(copy) && calls == 5 );
+}
+
+
+using Defaults = attr::Collection<
+    attr::Single<tag::service_t, true>,
+    attr::Single<tag::subsystem_t, true>,
+    attr::Single<tag::label_t, false>
+>;
+
+/// Process-level defaults, constant-initialized.
+constexpr Defaults make_defaults()
+{
+    Defaults defaults;
+    defaults << Service("pisvc") << Subsystem("adc");
+    return defaults;
+}
+
+#if __cpp_constinit
+constinit Defaults g_defaults = make_defaults();
+#else
+Defaults g_defaults = make_defaults();
+#endif
+
+
+void test_constexpr()
+{
+    // Single-only collections are built and read at compile time
+    constexpr Defaults defaults = make_defaults();
+    static_assert( defaults );
+    static_assert( defaults(tag::service) == "pisvc" );
+    static_assert( defaults(tag::subsystem) == "adc" );
+    static_assert( !defaults(tag::label) );
+
+    constexpr auto extended = Defaults {defaults}.extend(Label(42), Pwho(1234));
+    static_assert( extended(tag::label) == 42u && extended(tag::pwho) == 1234u );
+    static_assert( extended(tag::service) == "pisvc" );
+
+    constexpr auto sum = Service("pisvc") + Subsystem("adc") + Label(42);
+    static_assert( sum && sum(tag::label) == 42u );
+
+    constexpr auto materialized = (Service("integsvc") + Label(7)).collection();
+    static_assert( materialized(tag::service) == "integsvc" && materialized(tag::label) == 7u );
+
+    constexpr attr::Collection<attr::Single<tag::service_t, true>> narrowed {defaults};
+    static_assert( narrowed(tag::service) == "pisvc" );
+
+    // Constant-initialized defaults behave like any other collection at runtime
+    assert( g_defaults(tag::service) == "pisvc" );
+    g_defaults << Label(4242);
+    assert( g_defaults(tag::label) == 4242u );
+}
+
+
+void test_instrument()
+{
+    using attr::instrument::Event;
+
+    using Coll = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>,
+        attr::Multiple<tag::context_t>
+    >;
+    using Narrow = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t>
+    >;
+
+    // Recording is constexpr in both builds, disabled measurements are empty
+    static_assert( [] {
+        attr::instrument::record(Event::conversion);
+        attr::instrument::record<tag::service_t>(Event::assignment, 2);
+        return attr::instrument::measure(std::array<int, 2> {}).size == (attr::instrument::enabled ? 2 : 0);
+    }() );
+
+    // Disabled counters record nothing
+    if constexpr (!attr::instrument::enabled)
+    {
+        Coll coll;
+        coll << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU");
+        Narrow narrow {coll};
+        assert( narrow(tag::service) == "pisvc" );
+
+        auto snapshot = attr::instrument::snapshot();
+        assert( snapshot.tags.empty() && snapshot[Event::assignment] == 0 && snapshot[Event::conversion] == 0 );
+        return;
+    }
+
+    attr::instrument::reset();
+
+    // Assignments are counted per tag, Multiple storage growth is counted on insertion
+    Coll coll;
+    coll << Service("pisvc") << Service("integsvc") << Label(42);
+    coll << Context("LID", "FIINDEX:LUATTRUU") << Context("LID", "FIINDEX:OVERRIDE");
+
+    auto snapshot = attr::instrument::snapshot();
+    assert( snapshot.find("service") && (*snapshot.find("service"))[Event::assignment] == 2 );
+    assert( (*snapshot.find("label"))[Event::assignment] == 1 );
+    assert( (*snapshot.find("context"))[Event::assignment] == 2 );
+    assert( (*snapshot.find("context"))[Event::allocation] == 1 );
+    assert( (*snapshot.find("context"))[Event::rehash] >= 1 );
+    assert( !snapshot.find("pwho") && snapshot[Event::conversion] == 0 );
+
+    // Conversions count copied and moved holders
+    Narrow narrow {coll};
+    Narrow moved {std::move(coll)};
+    auto extended = std::move(moved).extend(Pwho(1234));
+
+    snapshot = attr::instrument::snapshot();
+    const auto &context = *snapshot.find("context");
+    assert( context[Event::copy] == 1 && context[Event::move] == 2 );
+    assert( context[Event::copied_bytes] > sizeof(attr::Multiple<tag::context_t>) );
+    assert( (*snapshot.find("service"))[Event::copy] == 1 );
+    assert( !snapshot.find("label") || (*snapshot.find("label"))[Event::copy] == 0 );
+    assert( snapshot[Event::conversion] == 3 && snapshot[Event::extension] == 1 );
+    assert( (*snapshot.find("pwho"))[Event::assignment] == 1 && extended(tag::pwho) == 1234 );
+
+    // Compile-time evaluation is not counted
+    constexpr auto defaults = (Service("pisvc") + Label(7)).collection();
+    static_assert( defaults(tag::label) == 7u );
+
+    attr::instrument::reset();
+    snapshot = attr::instrument::snapshot();
+    assert( snapshot.tags.empty() && snapshot[Event::assignment] == 0 );
+}
+
+
+void test_memory()
+{
+    using Static = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Single<tag::label_t, false>
+    >;
+    using Hashed = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t>
+    >;
+    using Flat = attr::Collection<
+        attr::Single<tag::service_t, true>,
+        attr::Multiple<tag::context_t, std::string, attr::storage::Flat<2>>
+    >;
+
+    // Collections without heap-owning holders have a compile-time size
+    static_assert( !Static::dynamic && Static::static_size == sizeof(attr::traits::layout_t<attr::Single<tag::service_t, true>, attr::Single<tag::label_t, false>>) );
+    static_assert( Hashed::dynamic && Hashed::static_size == 0 );
+    static_assert( !attr::Single<tag::label_t, false>::dynamic && attr::Single<tag::context_t, true>::dynamic );
+
+    Static fixed;
+    fixed << Service("pisvc") << Label(42);
+    assert( fixed.memory_usage().inline_bytes == Static::static_size && fixed.memory_usage().heap_bytes == 0 );
+
+    // String heap buffers are counted past the small string buffer
+    const std::string large(256, 'x');
+    attr::Single<tag::context_t, true> single;
+    assert( single.memory_usage().heap_bytes == 0 );
+    single = attr::Value<tag::context_t> {std::string("short")};
+    assert( single.memory_usage().heap_bytes == 0 );
+    single = attr::Value<tag::context_t> {large};
+    assert( single.memory_usage().heap_bytes > large.size() );
+    assert( single.memory_usage().inline_bytes == sizeof(single) );
+
+    // Hash maps own buckets and nodes, flat maps own nothing until they spill
+    Hashed hashed;
+    Flat flat;
+    hashed << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU");
+    flat << Service("pisvc") << Context("LID", "FIINDEX");
+    assert( hashed.memory_usage().heap_bytes >= sizeof(std::pair<const attr::Key, std::string>) );
+    assert( flat.memory_usage().heap_bytes == 0 );
+    assert( flat.memory_usage().inline_bytes == sizeof(attr::traits::layout_t<attr::Single<tag::service_t, true>, attr::Multiple<tag::context_t, std::string, attr::storage::Flat<2>>>) );
+
+    flat << Context("DFPATH", "anton-test.1") << Context("HOST", large);
+    const auto spilled = flat.memory_usage();
+    assert( spilled.heap_bytes > 4 * sizeof(std::pair<std::string_view, std::string>) + large.size() );
+    assert( spilled.total() == spilled.inline_bytes + spilled.heap_bytes );
+
+    // KeyValue payload heap memory is counted per entry
+    const auto before = hashed.memory_usage().heap_bytes;
+    hashed << Context("HOST", large);
+    assert( hashed.memory_usage().heap_bytes >= before + large.size() );
+}
+
+
+/// Defines fixed context names for schema storage.
+struct ContextKeys
+{
+    static constexpr std::string_view values[] = {"LID", "DFPATH", "HOST"};
+};
+
+
+void test_schema()
+{
+    using namespace attr::literals;
+    using Schema = attr::Schema<ContextKeys>;
+    using Fixed = attr::Multiple<tag::context_t, tag::context_t::type, attr::storage::Fixed<ContextKeys>>;
+
+    // Names are resolved by a perfect hash, constant keys at compile time
+    static_assert( Schema::index("LID"_akey) == 0 && Schema::index("DFPATH"_akey) == 1 && Schema::index("HOST"_akey) == 2 );
+    static_assert( Schema::index("NONE"_akey) == Schema::npos );
+    static_assert( Schema::slots.size() >= Schema::size && Schema::slots.size() < 8 * Schema::size );
+
+    Fixed context;
+    context = Context("DFPATH", "anton-test.1");
+    context = Context("LID", "FIINDEX:LUATTRUU");
+    assert( (*context).size() == 2 && (*context).overflow() == 0 );
+    assert( context("LID")->get() == "FIINDEX:LUATTRUU" );
+    assert( context("LID"_akey)->get() == "FIINDEX:LUATTRUU" );
+    assert( context("HOST") == std::nullopt );
+    assert( *(*context).slot<Schema::index("DFPATH"_akey)>() == "anton-test.1" && !(*context).slot<2>() );
+
+    // Names out of the schema go to the overflow, keeping the lookup contract
+    context = Context("EXTRA", "value");
+    context = Context("LID", "FIINDEX:OTHER");
+    assert( (*context).size() == 3 && (*context).overflow() == 1 );
+    assert( context("EXTRA")->get() == "value" && context("LID")->get() == "FIINDEX:OTHER" );
+
+    // Iteration visits schema slots in schema order, then the overflow
+    std::string names;
+    for (const auto &[key, value] : *context)
+    {
+        names += std::string_view(key);
+        names += ';';
+    }
+    assert( names == "LID;DFPATH;EXTRA;" );
+
+    assert( context.erase("DFPATH") && context.erase("EXTRA") && !context.erase("HOST") );
+    assert( (*context).size() == 1 && context("LID") && !context("EXTRA") );
+
+    // Reservation covers the overflow for entries beyond set schema slots
+    attr::SchemaMap<std::string, ContextKeys> map;
+    map["LID"_akey] = "FIINDEX:LUATTRUU";
+    map.reserve(4);
+    const size_t reserved = map.capacity();
+    assert( reserved >= Schema::size + 3 );
+    map["EXTRA"_akey] = "value";
+    map["OTHER"_akey] = "value";
+    map["MORE"_akey] = "value";
+    assert( map.overflow() == 3 && map.capacity() == reserved );
+
+    // Collections, serialization and formatting work on schema storage
+    using Coll = attr::Collection<attr::Single<tag::service_t, true>, Fixed>;
+
+    Coll coll;
+    coll << Service("pisvc") << Context("LID", "FIINDEX:LUATTRUU") << Context("HOST", "localhost");
+    assert( coll(tag::context, "HOST")->get() == "localhost" );
+
+    Coll copy {coll};
+    Coll merged;
+    merged << Service("integsvc") << Context("EXTRA", "value");
+    merged.merge(std::move(copy));
+    assert( merged(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" && merged(tag::context, "EXTRA")->get() == "value" );
+
+    const std::string encoded = attr::encode(coll);
+    auto view = attr::CollectionView<attr::Single<tag::service_t, true>, Fixed>::parse(encoded);
+    assert( view && view->collection()(tag::context, "LID")->get() == "FIINDEX:LUATTRUU" );
+
+    char buffer[128];
+    const auto formatted = attr::format(std::begin(buffer), std::end(buffer), coll);
+    assert( std::string_view(buffer, formatted.ptr - buffer) == "service=pisvc context.LID=FIINDEX:LUATTRUU context.HOST=localhost" );
+
+    // Schema slots own no heap memory beyond their values
+    assert( (*coll.holder<Fixed>()).capacity() == Schema::size );
+    assert( coll.memory_usage().heap_bytes == attr::HeapSize<std::string>::bytes(coll(tag::context, "LID")->get()) );
 }
 
 
@@ -72,5 +2095,33 @@ void test_attribute()
 int main()
 {
     porter::test_attribute();
+    porter::test_flat_storage();
+    porter::test_allocator();
+    porter::test_symbols();
+    porter::test_keys();
+    porter::test_packed();
+    porter::test_layout();
+    porter::test_concat();
+    porter::test_serialize();
+    porter::test_format();
+    porter::test_scope();
+    porter::test_layered();
+    porter::test_published();
+    porter::test_batch();
+    porter::test_filter();
+    porter::test_query();
+    porter::test_any();
+    porter::test_merge();
+    porter::test_interned();
+    porter::test_fingerprint();
+    porter::test_delta();
+    porter::test_store();
+    porter::test_aggregate();
+    porter::test_async();
+    porter::test_lazy();
+    porter::test_constexpr();
+    porter::test_instrument();
+    porter::test_memory();
+    porter::test_schema();
     return 0;
 }